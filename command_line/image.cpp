@@ -29,12 +29,13 @@
 #include "layout/graphlayout.h"
 #include "layout/graphlayoutworker.h"
 
-#include "ui/bandagegraphicsscene.h"
 #include "ui/bandagegraphicsview.h"
+#include "ui/graphrenderer.h"
+#include "ui/imageexport.h"
 
+#include <memory>
 #include <vector>
 #include <QPainter>
-#include <QSvgGenerator>
 
 #include <CLI/CLI.hpp>
 
@@ -42,16 +43,19 @@ CLI::App *addImageSubcommand(CLI::App &app, ImageCmd &cmd) {
     auto *image = app.add_subcommand("image", "Generate an image file of a graph");
     image->add_option("<graph>", cmd.m_graph, "A graph file of any type supported by Bandage")
             ->required()->check(CLI::ExistingFile);
-    image->add_option("<output_file>", cmd.m_image, "The image file to be created (must end in '.jpg', '.png' or '.svg')")
+    image->add_option("<output_file>", cmd.m_image, "The image file to be created (must end in '.jpg', '.png', '.svg' or '.svgz')")
             ->required();
+    // PNG images larger than QImage limits are rendered in tiles
     image->add_option("--height", cmd.m_height, "Image height")
-            ->default_val(cmd.m_height)->check(CLI::Range(1, 32767));
+            ->default_val(cmd.m_height)->check(CLI::Range(1, 1 << 20));
     image->add_option("--width", cmd.m_width, "Image width")
-            ->check(CLI::Range(1, 32767));
+            ->check(CLI::Range(1, 1 << 20));
     image->add_option("--color", cmd.m_color, "csv file with 2 columns: first the node name second the node color")
             ->check(CLI::ExistingFile);
 
-    image->footer("If only height or width is set, the other will be determined automatically. If both are set, the image will be exactly that size");
+    image->footer("If only height or width is set, the other will be determined automatically. If both are set, the image will be exactly that size. "
+                  "JPEG images can not be taller or wider than 32767 pixels, PNG images can not be wider than " +
+                  std::to_string(image::maxTiledPngWidth) + " pixels");
 
     return image;
 }
@@ -65,10 +69,10 @@ int handleImageCmd(QApplication *app,
     QTextStream err(stderr);
     if (imageFileExtension == ".png" || imageFileExtension == ".jpg")
         pixelImage = true;
-    else if (imageFileExtension == ".svg")
+    else if (imageFileExtension == ".svg" || imageFileExtension == ".svgz")
         pixelImage = false;
     else {
-        outputText("Bandage-NG error: the output filename must end in .png, .jpg or .svg", &err);
+        outputText("Bandage-NG error: the output filename must end in .png, .jpg, .svg or .svgz", &err);
         return 1;
     }
 
@@ -142,17 +146,18 @@ int handleImageCmd(QApplication *app,
 
 
     g_assemblyGraph->markNodesToDraw(scope, startingNodes);
-    BandageGraphicsScene scene;
+    // The graph is drawn directly, without building a graphics scene
+    std::unique_ptr<GraphRenderer> renderer;
     {
         GraphLayoutStorage layout =
                 GraphLayoutWorker(g_settings->graphLayoutQuality,
                                   g_settings->linearLayout,
                                   g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
 
-        scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
-        scene.setSceneRectangle();
+        renderer = std::make_unique<GraphRenderer>(*g_assemblyGraph, layout);
     }
-    double sceneRectAspectRatio = scene.sceneRect().width() / scene.sceneRect().height();
+    QRectF sceneRect = renderer->sceneRect();
+    double sceneRectAspectRatio = sceneRect.width() / sceneRect.height();
 
     // Determine image size
     // If neither height nor width set, use a default of height = 1000.
@@ -166,28 +171,42 @@ int handleImageCmd(QApplication *app,
     else if (height == 0 && width > 0)
         height = width / sceneRectAspectRatio;
 
+    // Large images are rendered and written in tiles, this is only possible for PNG
+    bool largeImage = width > image::maxImageSide || height > image::maxImageSide;
+    if (largeImage && imageFileExtension == ".jpg") {
+        outputText("Bandage-NG error: JPEG images can not be taller or wider than 32767 pixels, use PNG or SVG instead", &err);
+        return 1;
+    }
+    if (largeImage && imageFileExtension == ".png" && width > unsigned(image::maxTiledPngWidth)) {
+        outputText("Bandage-NG error: PNG images can not be wider than " + QString::number(image::maxTiledPngWidth) +
+                   " pixels, use SVG instead", &err);
+        return 1;
+    }
+
     bool success = true;
-    QPainter painter;
-    if (pixelImage) {
+    // Large PNG images are rendered in tiles concurrently, SVG is streamed to the file
+    auto renderScene = [&renderer](QPainter &painter, const QRectF &target, const QRectF &source) {
+        renderer->render(painter, target, source);
+    };
+
+    if (largeImage && imageFileExtension == ".png") {
+        success = image::saveTiledPng(QString::fromStdString(cmd.m_image.generic_string()),
+                                      QSize(width, height), sceneRect, renderScene, true);
+    } else if (pixelImage) {
+        // Tiles are painted with their own transforms, which could shift
+        // antialiasing slightly, so images that fit are rendered in one go
         QImage image(width, height, QImage::Format_ARGB32);
         image.fill(Qt::white);
-        painter.begin(&image);
+        QPainter painter(&image);
         painter.setRenderHint(QPainter::Antialiasing);
         painter.setRenderHint(QPainter::TextAntialiasing);
-        scene.render(&painter);
-        success = image.save(QString::fromStdString(cmd.m_image.generic_string()));
+        renderScene(painter, QRectF(image.rect()), image::sourceRect(sceneRect, image.size(), image.rect()));
         painter.end();
+        success = image.save(QString::fromStdString(cmd.m_image.generic_string()));
     } else { //SVG
-        QSvgGenerator generator;
-        generator.setFileName(QString::fromStdString(cmd.m_image.generic_string()));
-        generator.setSize(QSize(width, height));
-        generator.setViewBox(QRect(0, 0, width, height));
-        painter.begin(&generator);
-        painter.fillRect(0, 0, width, height, Qt::white);
-        painter.setRenderHint(QPainter::Antialiasing);
-        painter.setRenderHint(QPainter::TextAntialiasing);
-        scene.render(&painter);
-        painter.end();
+        success = image::saveSvg(QString::fromStdString(cmd.m_image.generic_string()),
+                                 QSize(width, height), sceneRect, renderScene,
+                                 imageFileExtension == ".svgz");
     }
 
     if (!success) {
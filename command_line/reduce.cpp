@@ -89,7 +89,7 @@ int handleReduceCmd(QApplication *app,
 
     g_assemblyGraph->markNodesToDraw(scope, startingNodes);
 
-    if (!gfa::saveVisibleGraph(outputFilename, *g_assemblyGraph)) {
+    if (!gfa::saveVisibleGraph(outputFilename, *g_assemblyGraph, true)) {
         err << "Bandage was unable to save the graph file." << Qt::endl;
         return 1;
     }
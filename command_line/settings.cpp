@@ -281,6 +281,15 @@ static CLI::App *addGraphLayoutSettings(CLI::App &app) {
     add_setting(*layout, "--iter", g_settings->graphLayoutQuality, "Graph layout iterations");
     layout->add_flag("--linear", g_settings->linearLayout, "Linear graph layout")
             ->capture_default_str();
+    layout->add_flag("--coarsen", g_settings->coarsenLayout,
+                     "Collapse non-branching chains and short dead-end tips before layout (for very large graphs)")
+            ->capture_default_str();
+    add_setting(*layout, "--tiplen", g_settings->coarseTipLength,
+                "Maximum length (in bp) of dead-end tips bundled onto their neighbours in coarsened layout");
+    add_setting(*layout, "--maxsegs", g_settings->maxNodeSegments,
+                "Maximum number of segments per node or chain in coarsened layout");
+    add_setting(*layout, "--seed", g_settings->randomSeed,
+                "Random seed for graph layout and random colours, set to get reproducible images", true);
 
     return layout;
 }
@@ -303,6 +312,10 @@ static CLI::App *addGraphAppearanceSettings(CLI::App &app) {
             ->capture_default_str();
     ga->add_flag("--singlearr", g_settings->arrowheadsInSingleMode, "Show node arrowheads in single mode")
             ->capture_default_str();
+    add_setting(*ga, "--lodnode", g_settings->lodNodeWidth,
+                "Nodes thinner than this many pixels are drawn without outline, annotations and labels", true);
+    add_setting(*ga, "--lodedge", g_settings->lodEdgeLength,
+                "Edges shorter than this many pixels are drawn as straight lines (or skipped if below a quarter of it)", true);
 
     return ga;
 }
@@ -23,7 +23,7 @@
 #include <QPen>
 #include <QPainter>
 
-void SolidView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+void SolidView::drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement, int64_t start,
                            int64_t end) const {
     QPen pen;
     pen.setCapStyle(Qt::FlatCap);
@@ -44,7 +44,7 @@ void SolidView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode
     painter.drawPath(graphicsItemNode.makePartialPath(fractionStart, fractionEnd));
 }
 
-void RainbowBlastHitView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement,
+void RainbowBlastHitView::drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement,
                                      int64_t start, int64_t end) const {
 
     double scaledNodeLength = graphicsItemNode.getNodePathLength() * g_absoluteZoom;
@@ -90,14 +90,14 @@ void RainbowBlastHitView::drawFigure(QPainter &painter, GraphicsItemNode &graphi
     }
 }
 
-void Annotation::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement,
+void Annotation::drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement,
                             const std::set<ViewId> &viewsToShow) const {
     for (auto view_id : viewsToShow) {
         m_views[view_id]->drawFigure(painter, graphicsItemNode, reverseComplement, m_start, m_end);
     }
 }
 
-void Annotation::drawDescription(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement) const {
+void Annotation::drawDescription(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement) const {
     double annotationCenter =
             (graphicsItemNode.indexToFraction(m_start) + graphicsItemNode.indexToFraction(m_end)) / 2;
     auto textPoint = graphicsItemNode.findLocationOnPath(
@@ -109,7 +109,7 @@ void Annotation::drawDescription(QPainter &painter, GraphicsItemNode &graphicsIt
     double shiftLeft = -metrics.boundingRect(qStringText).width() / 2.0;
     textPath.addText(shiftLeft, 0.0, g_settings->labelFont, qStringText);
 
-    GraphicsItemNode::drawTextPathAtLocation(&painter, textPath, textPoint);
+    DrawnNode::drawTextPathAtLocation(&painter, textPath, textPoint);
 }
 
 BedBlockView::BedBlockView(double widthMultiplier, const QColor &color, const std::vector<bed::Block> &blocks)
@@ -120,7 +120,7 @@ BedBlockView::BedBlockView(double widthMultiplier, const QColor &color, const st
     }
 }
 
-void BedBlockView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+void BedBlockView::drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement, int64_t start,
                               int64_t end) const {
     for (const auto &block: m_blocks) {
         block.drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
@@ -27,12 +27,12 @@ using AnnotationGroupId = int;
 using ViewId = int;
 
 class QPainter;
-class GraphicsItemNode;
+class DrawnNode;
 
 class IAnnotationView {
 public:
     virtual void
-    drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+    drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement, int64_t start,
                int64_t end) const = 0;
 
     [[nodiscard]] virtual QString getTypeName() const = 0;
@@ -45,7 +45,7 @@ class SolidView : public IAnnotationView {
 public:
     SolidView(double widthMultiplier, const QColor &color) : m_widthMultiplier(widthMultiplier), m_color(color) {}
 
-    void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+    void drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement, int64_t start,
                     int64_t end) const override;
 
     [[nodiscard]] QString getTypeName() const override {
@@ -62,7 +62,7 @@ public:
     RainbowBlastHitView(double rainbowFractionStart, double rainbowFractionEnd)
             : m_rainbowFractionStart(rainbowFractionStart), m_rainbowFractionEnd(rainbowFractionEnd) {}
 
-    void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+    void drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement, int64_t start,
                     int64_t end) const override;
 
     [[nodiscard]] QString getTypeName() const override {
@@ -80,7 +80,7 @@ public:
     BedThickView(double widthMultiplier, const QColor &color, int64_t mThickStart, int64_t mThickEnd) : SolidView(
             widthMultiplier, color), m_thickStart(mThickStart), m_thickEnd(mThickEnd) {}
 
-    void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t,
+    void drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement, int64_t,
                     int64_t) const override {
         SolidView::drawFigure(painter, graphicsItemNode, reverseComplement, m_thickStart, m_thickEnd);
     }
@@ -99,7 +99,7 @@ class BedBlockView : public IAnnotationView {
 public:
     BedBlockView(double widthMultiplier, const QColor &color, const std::vector<bed::Block> &blocks);
 
-    void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+    void drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement, int64_t start,
                     int64_t end) const override;
 
     [[nodiscard]] QString getTypeName() const override {
@@ -117,10 +117,10 @@ class Annotation {
 public:
     Annotation(int64_t start, int64_t end, std::string text) : m_start(start), m_end(end), m_text(std::move(text)) {}
 
-    void drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement,
+    void drawFigure(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement,
                     const std::set<ViewId> &viewsToShow) const;
 
-    void drawDescription(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement) const;
+    void drawDescription(QPainter &painter, const DrawnNode &graphicsItemNode, bool reverseComplement) const;
 
     void addView(std::unique_ptr<IAnnotationView> view) {
         m_views.emplace_back(std::move(view));
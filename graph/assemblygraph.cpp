@@ -23,6 +23,7 @@
 #include "path.h"
 #include "io.h"
 #include "graphicsitemedge.h"
+#include "graphicsitemlink.h"
 #include "graphicsitemnode.h"
 #include "sequenceutils.h"
 
@@ -35,12 +36,15 @@
 #include "ui/dialogs/myprogressdialog.h"
 #include "ui/bandagegraphicsscene.h"
 
+#include <csv/csv.hpp>
+
 #include <QApplication>
 #include <QFile>
 #include <QList>
 #include <QQueue>
 #include <QRegularExpression>
 #include <QSet>
+#include <QtConcurrent>
 
 #include <algorithm>
 #include <iterator>
@@ -80,6 +84,7 @@ template<typename T> double getValueUsingFractionalIndex(const std::vector<T> &v
 }
 
 void AssemblyGraph::cleanUp() {
+    m_editJournal.clear();
     m_deBruijnGraphPaths.clear();
     m_deBruijnGraphWalks.clear();
 
@@ -96,6 +101,7 @@ void AssemblyGraph::cleanUp() {
             deleted.insert(entry);
         }
         m_deBruijnGraphNodes.clear();
+        m_nodeNameIndex.clear();
     }
 
     {
@@ -110,7 +116,7 @@ void AssemblyGraph::cleanUp() {
     m_edgeTags.clear();
     m_nodeColors.clear();
     m_nodeLabels.clear();
-    m_nodeCSVData.clear();
+    m_csvData.clear();
 
     clearGraphInfo();
 }
@@ -343,109 +349,133 @@ bool AssemblyGraph::loadCSV(const QString &filename, QStringList *columns, QStri
         *errormsg = "Unable to read from specified file.";
         return false;
     }
-    QTextStream in(&inputFile);
-    QString line = in.readLine();
+    QByteArray line = inputFile.readLine();
+    inputFile.close();
 
     // guess at separator; this assumes that any tab in the first line means
     // we have a tab separated file
-    QString sep = "\t";
-    if (line.split(sep).length() == 1) {
-        sep = ",";
-        if (line.split(sep).length() == 1) {
+    char sep = '\t';
+    if (!line.contains(sep)) {
+        sep = ',';
+        if (!line.contains(sep)) {
             *errormsg = "Neither tab nor comma in first line. Please check file format.";
             return false;
         }
     }
 
-    unsigned unmatchedNodes = 0; // keep a counter for lines in file that can't be matched to nodes
-
-    QStringList headers = utils::splitCsv(line, sep);
-    if (headers.size() < 2) {
-        *errormsg = "Not enough CSV headers: at least two required.";
-        return false;
-    }
-    headers.pop_front();
-
-    // Check to see if any of the columns holds colour data.
-    int colourCol = -1;
-    for (size_t i = 0; i < headers.size(); ++i) {
-        QString header = headers[i].toLower();
-        if (header == "colour" || header == "color") {
-            colourCol = i;
-            *coloursLoaded = true;
-            break;
+    csv::CSVFormat format;
+    format.delimiter(sep)
+            .quote('"')
+            .header_row(0)
+            .variable_columns(csv::VariableColumnPolicy::KEEP);
+
+    try {
+        // The file is memory mapped and split into fields on a separate thread
+        csv::CSVReader csvReader(filename.toStdString(), format);
+
+        QStringList headers;
+        for (const auto &name : csvReader.get_col_names())
+            headers << QString::fromStdString(name);
+        if (headers.size() < 2) {
+            *errormsg = "Not enough CSV headers: at least two required.";
+            return false;
+        }
+        headers.pop_front();
+
+        // Check to see if any of the columns holds colour data.
+        int colourCol = -1;
+        for (size_t i = 0; i < headers.size(); ++i) {
+            QString header = headers[i].toLower();
+            if (header == "colour" || header == "color") {
+                colourCol = i;
+                *coloursLoaded = true;
+                break;
+            }
         }
-    }
 
-    *columns = m_csvHeaders = headers;
-    size_t columnCount = headers.size();
+        *columns = headers;
+        m_csvData.setHeaders(std::move(headers));
 
-    QMap<QString, QColor> colourCategories;
-    std::vector<QColor> presetColours = getPresetColours();
-    while (!in.atEnd()) {
-        QApplication::processEvents();
+        unsigned unmatchedNodes = 0; // keep a counter for lines in file that can't be matched to nodes
+        std::vector<DeBruijnNode *> nodes;
+        std::vector<std::string_view> values;
+        for (csv::CSVRow &row : csvReader) {
+            if (row.empty())
+                continue;
 
-        QStringList cols = utils::splitCsv(in.readLine(), sep);
-        QString nodeName(cols[0]);
+            std::string nodeName(row[0].get_sv());
+
+            nodes.clear();
+            // See if this is a path name
+            // Match using unique prefix of path name. This allows us to load segmented SPAdes
+            // scaffold paths (e.g. NODE_1_foo_1) and assign CSV data to all of them
+            for (auto range = m_deBruijnGraphPaths.equal_prefix_range(nodeName);
+                 range.first != range.second; ++range.first) {
+                for (auto *node : (*range.first).nodes()) {
+                    nodes.emplace_back(node);
+                    if (!g_settings->doubleMode)
+                        nodes.emplace_back(node->getReverseComplement());
+                }
+            }
 
-        std::vector<DeBruijnNode *> nodes;
-        // See if this is a path name
-        // Match using unique prefix of path name. This allows us to load segmented SPAdes
-        // scaffold paths (e.g. NODE_1_foo_1) and assign CSV data to all of them
-        for (auto range = m_deBruijnGraphPaths.equal_prefix_range(nodeName.toStdString());
-             range.first != range.second; ++range.first) {
-            for (auto *node : (*range.first).nodes()) {
-                nodes.emplace_back(node);
-                if (!g_settings->doubleMode)
-                    nodes.emplace_back(node->getReverseComplement());
+            // Just node name
+            if (nodes.empty()) {
+                auto nodeIt = m_deBruijnGraphNodes.find(
+                        getNodeNameFromString(QString::fromStdString(nodeName)).toStdString());
+                if (nodeIt != m_deBruijnGraphNodes.end())
+                    nodes.emplace_back(*nodeIt);
             }
-        }
 
-        // Just node name
-        if (nodes.empty()) {
-            auto nodeIt = m_deBruijnGraphNodes.find(getNodeNameFromString(nodeName).toStdString());
-            if (nodeIt != m_deBruijnGraphNodes.end())
-                nodes.emplace_back(*nodeIt);
-        }
+            if (nodes.empty()) {
+                unmatchedNodes += 1;
+                continue;
+            }
 
-        if (nodes.empty()) {
-            unmatchedNodes += 1;
-            continue;
+            // The node name is not stored, values without a header are dropped.
+            values.clear();
+            for (size_t i = 1; i < row.size(); ++i)
+                values.push_back(row[i].get_sv());
+
+            uint32_t rowIdx = m_csvData.addRow(values);
+            for (auto *node: nodes)
+                m_csvData.setNodeRow(node, rowIdx);
         }
 
-        // Get rid of the node name - no need to save that.
-        cols.pop_front();
+        m_csvData.finish();
 
-        // Get rid of any extra data that doesn't have a header.
-        cols.resize(columnCount);
+        if (colourCol != -1)
+            setCustomColoursFromCsv(colourCol);
 
-        for (auto *node: nodes)
-            setCsvData(node, cols);
+        if (unmatchedNodes)
+            *errormsg = "There were " + QString::number(unmatchedNodes) + " unmatched entries in the CSV.";
+    } catch (const std::exception &e) {
+        clearAllCsvData();
+        *errormsg = e.what();
+        return false;
+    }
 
-        // If one of the columns holds colour data, get the colour from that one.
-        // Acceptable colour formats: 6-digit hex colour (e.g. #FFB6C1), an 8-digit hex colour (e.g. #7FD2B48C) or a
-        // standard colour name (e.g. skyblue).
-        // If the colour value is something other than one of these, a colour will be assigned to the value.  That way
-        // categorical names can be used and automatically given colours.
-        if (colourCol == -1 || cols.size() <= colourCol)
-            continue;
+    return true;
+}
 
-        QString colourString = cols[colourCol];
-        QColor colour(colourString);
-        if (!colour.isValid()) {
-            QColor presetColor = presetColours[colourCategories.size() % presetColours.size()];
-            auto colorCat = colourCategories.insert(colourString, presetColor);
-            colour = colorCat.value();
-        }
+// If one of the columns holds colour data, get the colour from that one.
+// Acceptable colour formats: 6-digit hex colour (e.g. #FFB6C1), an 8-digit hex colour (e.g. #7FD2B48C) or a
+// standard colour name (e.g. skyblue).
+// If the colour value is something other than one of these, a colour will be assigned to the value.  That way
+// categorical names can be used and automatically given colours.
+void AssemblyGraph::setCustomColoursFromCsv(size_t colourCol) {
+    const auto &column = m_csvData.column(colourCol);
 
-        for (auto *node: nodes)
-            setCustomColour(node, colour);
+    // Values are in the order of appearance, so are the categories
+    std::vector<QColor> presetColours = getPresetColours();
+    std::vector<QColor> colours(column.colours);
+    size_t categories = 0;
+    for (auto &colour : colours) {
+        if (!colour.isValid())
+            colour = presetColours[categories++ % presetColours.size()];
     }
 
-    if (unmatchedNodes)
-        *errormsg = "There were " + QString::number(unmatchedNodes) + " unmatched entries in the CSV.";
-
-    return true;
+    for (const auto &[node, row] : m_csvData.nodeRows())
+        setCustomColour(node, colours[column.rows[row]]);
 }
 
 
@@ -542,14 +572,42 @@ void AssemblyGraph::markNodesToDraw(const graph::Scope &scope,
                 entry->setAsDrawn();
         }
     } else {
+        //A single breadth-first search from all of the starting nodes at once
+        //draws every node within the scope distance of any of them, touching
+        //each node and edge at most once however many starting nodes there
+        //are. The drawn flag doubles as the visited mark.
+        std::vector<DeBruijnNode *> frontier, next;
         for (auto *node : startingNodes) {
             //If we are in single mode, make sure that each node is positive.
             if (!g_settings->doubleMode && node->isNegativeNode())
                 node = node->getReverseComplement();
 
-            node->setAsDrawn();
             node->setAsSpecial();
-            node->labelNeighbouringNodesAsDrawn(scope.distance());
+            if (node->isNotDrawn()) {
+                node->setAsDrawn();
+                frontier.push_back(node);
+            }
+        }
+
+        for (int depth = 0; depth < scope.distance() && !frontier.empty(); ++depth) {
+            for (auto *node : frontier) {
+                for (auto *edge : node->edges()) {
+                    //In single mode only positive nodes are drawn. The
+                    //neighbours of a negative node are the reverse complements
+                    //of the neighbours of its positive twin, so searching
+                    //over positive nodes only gives the same distances.
+                    DeBruijnNode *otherNode = edge->getOtherNode(node);
+                    if (!g_settings->doubleMode)
+                        otherNode = otherNode->getCanonical();
+                    if (otherNode->isDrawn())
+                        continue;
+
+                    otherNode->setAsDrawn();
+                    next.push_back(otherNode);
+                }
+            }
+            frontier.swap(next);
+            next.clear();
         }
     }
 
@@ -662,23 +720,19 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListPartial(const QString
                                                                    std::vector<QString> *nodesNotInGraph) const {
     std::vector<DeBruijnNode *> result;
 
+    if (!m_nodeNameIndex.isBuilt())
+        m_nodeNameIndex.build(m_deBruijnGraphNodes);
+
     for (const auto &name : nodesList) {
         QString queryName = name.simplified();
         if (queryName.isEmpty())
             continue;
 
-        bool found = false;
-        for (auto &entry : m_deBruijnGraphNodes) {
-            QString nodeName = entry->getName();
-
-            if (nodeName.contains(queryName)) {
-                found = true;
-                result.push_back(entry);
-            }
-        }
-
-        if (!found && nodesNotInGraph)
+        auto nodes = m_nodeNameIndex.find(queryName.toStdString());
+        if (nodes.empty() && nodesNotInGraph)
             nodesNotInGraph->push_back(queryName);
+
+        result.insert(result.end(), nodes.begin(), nodes.end());
     }
 
     return result;
@@ -829,54 +883,252 @@ int AssemblyGraph::getDrawnNodeCount() const {
 
 void AssemblyGraph::deleteNodes(const std::vector<DeBruijnNode *> &nodes)
 {
-    //Build a list of nodes to delete.
-    QSet<DeBruijnNode *> nodesToDelete;
+    //Mark the nodes to delete.
+    phmap::flat_hash_set<DeBruijnNode *> nodesToDelete;
+    nodesToDelete.reserve(2 * nodes.size());
     for (auto *node : nodes) {
         nodesToDelete.insert(node);
         nodesToDelete.insert(node->getReverseComplement());
     }
 
-    //Build a list of edges to delete.
-    std::vector<DeBruijnEdge *> edgesToDelete;
-    for (auto *node : nodesToDelete) {
-        for (auto *edge : node->edges()) {
-            bool alreadyAdded = std::find(edgesToDelete.begin(), edgesToDelete.end(), edge) != edgesToDelete.end();
-            if (!alreadyAdded)
-                edgesToDelete.push_back(edge);
-        }
-    }
+    //Mark all their edges. Reverse complement edges are attached to reverse
+    //complement nodes, so they are included as well.
+    phmap::flat_hash_set<DeBruijnEdge *> edgesToDelete;
+    for (auto *node : nodesToDelete)
+        edgesToDelete.insert(node->edgeBegin(), node->edgeEnd());
 
-    // Remove the edges from the graph,
-    deleteEdges(edgesToDelete);
+    GraphChange change;
+    change.nodes.assign(nodesToDelete.begin(), nodesToDelete.end());
+    change.edges.assign(edgesToDelete.begin(), edgesToDelete.end());
+    detach(change, nodesToDelete, edgesToDelete);
 
-    // Remove the nodes from the graph.
-    for (auto *node : nodesToDelete)
-        m_deBruijnGraphNodes.erase(node->getName().toStdString());
+    //While an edit is journaled, the journal keeps the removed objects alive.
+    if (m_editJournal.recording()) {
+        m_editJournal.record(std::move(change));
+        return;
+    }
 
+    for (auto *edge : edgesToDelete)
+        delete edge;
     for (auto *node : nodesToDelete)
         delete node;
 }
 
 void AssemblyGraph::deleteEdges(const std::vector<DeBruijnEdge *> &edges)
 {
-    //Build a list of edges to delete.
-    QSet<DeBruijnEdge *> edgesToDelete;
+    //Mark the edges to delete.
+    phmap::flat_hash_set<DeBruijnEdge *> edgesToDelete;
+    edgesToDelete.reserve(2 * edges.size());
     for (auto *edge : edges) {
         edgesToDelete.insert(edge);
         edgesToDelete.insert(edge->getReverseComplement());
     }
 
-    //Remove the edges from the graph,
-    for (DeBruijnEdge *edge : edgesToDelete) {
-        DeBruijnNode * startingNode = edge->getStartingNode();
-        DeBruijnNode * endingNode = edge->getEndingNode();
+    GraphChange change;
+    change.edges.assign(edgesToDelete.begin(), edgesToDelete.end());
+    detach(change, {}, edgesToDelete);
 
-        m_deBruijnGraphEdges.erase(edge);
-        startingNode->removeEdge(edge);
-        endingNode->removeEdge(edge);
+    if (m_editJournal.recording()) {
+        m_editJournal.record(std::move(change));
+        return;
+    }
 
+    for (auto *edge : edgesToDelete)
         delete edge;
+}
+
+//Removes the marked edges from the graph. Edge lists of the surviving end
+//nodes are compacted once each; nodes in deadNodes are leaving the graph as
+//well, so their edge lists are left alone.
+void AssemblyGraph::sweepEdges(const phmap::flat_hash_set<DeBruijnEdge *> &edgesToDelete,
+                               const phmap::flat_hash_set<DeBruijnNode *> &deadNodes)
+{
+    phmap::flat_hash_set<DeBruijnNode *> touchedNodes;
+    for (auto *edge : edgesToDelete) {
+        for (auto *node : { edge->getStartingNode(), edge->getEndingNode() }) {
+            if (!deadNodes.contains(node))
+                touchedNodes.insert(node);
+        }
+        m_deBruijnGraphEdges.erase(edge);
+    }
+
+    for (auto *node : touchedNodes)
+        node->removeEdgesIf([&](DeBruijnEdge *edge) { return edgesToDelete.contains(edge); });
+}
+
+//Takes the nodes and edges of the change (given as sets as well) out of the
+//graph and out of the scene, without freeing them. The edge lists of the
+//detached nodes are kept intact, so attach() could put everything back.
+void AssemblyGraph::detach(GraphChange &change,
+                           const phmap::flat_hash_set<DeBruijnNode *> &nodes,
+                           const phmap::flat_hash_set<DeBruijnEdge *> &edges)
+{
+    //Remember where the nodes were drawn.
+    bool drawn = false;
+    change.linePoints.clear();
+    for (size_t i = 0; i < change.nodes.size(); ++i) {
+        const auto *graphicsItemNode = change.nodes[i]->getGraphicsItemNode();
+        if (graphicsItemNode == nullptr)
+            continue;
+
+        change.linePoints.resize(change.nodes.size());
+        change.linePoints[i].assign(graphicsItemNode->m_linePoints.begin(),
+                                    graphicsItemNode->m_linePoints.end());
+        drawn = true;
+    }
+    drawn |= std::any_of(change.edges.begin(), change.edges.end(),
+                         [](const DeBruijnEdge *edge) { return edge->getGraphicsItemEdge() != nullptr; });
+    if (drawn) {
+        BandageGraphicsScene::removeGraphicsItemEdges(change.edges, false);
+        BandageGraphicsScene::removeGraphicsItemNodes(change.nodes, false);
+    }
+
+    sweepEdges(edges, nodes);
+
+    // Remove the nodes from the graph. When a large part of the graph goes
+    // away, a single pass over the map is cheaper than key lookups.
+    if (nodes.size() > m_deBruijnGraphNodes.size() / 8) {
+        for (auto it = m_deBruijnGraphNodes.begin(); it != m_deBruijnGraphNodes.end();) {
+            if (nodes.contains(*it))
+                it = m_deBruijnGraphNodes.erase(it);
+            else
+                ++it;
+        }
+    } else {
+        for (auto *node : nodes)
+            m_deBruijnGraphNodes.erase(node->getName().toStdString());
     }
+    m_nodeNameIndex.clear();
+}
+
+//Puts the detached nodes and edges of the change back into the graph and, if
+//they were drawn before, into the scene. Edges are drawn again whenever both
+//of their nodes are drawn.
+void AssemblyGraph::attach(GraphChange &change, BandageGraphicsScene * scene)
+{
+    phmap::flat_hash_set<const DeBruijnNode *> nodes(change.nodes.begin(), change.nodes.end());
+    for (auto *node : change.nodes)
+        m_deBruijnGraphNodes.emplace(node->getName().toStdString(), node);
+    for (auto *edge : change.edges) {
+        m_deBruijnGraphEdges.insert(edge);
+        for (auto *node : { edge->getStartingNode(), edge->getEndingNode() }) {
+            if (!nodes.contains(node))
+                node->addEdge(edge);
+        }
+    }
+    m_nodeNameIndex.clear();
+
+    if (scene != nullptr) {
+        std::vector<GraphicsItemNode *> graphicsItemNodes;
+        for (size_t i = 0; i < change.linePoints.size(); ++i) {
+            if (change.linePoints[i].empty())
+                continue;
+
+            // Node widths are recalculated afterwards
+            DeBruijnNode *node = change.nodes[i];
+            auto *graphicsItemNode = new GraphicsItemNode(node, 0, change.linePoints[i]);
+            node->setGraphicsItemNode(graphicsItemNode);
+            node->setAsDrawn();
+            graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
+            graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+            scene->addItem(graphicsItemNode);
+            graphicsItemNodes.push_back(graphicsItemNode);
+        }
+
+        // Colour once both nodes of a pair are back, so their colours match
+        for (auto *graphicsItemNode : graphicsItemNodes) {
+            DeBruijnNode *rcNode = graphicsItemNode->m_deBruijnNode->getReverseComplement();
+            BandageGraphicsScene::colourGraphicsItemNode(graphicsItemNode, rcNode->hasGraphicsItem());
+        }
+
+        // Edges come back if they are drawn between the items of their nodes
+        // (or, in single mode, of the reverse complements), whether or not
+        // the nodes were part of the change
+        auto hasItem = [](const DeBruijnNode *node) {
+            return node->hasGraphicsItem() ||
+                   (!g_settings->doubleMode && node->getReverseComplement()->hasGraphicsItem());
+        };
+        for (auto *edge : change.edges) {
+            if (edge->getGraphicsItemEdge() != nullptr ||
+                !hasItem(edge->getStartingNode()) || !hasItem(edge->getEndingNode()) ||
+                !edge->determineIfDrawn())
+                continue;
+
+            auto *graphicsItemEdge = edge->getOverlapType() == EdgeOverlapType::EXTRA_LINK ?
+                                     new GraphicsItemLink(edge, *this) :
+                                     new GraphicsItemEdge(edge, *this);
+            graphicsItemEdge->setZValue(-1.0);
+            edge->setGraphicsItemEdge(graphicsItemEdge);
+            graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
+            scene->addItem(graphicsItemEdge);
+        }
+    }
+    change.linePoints.clear();
+}
+
+void AssemblyGraph::apply(EditStep &step, bool forward, BandageGraphicsScene * scene)
+{
+    if (auto *change = std::get_if<GraphChange>(&step)) {
+        if (change->added == forward) {
+            attach(*change, scene);
+        } else {
+            phmap::flat_hash_set<DeBruijnNode *> nodes(change->nodes.begin(), change->nodes.end());
+            phmap::flat_hash_set<DeBruijnEdge *> edges(change->edges.begin(), change->edges.end());
+            detach(*change, nodes, edges);
+        }
+    } else if (auto *rename = std::get_if<NodeRename>(&step)) {
+        if (forward)
+            changeNodeName(rename->oldName, rename->newName);
+        else
+            changeNodeName(rename->newName, rename->oldName);
+    } else if (auto *colourChange = std::get_if<NodeColourChange>(&step)) {
+        QColor colour = forward ? colourChange->newColour : colourChange->oldColour;
+        if (colour.isValid())
+            m_nodeColors[colourChange->node] = colour;
+        else
+            m_nodeColors.erase(colourChange->node);
+    } else if (auto *depthChange = std::get_if<NodeDepthChange>(&step)) {
+        depthChange->node->setDepth(forward ? depthChange->newDepth : depthChange->oldDepth);
+    }
+}
+
+bool AssemblyGraph::undo(BandageGraphicsScene * scene)
+{
+    if (!m_editJournal.canUndo() || m_editJournal.recording())
+        return false;
+
+    auto &steps = m_editJournal.nextUndo().steps;
+    for (auto it = steps.rbegin(); it != steps.rend(); ++it)
+        apply(*it, false, scene);
+    m_editJournal.undone();
+
+    return true;
+}
+
+bool AssemblyGraph::redo(BandageGraphicsScene * scene)
+{
+    if (!m_editJournal.canRedo() || m_editJournal.recording())
+        return false;
+
+    for (auto &step : m_editJournal.nextRedo().steps)
+        apply(step, true, scene);
+    m_editJournal.redone();
+
+    return true;
+}
+
+//The change adding the given (new) nodes together with all their edges.
+static GraphChange addedNodes(std::initializer_list<DeBruijnNode *> nodes) {
+    GraphChange change;
+    change.added = true;
+    change.nodes.assign(nodes.begin(), nodes.end());
+
+    phmap::flat_hash_set<DeBruijnEdge *> edges;
+    for (auto *node : nodes)
+        edges.insert(node->edgeBegin(), node->edgeEnd());
+    change.edges.assign(edges.begin(), edges.end());
+
+    return change;
 }
 
 //This function assumes it is receiving a positive node.  It will duplicate both
@@ -904,11 +1156,12 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, BandageGraphicsScene
     setCustomColour(newNegNode, getCustomColour(originalNegNode));
     setCustomLabel(newPosNode, getCustomLabel(originalPosNode));
     setCustomLabel(newNegNode, getCustomLabel(originalNegNode));
-    setCsvData(newPosNode, getAllCsvData(originalPosNode));
-    setCsvData(newNegNode, getAllCsvData(originalNegNode));
+    copyCsvData(originalPosNode, newPosNode);
+    copyCsvData(originalNegNode, newNegNode);
 
     m_deBruijnGraphNodes.emplace(newPosNodeName.toStdString(), newPosNode);
     m_deBruijnGraphNodes.emplace(newNegNodeName.toStdString(), newNegNode);
+    m_nodeNameIndex.clear();
 
     std::vector<DeBruijnEdge *> leavingEdges = originalPosNode->getLeavingEdges();
     for (auto *edge : leavingEdges) {
@@ -924,6 +1177,12 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, BandageGraphicsScene
                            edge->getOverlap(), edge->getOverlapType());
     }
 
+    if (m_editJournal.recording()) {
+        m_editJournal.record(addedNodes({ newPosNode, newNegNode }));
+        m_editJournal.record(NodeDepthChange{ originalPosNode, originalPosNode->getDepth(), newDepth });
+        m_editJournal.record(NodeDepthChange{ originalNegNode, originalNegNode->getDepth(), newDepth });
+    }
+
     originalPosNode->setDepth(newDepth);
     originalNegNode->setDepth(newDepth);
 
@@ -948,25 +1207,75 @@ QString AssemblyGraph::getNewNodeName(QString oldNodeName) const
     return newNodeName;
 }
 
-static bool canAddNodeToStartOfMergeList(const DeBruijnNode *firstNode,
-                                         const DeBruijnNode *potentialNode) {
-    std::vector<DeBruijnEdge *> edgesEnteringFirstNode = firstNode->getEnteringEdges();
-    std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
-    return (edgesEnteringFirstNode.size() == 1 &&
-            edgesLeavingPotentialNode.size() == 1 &&
-            edgesEnteringFirstNode[0]->getStartingNode() == potentialNode &&
-            edgesLeavingPotentialNode[0]->getEndingNode() == firstNode);
+//Returns the only edge leaving (or entering) the node, or nullptr if there are
+//none or several of them.
+static DeBruijnEdge *uniqueEdge(const DeBruijnNode *node, bool leaving) {
+    DeBruijnEdge *res = nullptr;
+    for (auto *edge : node->edges()) {
+        if ((leaving ? edge->getStartingNode() : edge->getEndingNode()) != node)
+            continue;
+        if (res)
+            return nullptr;
+        res = edge;
+    }
+
+    return res;
+}
+
+//Sorts the nodes into merge order: a simple, unbranching path where each node
+//may also be used in its reverse complement orientation. Returns an empty list
+//if the nodes do not form such a path.
+static std::vector<DeBruijnNode *> orderNodesForMerge(const QList<DeBruijnNode *> &nodes) {
+    phmap::flat_hash_set<const DeBruijnNode *> remaining(nodes.begin(), nodes.end());
+    auto take = [&](const DeBruijnNode *node) {
+        return remaining.erase(node) || remaining.erase(node->getReverseComplement());
+    };
+
+    std::deque<DeBruijnNode *> mergeList{nodes.front()};
+    take(nodes.front());
+
+    while (auto *edge = uniqueEdge(mergeList.back(), true)) {
+        DeBruijnNode *next = edge->getEndingNode();
+        if (uniqueEdge(next, false) != edge || !take(next))
+            break;
+        mergeList.push_back(next);
+    }
+
+    while (auto *edge = uniqueEdge(mergeList.front(), false)) {
+        DeBruijnNode *prev = edge->getStartingNode();
+        if (uniqueEdge(prev, true) != edge || !take(prev))
+            break;
+        mergeList.push_front(prev);
+    }
+
+    //If there are still nodes left, then they don't form a nice simple path
+    //and the merge won't work.
+    if (!remaining.empty())
+        return {};
+
+    return { mergeList.begin(), mergeList.end() };
+}
+
+namespace {
+//An ordered chain of nodes to merge together with the sequences of the
+//resulting node pair.
+struct NodeMerge {
+    std::vector<DeBruijnNode *> nodes;
+    std::vector<DeBruijnNode *> revCompNodes;
+    Sequence posSequence;
+    Sequence negSequence;
+};
 }
 
+//Builds the merged sequences. This only reads the graph, so it can be run for
+//many (disjoint) merges concurrently.
+static void buildMergedSequences(NodeMerge &merge) {
+    merge.revCompNodes.reserve(merge.nodes.size());
+    for (auto it = merge.nodes.rbegin(); it != merge.nodes.rend(); ++it)
+        merge.revCompNodes.push_back((*it)->getReverseComplement());
 
-static bool canAddNodeToEndOfMergeList(const DeBruijnNode *lastNode,
-                                       const DeBruijnNode *potentialNode) {
-    std::vector<DeBruijnEdge *> edgesLeavingLastNode = lastNode->getLeavingEdges();
-    std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
-    return (edgesLeavingLastNode.size() == 1 &&
-            edgesEnteringPotentialNode.size() == 1 &&
-            edgesLeavingLastNode[0]->getEndingNode() == potentialNode &&
-            edgesEnteringPotentialNode[0]->getStartingNode() == lastNode);
+    merge.posSequence = Path::makeFromOrderedNodes(merge.nodes, false).getSequence();
+    merge.negSequence = Path::makeFromOrderedNodes(merge.revCompNodes, false).getSequence();
 }
 
 static void mergeGraphicsNodes(const std::vector<DeBruijnNode *> &originalNodes,
@@ -982,72 +1291,30 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, BandageGraphicsScene
     if (nodes.empty())
         return true;
 
-    //We now need to sort the nodes into merge order.
-    std::deque<DeBruijnNode *> mergeList;
-    mergeList.push_back(nodes[0]);
-    nodes.pop_front();
-
-    bool addedNode;
-    do {
-        addedNode = false;
-        for (int i = 0; i < nodes.size(); ++i) {
-            DeBruijnNode * potentialNextNode = nodes[i];
-
-            //Check if the node can be added to the end of the list.
-            if (canAddNodeToEndOfMergeList(mergeList.back(), potentialNextNode)) {
-                mergeList.push_back(potentialNextNode);
-                nodes.removeAt(i);
-                addedNode = true;
-                break;
-            }
-
-            //Check if the node can be added to the front of the list.
-            if (canAddNodeToStartOfMergeList(mergeList.front(), potentialNextNode)) {
-                mergeList.push_front(potentialNextNode);
-                nodes.removeAt(i);
-                addedNode = true;
-                break;
-            }
-
-            //If neither of those worked, then we should try the node's reverse
-            //complement.
-            DeBruijnNode * potentialNextNodeRevComp = potentialNextNode->getReverseComplement();
-            if (canAddNodeToEndOfMergeList(mergeList.back(), potentialNextNodeRevComp)) {
-                mergeList.push_back(potentialNextNodeRevComp);
-                nodes.removeAt(i);
-                addedNode = true;
-                break;
-            }
-            if (canAddNodeToStartOfMergeList(mergeList.front(), potentialNextNodeRevComp)) {
-                mergeList.push_front(potentialNextNodeRevComp);
-                nodes.removeAt(i);
-                addedNode = true;
-                break;
-            }
-        }
-
-        if (nodes.empty())
-            break;
-    } while (addedNode);
-
-    //If there are still nodes left in the first list, then they don't form a
-    //nice simple path and the merge won't work.
-    if (!nodes.empty())
+    NodeMerge merge;
+    merge.nodes = orderNodesForMerge(nodes);
+    if (merge.nodes.empty())
         return false;
 
-    std::vector<DeBruijnNode*> orderedList(mergeList.begin(), mergeList.end());
-    Path posPath = Path::makeFromOrderedNodes(orderedList, false);
-    Sequence mergedNodePosSequence{posPath.getPathSequence()};
+    buildMergedSequences(merge);
+    commitMerge(merge.nodes, merge.revCompNodes,
+                merge.posSequence, merge.negSequence, scene);
 
-    std::vector<DeBruijnNode*> revCompOrderedList;
-    for (auto it = orderedList.rbegin(); it != orderedList.rend(); ++it)
-        revCompOrderedList.push_back((*it)->getReverseComplement());
+    recalculateAllNodeWidths(g_settings->averageNodeWidth,
+                             g_settings->depthPower, g_settings->depthEffectOnWidth);
 
-    Path negPath = Path::makeFromOrderedNodes(revCompOrderedList, false);
-    Sequence mergedNodeNegSequence{negPath.getPathSequence()};
+    return true;
+}
 
+//Replaces the ordered chain of nodes (and their reverse complements) with a
+//single merged node pair having the given sequences.
+void AssemblyGraph::commitMerge(const std::vector<DeBruijnNode *> &orderedList,
+                                const std::vector<DeBruijnNode *> &revCompOrderedList,
+                                const Sequence &mergedNodePosSequence,
+                                const Sequence &mergedNodeNegSequence,
+                                BandageGraphicsScene * scene) {
     QString newNodeBaseName;
-    for (int i = 0; i < orderedList.size(); ++i) {
+    for (size_t i = 0; i < orderedList.size(); ++i) {
         newNodeBaseName += orderedList[i]->getNameWithoutSign();
         if (i < orderedList.size() - 1)
             newNodeBaseName += "_";
@@ -1066,6 +1333,7 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, BandageGraphicsScene
 
     m_deBruijnGraphNodes.emplace(newPosNodeName.toStdString(), newPosNode);
     m_deBruijnGraphNodes.emplace(newNegNodeName.toStdString(), newNegNode);
+    m_nodeNameIndex.clear();
 
     for (auto *leavingEdge : orderedList.back()->getLeavingEdges())
         createDeBruijnEdge(newPosNodeName, leavingEdge->getEndingNode()->getName(), leavingEdge->getOverlap(),
@@ -1075,15 +1343,13 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, BandageGraphicsScene
         createDeBruijnEdge(enteringEdge->getStartingNode()->getName(), newPosNodeName, enteringEdge->getOverlap(),
                            enteringEdge->getOverlapType());
 
+    if (m_editJournal.recording())
+        m_editJournal.record(addedNodes({ newPosNode, newNegNode }));
+
     mergeGraphicsNodes(orderedList, revCompOrderedList, newPosNode,
                        *this, scene);
 
     deleteNodes(orderedList);
-
-    recalculateAllNodeWidths(g_settings->averageNodeWidth,
-                             g_settings->depthPower, g_settings->depthEffectOnWidth);
-
-    return true;
 }
 
 
@@ -1159,8 +1425,6 @@ static void mergeGraphicsNodes(const std::vector<DeBruijnNode *> &originalNodes,
         if (revCompSuccess)
             newRevComp->setAsDrawn();
     }
-
-    BandageGraphicsScene::removeGraphicsItemNodes(originalNodes, true);
 }
 
 //This function simplifies the graph by merging all possible nodes in a simple
@@ -1170,92 +1434,67 @@ static void mergeGraphicsNodes(const std::vector<DeBruijnNode *> &originalNodes,
 int AssemblyGraph::mergeAllPossible(BandageGraphicsScene * scene,
                                     MyProgressDialog * progressDialog)
 {
-    //Create a set of all nodes.
-    QSet<DeBruijnNode *> uncheckedNodes;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        uncheckedNodes.insert(entry);
-    }
-
-    //Create a list of all merges to be done.
-    QList< QList<DeBruijnNode *> > allMerges;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
+    //Find the longest possible mergeable chains in a single pass over the
+    //graph. A node is claimed together with its reverse complement, so every
+    //node ends up in at most one chain.
+    phmap::flat_hash_set<const DeBruijnNode *> checkedNodes;
+    checkedNodes.reserve(m_deBruijnGraphNodes.size());
+    auto check = [&](const DeBruijnNode *node) {
+        checkedNodes.insert(node);
+        checkedNodes.insert(node->getReverseComplement());
+    };
+
+    std::vector<NodeMerge> allMerges;
+    for (auto *node : m_deBruijnGraphNodes) {
+        if (checkedNodes.contains(node))
+            continue;
 
-        //If the current node isn't checked, then we will find the longest
-        //possible mergable sequence containing this node.
-        if (uncheckedNodes.contains(node))
-        {
-            QList<DeBruijnNode *> nodesToMerge;
-            nodesToMerge.push_back(node);
+        std::deque<DeBruijnNode *> nodesToMerge{node};
+        check(node);
 
-            uncheckedNodes.remove(node);
-            uncheckedNodes.remove(node->getReverseComplement());
+        //Extend forward as much as possible.
+        while (auto *edge = uniqueEdge(nodesToMerge.back(), true)) {
+            DeBruijnNode *next = edge->getEndingNode();
+            if (checkedNodes.contains(next) || uniqueEdge(next, false) != edge)
+                break;
 
-            //Extend forward as much as possible.
-            bool extended;
-            do
-            {
-                extended = false;
-                DeBruijnNode * last = nodesToMerge.back();
-                std::vector<DeBruijnEdge *> outgoingEdges = last->getLeavingEdges();
-                if (outgoingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = outgoingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getEndingNode();
-                    std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
-                    if (edgesEnteringPotentialNode.size() == 1 &&
-                            edgesEnteringPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_back(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+            nodesToMerge.push_back(next);
+            check(next);
+        }
 
-            //Extend backward as much as possible.
-            do
-            {
-                extended = false;
-                DeBruijnNode * first = nodesToMerge.front();
-                std::vector<DeBruijnEdge *> incomingEdges = first->getEnteringEdges();
-                if (incomingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = incomingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getStartingNode();
-                    std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
-                    if (edgesLeavingPotentialNode.size() == 1 &&
-                            edgesLeavingPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_front(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+        //Extend backward as much as possible.
+        while (auto *edge = uniqueEdge(nodesToMerge.front(), false)) {
+            DeBruijnNode *prev = edge->getStartingNode();
+            if (checkedNodes.contains(prev) || uniqueEdge(prev, true) != edge)
+                break;
 
-            if (nodesToMerge.size() > 1)
-                allMerges.push_back(nodesToMerge);
+            nodesToMerge.push_front(prev);
+            check(prev);
         }
+
+        if (nodesToMerge.size() > 1)
+            allMerges.emplace_back().nodes.assign(nodesToMerge.begin(), nodesToMerge.end());
     }
 
+    //The chains are disjoint, so their merged sequences can be built
+    //concurrently.
+    QtConcurrent::blockingMap(allMerges, buildMergedSequences);
+
     //Now do the actual merges.
     QApplication::processEvents();
     emit setMergeTotalCount(allMerges.size());
-    for (int i = 0; i < allMerges.size(); ++i)
+    for (size_t i = 0; i < allMerges.size(); ++i)
     {
         if (progressDialog != nullptr && progressDialog->wasCancelled())
             break;
 
-        mergeNodes(allMerges[i], scene);
-        emit setMergeCompletedCount(i+1);
-        QApplication::processEvents();
+        auto &merge = allMerges[i];
+        commitMerge(merge.nodes, merge.revCompNodes,
+                    merge.posSequence, merge.negSequence, scene);
+        if ((i + 1) % 256 == 0 || i + 1 == allMerges.size()) {
+            emit setMergeCompletedCount(i + 1);
+            QApplication::processEvents();
+        }
     }
 
     recalculateAllNodeWidths(g_settings->averageNodeWidth,
@@ -1294,6 +1533,10 @@ AssemblyGraph::EdgeStyle AssemblyGraph::getCustomStyle(const DeBruijnEdge* edge)
 }
 
 void AssemblyGraph::setCustomColour(const DeBruijnNode* node, QColor color) {
+    if (m_editJournal.recording()) {
+        auto it = m_nodeColors.find(node);
+        m_editJournal.record(NodeColourChange{ node, it == m_nodeColors.end() ? QColor() : it->second, color });
+    }
     m_nodeColors[node] = color;
 }
 
@@ -1339,37 +1582,33 @@ void AssemblyGraph::setCustomLabel(const DeBruijnNode* node, QString newLabel) {
 }
 
 void AssemblyGraph::clearAllCsvData() {
-    m_csvHeaders.clear();
-    for (auto &entry : m_deBruijnGraphNodes) {
-        clearCsvData(entry);
-    }
+    m_csvData.clear();
 }
 
 bool AssemblyGraph::hasCsvData(const DeBruijnNode* node) const {
-    auto it = m_nodeCSVData.find(node);
-    return it != m_nodeCSVData.end() && !it->second.isEmpty();
+    return m_csvData.nodeRow(node).has_value();
 }
 
 QStringList AssemblyGraph::getAllCsvData(const DeBruijnNode *node) const {
-    auto it = m_nodeCSVData.find(node);
-    return it == m_nodeCSVData.end() ? QStringList() : it->second;
+    QStringList data;
+    if (auto row = m_csvData.nodeRow(node)) {
+        for (size_t i = 0; i < m_csvData.columnCount(); ++i)
+            data << m_csvData.value(*row, i);
+    }
+
+    return data;
 }
 
 std::optional<QString> AssemblyGraph::getCsvLine(const DeBruijnNode *node, int i) const {
-    auto it = m_nodeCSVData.find(node);
-    if (it == m_nodeCSVData.end() ||
-        i >= it->second.length())
+    auto row = m_csvData.nodeRow(node);
+    if (!row || i < 0 || size_t(i) >= m_csvData.columnCount())
         return "";
 
-    return it->second[i];
-}
-
-void AssemblyGraph::setCsvData(const DeBruijnNode* node, QStringList csvData) {
-    m_nodeCSVData[node] = std::move(csvData);
+    return m_csvData.value(*row, i);
 }
 
-void AssemblyGraph::clearCsvData(const DeBruijnNode* node) {
-    m_nodeCSVData[node].clear();
+void AssemblyGraph::copyCsvData(const DeBruijnNode *from, const DeBruijnNode *to) {
+    m_csvData.setNodeRow(to, m_csvData.nodeRow(from));
 }
 
 //This function changes the name of a node pair.  The new and old names are
@@ -1401,6 +1640,9 @@ void AssemblyGraph::changeNodeName(const QString& oldName, const QString& newNam
 
     m_deBruijnGraphNodes.emplace(posNewNodeName.toStdString(), posNode);
     m_deBruijnGraphNodes.emplace(negNewNodeName.toStdString(), negNode);
+    m_nodeNameIndex.clear();
+
+    m_editJournal.record(NodeRename{ oldName, newName });
 }
 
 
@@ -1436,8 +1678,10 @@ void AssemblyGraph::changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
         return;
 
     for (auto node : nodes) {
-        node->setDepth(newDepth);
-        node->getReverseComplement()->setDepth(newDepth);
+        for (auto *strand : { node, node->getReverseComplement() }) {
+            m_editJournal.record(NodeDepthChange{ strand, strand->getDepth(), newDepth });
+            strand->setDepth(newDepth);
+        }
     }
 
     //If this graph does not already have a depthTag, give it a depthTag of KC
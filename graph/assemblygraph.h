@@ -24,6 +24,9 @@
 #include "path.h"
 #include "annotation.h"
 #include "graphscope.h"
+#include "nodenameindex.h"
+#include "editjournal.h"
+#include "csvdata.h"
 
 #include "io/gfa.h"
 
@@ -87,8 +90,7 @@ public:
     phmap::parallel_flat_hash_map<const DeBruijnEdge*, QColor> m_edgeColors;
 
     // CSV data
-    phmap::parallel_flat_hash_map<const DeBruijnNode*, QStringList> m_nodeCSVData;
-    QStringList m_csvHeaders;
+    CsvData m_csvData;
     // Tags
     phmap::parallel_flat_hash_map<const DeBruijnNode*, std::vector<gfa::tag>> m_nodeTags;
     phmap::parallel_flat_hash_map<const DeBruijnEdge*, std::vector<gfa::tag>> m_edgeTags;
@@ -162,6 +164,16 @@ public:
     void changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
                          double newDepth);
 
+    // Edits made between beginEdit() and endEdit() are journaled and could be
+    // undone, once the undo limit is set. Undo and redo update the items of
+    // the given scene, if any.
+    void setUndoLimit(size_t limit) { m_editJournal.setLimit(limit); }
+    void beginEdit(const QString &description) { m_editJournal.begin(description); }
+    void endEdit() { m_editJournal.end(); }
+    const EditJournal &editJournal() const { return m_editJournal; }
+    bool undo(BandageGraphicsScene * scene = nullptr);
+    bool redo(BandageGraphicsScene * scene = nullptr);
+
     unsigned int getDeadEndCount() const;
     void getNodeStats(int * n50, int * shortestNode, int * firstQuartile, int * median, int * thirdQuartile, int * longestNode) const;
     void getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const;
@@ -191,8 +203,7 @@ public:
     bool hasCsvData(const DeBruijnNode* node) const;
     QStringList getAllCsvData(const DeBruijnNode *node) const;
     std::optional<QString> getCsvLine(const DeBruijnNode *node, int i) const;
-    void setCsvData(const DeBruijnNode* node, QStringList csvData);
-    void clearCsvData(const DeBruijnNode* node);
+    void copyCsvData(const DeBruijnNode *from, const DeBruijnNode *to);
 
     QColor getCustomColourForDisplay(const DeBruijnNode *node) const;
     QStringList getCustomLabelForDisplay(const DeBruijnNode *node) const;
@@ -206,7 +217,26 @@ private:
     std::vector<DeBruijnNode *> getNodesFromListPartial(const QStringList& nodesList, std::vector<QString> * nodesNotInGraph) const;
     std::vector<int> makeOverlapCountVector();
     void clearAllCsvData();
+    void setCustomColoursFromCsv(size_t colourCol);
     QString getNewNodeName(QString oldNodeName) const;
+    void commitMerge(const std::vector<DeBruijnNode *> &orderedList,
+                     const std::vector<DeBruijnNode *> &revCompOrderedList,
+                     const Sequence &mergedNodePosSequence,
+                     const Sequence &mergedNodeNegSequence,
+                     BandageGraphicsScene * scene);
+    void sweepEdges(const phmap::flat_hash_set<DeBruijnEdge *> &edgesToDelete,
+                    const phmap::flat_hash_set<DeBruijnNode *> &deadNodes);
+    void detach(GraphChange &change,
+                const phmap::flat_hash_set<DeBruijnNode *> &nodes,
+                const phmap::flat_hash_set<DeBruijnEdge *> &edges);
+    void attach(GraphChange &change, BandageGraphicsScene * scene);
+    void apply(EditStep &step, bool forward, BandageGraphicsScene * scene);
+
+    EditJournal m_editJournal;
+
+    // Built on first partial name search, dropped whenever nodes are added,
+    // removed or renamed
+    mutable NodeNameIndex m_nodeNameIndex;
 
 signals:
     void setMergeTotalCount(int totalCount);
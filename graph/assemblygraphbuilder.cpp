@@ -145,6 +145,16 @@ static ssize_t gzgetline(char **buf, size_t *bufsiz, gzFile fp) {
 }
 
 
+//Reads all records of a FASTA file, packing the sequences directly.
+static bool readFastaSequences(const QString &fileName,
+                               std::vector<QString> &names, std::vector<Sequence> &sequences) {
+    return utils::readFastxFile(fileName,
+                                [&](std::string_view name, std::string_view sequence) {
+                                    names.push_back(QString::fromUtf8(name.data(), qsizetype(name.size())));
+                                    sequences.emplace_back(sequence);
+                                });
+}
+
 static std::string getOppositeNodeName(std::string nodeName) {
     return (nodeName.back() == '-' ?
             nodeName.substr(0, nodeName.size() - 1) + '+' :
@@ -181,8 +191,8 @@ static bool attemptToLoadSequencesFromFasta(AssemblyGraph &graph) {
 
     bool atLeastOneNodeSequenceLoaded = false;
     std::vector<QString> names;
-    std::vector<QByteArray> sequences;
-    utils::readFastaFile(fastaName, names, sequences);
+    std::vector<Sequence> sequences;
+    readFastaSequences(fastaName, names, sequences);
 
     for (size_t i = 0; i < names.size(); ++i) {
         QString name = names[i];
@@ -192,7 +202,7 @@ static bool attemptToLoadSequencesFromFasta(AssemblyGraph &graph) {
         if (nodeIt != graph.m_deBruijnGraphNodes.end()) {
             DeBruijnNode *posNode = *nodeIt;
             if (posNode->sequenceIsMissing()) {
-                Sequence sequence{sequences[i]};
+                const Sequence &sequence = sequences[i];
                 atLeastOneNodeSequenceLoaded = true;
                 posNode->setSequence(sequence);
                 DeBruijnNode *negNode = graph.m_deBruijnGraphNodes.at((name + "-").toStdString());
@@ -729,15 +739,15 @@ namespace io {
             graph.m_depthTag = "";
 
             std::vector<QString> names;
-            std::vector<QByteArray> sequences;
-            utils::readFastaFile(fileName_, names, sequences);
+            std::vector<Sequence> sequences;
+            readFastaSequences(fileName_, names, sequences);
 
             std::vector<QString> circularNodeNames;
             for (size_t i = 0; i < names.size(); ++i) {
                 QString name = names[i];
                 QString lowerName = name.toLower();
                 double depth = 1.0;
-                Sequence sequence{sequences[i]};
+                const Sequence &sequence = sequences[i];
 
                 // Check to see if the node name matches the Velvet/SPAdes contig
                 // format.  If so, we can get the depth and node number.
@@ -1090,15 +1100,15 @@ namespace io {
             graph.m_depthTag = "";
 
             std::vector<QString> names;
-            std::vector<QByteArray> sequences;
-            utils::readFastaFile(fileName_, names, sequences);
+            std::vector<Sequence> sequences;
+            readFastaSequences(fileName_, names, sequences);
 
             std::vector<QString> edgeStartingNodeNames;
             std::vector<QString> edgeEndingNodeNames;
 
             for (size_t i = 0; i < names.size(); ++i) {
                 QString name = names[i];
-                Sequence sequence{sequences[i]};
+                const Sequence &sequence = sequences[i];
 
                 //The header can come in a few different formats:
                 // TR1|c0_g1_i1 len=280 path=[274:0-228 275:229-279] [-1, 274, 275, -2]
@@ -0,0 +1,420 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "contiguity.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+// A path may pass through a node at most twice: a path that would visit a
+// node a third time is dropped. So the outcome of following a path from a
+// node depends on the steps remaining and on the visits of the path nodes
+// that could still be reached in those steps, but not on the rest of the
+// path. The searches below are memoised on exactly that state. Away from
+// repeat loops shorter than the step limit it is just (node, steps
+// remaining), so the work grows with the number of such states rather than
+// with the number of paths. Paths through overlapping short loops leave
+// different nodes to revisit, though, so there the states are as many as
+// the paths and the worst case stays exponential.
+
+namespace {
+// Sorted set of nodes. These are the nodes shared by all the paths out of a
+// state, so there are never more of them than there are steps.
+using NodeSet = std::vector<const DeBruijnNode *>;
+
+const DeBruijnNode *canonical(const DeBruijnNode *node) {
+    return node->isPositiveNode() ? node : node->getReverseComplement();
+}
+
+bool isCancelled(const std::atomic<bool> *cancelled) {
+    return cancelled && cancelled->load(std::memory_order_relaxed);
+}
+
+//This function only upgrades a node's status, never downgrades.
+void upgrade(ContiguityStatuses &statuses,
+             const DeBruijnNode *node, ContiguityStatus newStatus) {
+    auto &status = statuses[node];
+    if (newStatus > status)
+        status = newStatus;
+}
+
+// Calls fn on the next nodes in the direction of the search and returns
+// whether there were any.
+template<class Fn>
+bool forEachNext(const DeBruijnNode *node, bool forward, Fn &&fn) {
+    bool any = false;
+    auto visit = [&](const DeBruijnNode *next) {
+        fn(next);
+        any = true;
+    };
+    if (forward) {
+        for (const auto *next : node->downstreamNodes())
+            visit(next);
+    } else {
+        for (const auto *next : node->upstreamNodes())
+            visit(next);
+    }
+
+    return any;
+}
+
+void intersect(NodeSet &set, const NodeSet &other) {
+    NodeSet common;
+    std::set_intersection(set.begin(), set.end(), other.begin(), other.end(),
+                          std::back_inserter(common));
+    set = std::move(common);
+}
+
+void insert(NodeSet &set, const DeBruijnNode *node) {
+    auto it = std::lower_bound(set.begin(), set.end(), node);
+    if (it == set.end() || *it != node)
+        set.insert(it, node);
+}
+
+// Number of steps needed to get from a node to each of the nodes around it.
+// The search from a node only goes as far as it has been asked to so far.
+class Distances {
+public:
+    using Map = phmap::flat_hash_map<const DeBruijnNode *, unsigned>;
+
+    explicit Distances(bool forward) : m_forward(forward) {}
+
+    // All the nodes at most the given number of steps away, and possibly
+    // more. The node itself is only included if it is on a loop.
+    const Map &from(const DeBruijnNode *node, unsigned steps) {
+        auto [it, inserted] = m_reached.try_emplace(node);
+        Reached &reached = it->second;
+        if (inserted)
+            reached.layer.push_back(node);
+
+        std::vector<const DeBruijnNode *> nextLayer;
+        for (; reached.steps < steps && !reached.layer.empty(); ++reached.steps) {
+            for (const auto *layerNode : reached.layer)
+                forEachNext(layerNode, m_forward, [&](const DeBruijnNode *next) {
+                    if (reached.distances.try_emplace(next, reached.steps + 1).second)
+                        nextLayer.push_back(next);
+                });
+            reached.layer.swap(nextLayer);
+            nextLayer.clear();
+        }
+
+        return reached.distances;
+    }
+
+private:
+    struct Reached {
+        Map distances;
+        // The nodes furthest away, to continue the search from
+        std::vector<const DeBruijnNode *> layer;
+        unsigned steps = 0;
+    };
+
+    bool m_forward;
+    // Node-based, so the maps stay put while others are added
+    phmap::node_hash_map<const DeBruijnNode *, Reached> m_reached;
+};
+
+// Node reached by a path with the given number of steps remaining, along
+// with the path nodes that it could visit again in those steps. These are
+// sorted and listed twice if the path already passed through them twice.
+struct State {
+    const DeBruijnNode *node;
+    unsigned steps;
+    std::vector<const DeBruijnNode *> revisitable;
+
+    bool operator==(const State &other) const {
+        return node == other.node && steps == other.steps &&
+               revisitable == other.revisitable;
+    }
+};
+
+struct StateHash {
+    size_t operator()(const State &state) const {
+        size_t hash = phmap::HashState::combine(0, state.node, state.steps);
+        for (const auto *node : state.revisitable)
+            hash = phmap::HashState::combine(hash, node);
+        return hash;
+    }
+};
+
+// The path followed so far
+class Path {
+public:
+    void push(const DeBruijnNode *node) { m_nodes.push_back(node); }
+    void pop() { m_nodes.pop_back(); }
+
+    [[nodiscard]] bool canVisit(const DeBruijnNode *node) const {
+        return std::count(m_nodes.begin(), m_nodes.end(), node) < 2;
+    }
+
+    // The state of the path after arriving at node
+    [[nodiscard]] State state(const DeBruijnNode *node, unsigned steps,
+                              Distances &distances) const {
+        State state{node, steps, {}};
+        if (steps == 0)
+            return state;
+
+        const Distances::Map &reachable = distances.from(node, steps);
+        for (const auto *pathNode : m_nodes) {
+            auto it = reachable.find(pathNode);
+            if (it != reachable.end() && it->second <= steps)
+                state.revisitable.push_back(pathNode);
+        }
+        std::sort(state.revisitable.begin(), state.revisitable.end());
+
+        return state;
+    }
+
+private:
+    std::vector<const DeBruijnNode *> m_nodes;
+};
+
+// All paths leaving the starting node through one of its edges. A path ends
+// when it runs out of steps, reaches a dead end or is about to return to the
+// starting node.
+class PathSearch {
+public:
+    struct Result {
+        // Whether any path out of the state ends without being dropped
+        bool found = false;
+        // Nodes in all those paths, and the same for the canonical nodes,
+        // i.e. including reverse complements
+        NodeSet common, commonCanonical;
+
+        void add(const Result &other) {
+            if (!other.found)
+                return;
+
+            if (!found) {
+                *this = other;
+                return;
+            }
+
+            intersect(common, other.common);
+            intersect(commonCanonical, other.commonCanonical);
+        }
+    };
+
+    PathSearch(const DeBruijnNode *start, bool forward, Distances &distances,
+               const std::atomic<bool> *cancelled)
+            : m_start(start), m_forward(forward), m_distances(distances),
+              m_cancelled(cancelled) {}
+
+    // Returns false if the search was cancelled
+    bool run(const DeBruijnNode *first, unsigned steps) {
+        m_path.push(first);
+        m_result = &visit(first, steps - 1);
+        m_path.pop();
+
+        return !isCancelled(m_cancelled);
+    }
+
+    [[nodiscard]] const Result &result() const { return *m_result; }
+
+    // Every state that some complete path passes through
+    template<class Fn>
+    void forEachFound(Fn &&fn) const {
+        for (const auto &[state, result] : m_memo) {
+            if (result.found)
+                fn(state.node);
+        }
+    }
+
+private:
+    // Path arriving at node with the given number of steps remaining
+    const Result &visit(const DeBruijnNode *node, unsigned steps) {
+        State state = m_path.state(node, steps, m_distances);
+        auto it = m_memo.find(state);
+        if (it != m_memo.end())
+            return it->second;
+
+        Result result;
+        if (steps == 0) {
+            result.found = true;
+        } else if (!isCancelled(m_cancelled)) {
+            const Result ended{true, {}, {}};
+            bool any = forEachNext(node, m_forward, [&](const DeBruijnNode *next) {
+                if (next == m_start) {
+                    result.add(ended);
+                } else if (m_path.canVisit(next)) {
+                    m_path.push(next);
+                    result.add(visit(next, steps - 1));
+                    m_path.pop();
+                }
+            });
+            if (!any)
+                result.found = true;
+        }
+
+        if (result.found) {
+            insert(result.common, node);
+            insert(result.commonCanonical, canonical(node));
+        }
+
+        // The recursion only adds states with fewer steps remaining
+        return m_memo.emplace(std::move(state), std::move(result)).first->second;
+    }
+
+    const DeBruijnNode *m_start;
+    bool m_forward;
+    Distances &m_distances;
+    const std::atomic<bool> *m_cancelled;
+    Path m_path;
+    const Result *m_result = nullptr;
+    // Node-based, so the results stay put while others are added
+    phmap::node_hash_map<State, Result, StateHash> m_memo;
+};
+
+// Checks whether all paths out of a node unambiguously lead to the target.
+// Paths that would visit a node a third time are ignored.
+class LeadsOnlyTo {
+public:
+    LeadsOnlyTo(const DeBruijnNode *source, const DeBruijnNode *target,
+                bool forward, bool includeReverseComplement, Distances &distances)
+            : m_source(source), m_target(target),
+              m_forward(forward), m_includeReverseComplement(includeReverseComplement),
+              m_distances(distances) {
+        m_path.push(source);
+    }
+
+    // Path arriving at node with the given number of steps remaining,
+    // counting the step to the node
+    bool operator()(const DeBruijnNode *node, unsigned steps) {
+        //If the path has landed on the node from which the search began,
+        //it could represent circular DNA that does not contain the target.
+        if (node == m_source)
+            return false;
+        if (node == m_target ||
+            (m_includeReverseComplement && node->getReverseComplement() == m_target))
+            return true;
+        if (steps <= 1)
+            return false;
+
+        m_path.push(node);
+        State state = m_path.state(node, steps - 1, m_distances);
+        auto it = m_memo.find(state);
+        if (it == m_memo.end()) {
+            bool leads = true;
+            bool any = forEachNext(node, m_forward, [&](const DeBruijnNode *next) {
+                leads = leads && (!m_path.canVisit(next) || (*this)(next, steps - 1));
+            });
+            it = m_memo.emplace(std::move(state), any && leads).first;
+        }
+        m_path.pop();
+
+        return it->second;
+    }
+
+private:
+    const DeBruijnNode *m_source, *m_target;
+    bool m_forward, m_includeReverseComplement;
+    Distances &m_distances;
+    Path m_path;
+    phmap::flat_hash_map<State, bool, StateHash> m_memo;
+};
+
+// Whether the node has a way out that unambiguously leads to the target. If
+// includeReverseComplement is true, then it is enough for all paths to lead
+// either to the target or to its reverse complement.
+bool doesPathLeadOnlyToNode(const DeBruijnNode *node, const DeBruijnNode *target,
+                            bool includeReverseComplement, unsigned steps,
+                            Distances &leavingDistances, Distances &enteringDistances) {
+    LeadsOnlyTo leavingPaths(node, target, true, includeReverseComplement, leavingDistances),
+                enteringPaths(node, target, false, includeReverseComplement, enteringDistances);
+    for (auto *edge : node->edges()) {
+        bool outgoingEdge = node == edge->getStartingNode();
+        if (outgoingEdge ? leavingPaths(edge->getEndingNode(), steps) :
+                           enteringPaths(edge->getStartingNode(), steps))
+            return true;
+    }
+
+    return false;
+}
+}
+
+namespace contiguity {
+// This function determines the contiguity of nodes relative to the starting one.
+// It has two steps:
+// -First, for each edge of the starting node, all paths outward are followed.
+//  Any nodes in any path are MAYBE_CONTIGUOUS, and nodes in all of the
+//  paths are CONTIGUOUS.
+// -Second, it is necessary to check in the opposite direction - for each
+//  of the MAYBE_CONTIGUOUS nodes, do they have a path that unambiguously
+//  leads to the starting node?  If so, then they are CONTIGUOUS.
+bool determine(const DeBruijnNode *startingNode, unsigned steps,
+               ContiguityStatuses &statuses,
+               const std::atomic<bool> *cancelled) {
+    upgrade(statuses, startingNode, STARTING);
+    if (steps == 0)
+        return true;
+
+    Distances leavingDistances(true), enteringDistances(false);
+    phmap::flat_hash_set<const DeBruijnNode *> checkedNodes;
+    for (auto *edge : startingNode->edges()) {
+        bool outgoingEdge = startingNode == edge->getStartingNode();
+
+        PathSearch search(startingNode, outgoingEdge,
+                          outgoingEdge ? leavingDistances : enteringDistances, cancelled);
+        if (!search.run(outgoingEdge ? edge->getEndingNode() : edge->getStartingNode(), steps))
+            return false;
+
+        search.forEachFound([&](const DeBruijnNode *node) {
+            upgrade(statuses, node, MAYBE_CONTIGUOUS);
+            checkedNodes.insert(node);
+        });
+
+        const auto &paths = search.result();
+        for (auto *node : paths.common)
+            upgrade(statuses, node, CONTIGUOUS_STRAND_SPECIFIC);
+        for (auto *node : paths.commonCanonical) {
+            upgrade(statuses, node, CONTIGUOUS_EITHER_STRAND);
+            upgrade(statuses, node->getReverseComplement(), CONTIGUOUS_EITHER_STRAND);
+        }
+    }
+
+    for (auto *node : checkedNodes) {
+        if (isCancelled(cancelled))
+            return false;
+
+        ContiguityStatus status = statuses[node];
+
+        //First check without reverse complement target for
+        //strand-specific contiguity.
+        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
+            doesPathLeadOnlyToNode(node, startingNode, false, steps,
+                                   leavingDistances, enteringDistances))
+            upgrade(statuses, node, CONTIGUOUS_STRAND_SPECIFIC);
+
+        //Now check including the reverse complement target for
+        //either strand contiguity.
+        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
+            status != CONTIGUOUS_EITHER_STRAND &&
+            doesPathLeadOnlyToNode(node, startingNode, true, steps,
+                                   leavingDistances, enteringDistances)) {
+            upgrade(statuses, node, CONTIGUOUS_EITHER_STRAND);
+            upgrade(statuses, node->getReverseComplement(), CONTIGUOUS_EITHER_STRAND);
+        }
+    }
+
+    return true;
+}
+}
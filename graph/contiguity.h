@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <unordered_map>
+
+class DeBruijnNode;
+
 enum ContiguityStatus : unsigned {
     NOT_CONTIGUOUS = 0,
     MAYBE_CONTIGUOUS,
@@ -24,3 +29,21 @@ enum ContiguityStatus : unsigned {
     CONTIGUOUS_STRAND_SPECIFIC,
     STARTING
 };
+
+using ContiguityStatuses = std::unordered_map<const DeBruijnNode *, ContiguityStatus>;
+
+namespace contiguity {
+    // Determines the contiguity of the nodes around startingNode, looking at
+    // most the given number of steps away. Statuses are only ever upgraded,
+    // so the results for several starting nodes accumulate. Paths are
+    // followed once per (node, steps remaining) state rather than one by
+    // one, which takes polynomial time where there are no loops shorter
+    // than the steps. Around such loops, states also record the path nodes
+    // that could be visited again. Where many short loops overlap, the
+    // number of states, and so the run time, is exponential in the steps,
+    // as with following every path. Returns false if it was cancelled,
+    // leaving the statuses incomplete.
+    bool determine(const DeBruijnNode *startingNode, unsigned steps,
+                   ContiguityStatuses &statuses,
+                   const std::atomic<bool> *cancelled = nullptr);
+}
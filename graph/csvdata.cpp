@@ -0,0 +1,105 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "csvdata.h"
+
+#include <QtConcurrent>
+
+#include <limits>
+
+void CsvData::clear() {
+    m_headers.clear();
+    m_columns.clear();
+    m_valueIndices.clear();
+    m_nodeRows.clear();
+}
+
+void CsvData::setHeaders(QStringList headers) {
+    clear();
+    m_headers = std::move(headers);
+    m_columns.resize(m_headers.size());
+    m_valueIndices.resize(m_headers.size());
+}
+
+uint32_t CsvData::addRow(const std::vector<std::string_view> &values) {
+    uint32_t row = m_columns.empty() ? 0 : uint32_t(m_columns.front().rows.size());
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        Column &column = m_columns[i];
+        auto &index = m_valueIndices[i];
+        std::string_view value = i < values.size() ? values[i] : std::string_view();
+
+        auto it = index.find(value);
+        if (it == index.end()) {
+            it = index.emplace(std::string(value), uint32_t(column.values.size())).first;
+            column.values.push_back(QString::fromUtf8(value.data(), qsizetype(value.size())));
+        }
+
+        column.rows.push_back(it->second);
+    }
+
+    return row;
+}
+
+void CsvData::finish() {
+    m_valueIndices.clear();
+
+    QtConcurrent::blockingMap(m_columns, [](Column &column) {
+        size_t count = column.values.size();
+        column.numbers.resize(count);
+        column.colours.resize(count);
+
+        bool numbers = false, colours = false, text = false;
+        for (size_t i = 0; i < count; ++i) {
+            const QString &value = column.values[i];
+            bool isNumber = false;
+            double number = value.toDouble(&isNumber);
+            column.numbers[i] = isNumber ? number : std::numeric_limits<double>::quiet_NaN();
+            column.colours[i] = QColor(value);
+
+            if (value.isEmpty())
+                continue;
+            if (isNumber)
+                numbers = true;
+            else if (column.colours[i].isValid())
+                colours = true;
+            else
+                text = true;
+        }
+
+        if (numbers && !colours && !text)
+            column.type = ColumnType::NUMBER;
+        else if (colours && !numbers && !text)
+            column.type = ColumnType::COLOUR;
+        else
+            column.type = ColumnType::TEXT;
+    });
+}
+
+void CsvData::setNodeRow(const DeBruijnNode *node, std::optional<uint32_t> row) {
+    if (row)
+        m_nodeRows[node] = *row;
+    else
+        m_nodeRows.erase(node);
+}
+
+std::optional<uint32_t> CsvData::nodeRow(const DeBruijnNode *node) const {
+    auto it = m_nodeRows.find(node);
+    if (it == m_nodeRows.end())
+        return {};
+
+    return it->second;
+}
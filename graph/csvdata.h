@@ -0,0 +1,86 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QColor>
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class DeBruijnNode;
+
+// Node data loaded from a CSV file, stored by column. Every distinct value of
+// a column is stored and parsed (as a number and as a colour) only once, the
+// rows just refer to it. Several nodes could share a row.
+class CsvData {
+public:
+    enum class ColumnType {
+        NUMBER, // All the non-empty values are numbers
+        COLOUR, // All the non-empty values are colours
+        TEXT
+    };
+
+    struct Column {
+        ColumnType type = ColumnType::TEXT;
+        // Distinct values in the order of appearance, parsed as numbers (NaN
+        // if not a number) and as colours (invalid if not a colour)
+        std::vector<QString> values;
+        std::vector<double> numbers;
+        std::vector<QColor> colours;
+        // Index of the value in every row
+        std::vector<uint32_t> rows;
+    };
+
+    void clear();
+
+    void setHeaders(QStringList headers);
+    [[nodiscard]] const QStringList &headers() const { return m_headers; }
+    [[nodiscard]] size_t columnCount() const { return m_columns.size(); }
+    [[nodiscard]] const Column &column(size_t i) const { return m_columns[i]; }
+
+    // Adds a row and returns its index. Missing values are empty, values
+    // without a header are dropped.
+    uint32_t addRow(const std::vector<std::string_view> &values);
+    // Parses the values and determines the column types, once all the rows
+    // were added
+    void finish();
+
+    // Links the node to the row, or unlinks it if there is no row
+    void setNodeRow(const DeBruijnNode *node, std::optional<uint32_t> row);
+    [[nodiscard]] std::optional<uint32_t> nodeRow(const DeBruijnNode *node) const;
+    [[nodiscard]] const auto &nodeRows() const { return m_nodeRows; }
+
+    [[nodiscard]] const QString &value(uint32_t row, size_t column) const {
+        const Column &col = m_columns[column];
+        return col.values[col.rows[row]];
+    }
+
+private:
+    QStringList m_headers;
+    std::vector<Column> m_columns;
+    // Indices of the distinct values, only needed while rows are added
+    std::vector<phmap::flat_hash_map<std::string, uint32_t>> m_valueIndices;
+    phmap::flat_hash_map<const DeBruijnNode *, uint32_t> m_nodeRows;
+};
@@ -20,9 +20,9 @@
 #include "assemblygraph.h"
 
 #include "program/settings.h"
+#include "program/random.h"
 
 #include <cmath>
-#include <QApplication>
 
 DeBruijnEdge::DeBruijnEdge(DeBruijnNode *startingNode, DeBruijnNode *endingNode) :
     m_startingNode(startingNode), m_endingNode(endingNode), m_graphicsItemEdge(nullptr), m_reverseComplement(nullptr),
@@ -90,183 +90,6 @@ bool DeBruijnEdge::isPositiveEdge() const
 }
 
 
-//This function traces all possible paths from this edge.
-//It proceeds a number of steps, as determined by a setting.
-//If forward is true, it looks in a forward direction (starting nodes to
-//ending nodes).  If forward is false, it looks in a backward direction
-//(ending nodes to starting nodes).
-void DeBruijnEdge::tracePaths(bool forward,
-                              int stepsRemaining,
-                              std::vector< std::vector <DeBruijnNode *> > &allPaths,
-                              const DeBruijnNode * startingNode,
-                              std::vector<DeBruijnNode *> pathSoFar) const {
-    //This can go for a while, so keep the UI responsive.
-    QApplication::processEvents();
-
-    //Find the node in the direction we are tracing.
-    DeBruijnNode * nextNode;
-    if (forward)
-        nextNode = m_endingNode;
-    else
-        nextNode = m_startingNode;
-
-    //Add that node to the path so far.
-    pathSoFar.push_back(nextNode);
-
-    //If there are no steps left, then the path so far is done.
-    --stepsRemaining;
-    if (stepsRemaining == 0)
-    {
-        allPaths.push_back(pathSoFar);
-        return;
-    }
-
-    //If the code got here, then more steps remain.
-    //Find the edges that are in the correct direction.
-    std::vector<DeBruijnEdge *> nextEdges = findNextEdgesInPath(nextNode, forward);
-
-    //If there are no next edges, then we are finished with the
-    //path search, even though steps remain.
-    if (nextEdges.empty())
-    {
-        allPaths.push_back(pathSoFar);
-        return;
-    }
-
-    //Call this function on all of the next edges.
-    //However, we also need to check to see if we are tracing a loop
-    //and stop if that is the case.
-    for (auto nextEdge : nextEdges)
-    {
-        //Determine the node that this next edge leads to.
-        DeBruijnNode * nextNextNode;
-        if (forward)
-            nextNextNode = nextEdge->m_endingNode;
-        else
-            nextNextNode = nextEdge->m_startingNode;
-
-        //If that node is the starting node, then we've made
-        //a full loop and the path should be considered complete.
-        if (nextNextNode == startingNode)
-        {
-            allPaths.push_back(pathSoFar);
-            continue;
-        }
-
-        //If that node is already in the path TWICE so far, that means
-        //we're caught in a loop, and we should throw this path out.
-        //If it appears 0 or 1 times, then continue the path search.
-        if (timesNodeInPath(nextNextNode, pathSoFar) < 2)
-            nextEdge->tracePaths(forward, stepsRemaining, allPaths, startingNode, pathSoFar);
-    }
-}
-
-
-// This function counts how many times a node appears in a path
-unsigned DeBruijnEdge::timesNodeInPath(const DeBruijnNode * node, const std::vector<DeBruijnNode *> &path) {
-    unsigned count = 0;
-    for (auto *i : path)
-        count += (i == node);
-
-    return count;
-}
-
-
-
-bool DeBruijnEdge::leadsOnlyToNode(bool forward,
-                                   int stepsRemaining,
-                                   const DeBruijnNode * target,
-                                   std::vector<DeBruijnNode *> pathSoFar,
-                                   bool includeReverseComplement) const
-{
-    //This can go for a while, so keep the UI responsive.
-    QApplication::processEvents();
-
-    //Find the node in the direction we are tracing.
-    DeBruijnNode * nextNode;
-    if (forward)
-        nextNode = m_endingNode;
-    else
-        nextNode = m_startingNode;
-
-    //Add that node to the path so far.
-    pathSoFar.push_back(nextNode);
-
-    //If this path has landed on the node from which the search began,
-    //that means we've followed a loop around.  The search has therefore
-    //failed because this path could represent circular DNA that does
-    //not contain the target.
-    if (nextNode == pathSoFar[0])
-        return false;
-
-    //If the next node is the target, the search succeeded!
-    if (nextNode == target)
-        return true;
-
-    //If we are including reverse complements and the next node is
-    //the reverse complement of the target, the search succeeded!
-    if (includeReverseComplement && nextNode->getReverseComplement() == target)
-        return true;
-
-    //If there are no steps left, then the search failed.
-    --stepsRemaining;
-    if (stepsRemaining == 0)
-        return false;
-
-    //If the code got here, then more steps remain.
-    //Find the edges that are in the correct direction.
-    std::vector<DeBruijnEdge *> nextEdges = findNextEdgesInPath(nextNode, forward);
-
-    //If there are no next edges, then the search failed, even
-    //though steps remain.
-    if (nextEdges.empty())
-        return false;
-
-    //In order for the search to succeed, this function needs to return true
-    //for all of the nextEdges.
-    //However, we also need to check to see if we are tracing a loop
-    //and stop if that is the case.
-    for (auto nextEdge : nextEdges)
-    {
-        //Determine the node that this next edge leads to.
-        DeBruijnNode * nextNextNode;
-        if (forward)
-            nextNextNode = nextEdge->m_endingNode;
-        else
-            nextNextNode = nextEdge->m_startingNode;
-
-        //If that node is already in the path TWICE so far, that means
-        //we're caught in a loop, and we should throw this path out.
-        //If it appears 0 or 1 times, then continue the path search.
-        if (timesNodeInPath(nextNextNode, pathSoFar) < 2)
-        {
-            if (!nextEdge->leadsOnlyToNode(forward, stepsRemaining, target, pathSoFar, includeReverseComplement) )
-                return false;
-        }
-    }
-
-    //If the code got here, then the search succeeded!
-    return true;
-}
-
-
-std::vector<DeBruijnEdge *> DeBruijnEdge::findNextEdgesInPath(DeBruijnNode * nextNode,
-                                                              bool forward)
-{
-    std::vector<DeBruijnEdge *> nextEdges;
-    for (DeBruijnEdge * edge : nextNode->edges()) {
-        //If forward, we're looking for edges that lead away from
-        //nextNode.  If backward, we're looking for edges that lead
-        //into nextNode.
-        if ((forward && edge->m_startingNode == nextNode) ||
-            (!forward && edge->m_endingNode == nextNode))
-            nextEdges.push_back(edge);
-    }
-
-    return nextEdges;
-}
-
-
 //This function tries to automatically determine the overlap size
 //between the two nodes.  It tries each overlap size between the min
 //to the max (in settings), assigning the first one it finds.
@@ -285,7 +108,9 @@ void DeBruijnEdge::autoDetermineExactOverlap()
     //Try each overlap in the range and set the first one found.
     //However, we don't want the search to be biased towards larger
     //or smaller overlaps, so start with a pseudorandom value and loop.
-    int testOverlap = min + (rand() % (max - min + 1));
+    //The value only depends on the seed and node names to be reproducible.
+    uint64_t h = rng::mix(rng::mix(rng::seed(), m_startingNode->getName()), m_endingNode->getName());
+    int testOverlap = min + int(h % uint64_t(max - min + 1));
     for (int i = min; i <= max; ++i)
     {
         if (testExactOverlap(testOverlap))
@@ -60,16 +60,6 @@ public:
     EdgeOverlapType getOverlapType() const {return m_overlapType;}
     DeBruijnNode * getOtherNode(const DeBruijnNode * node) const;
     bool testExactOverlap(int overlap) const;
-    void tracePaths(bool forward,
-                    int stepsRemaining,
-                    std::vector<std::vector<DeBruijnNode *> > &allPaths,
-                    const DeBruijnNode * startingNode,
-                    std::vector<DeBruijnNode *> pathSoFar = {}) const;
-    bool leadsOnlyToNode(bool forward,
-                         int stepsRemaining,
-                         const DeBruijnNode * target,
-                         std::vector<DeBruijnNode *> pathSoFar,
-                         bool includeReverseComplement) const;
     bool isPositiveEdge() const;
     bool isNegativeEdge() const {return !isPositiveEdge();}
     bool isOwnReverseComplement() const {return this == getReverseComplement();}
@@ -87,7 +77,4 @@ public:
 
 private:
     bool edgeIsVisible() const;
-    static unsigned timesNodeInPath(const DeBruijnNode * node, const std::vector<DeBruijnNode *> &path);
-    static std::vector<DeBruijnEdge *> findNextEdgesInPath(DeBruijnNode * nextNode,
-                                                           bool forward) ;
 };
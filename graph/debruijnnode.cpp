@@ -19,6 +19,7 @@
 #include "debruijnnode.h"
 #include "debruijnedge.h"
 #include "assemblygraph.h"
+#include "recordwriter.h"
 #include "sequenceutils.h"
 
 #include "program/settings.h"
@@ -26,6 +27,7 @@
 #include <thirdparty/seq/aa.hpp>
 
 #include <cmath>
+#include <limits>
 
 #include <set>
 #include <string>
@@ -47,6 +49,22 @@ DeBruijnNode::DeBruijnNode(QString name, float depth, const Sequence& sequence,
 }
 
 
+bool DeBruijnNode::IsEnteringEdge::operator()(const DeBruijnEdge *edge) const {
+    return edge->getEndingNode() == node;
+}
+
+bool DeBruijnNode::IsLeavingEdge::operator()(const DeBruijnEdge *edge) const {
+    return edge->getStartingNode() == node;
+}
+
+DeBruijnNode *DeBruijnNode::StartingNode::operator()(const DeBruijnEdge *edge) const {
+    return edge->getStartingNode();
+}
+
+DeBruijnNode *DeBruijnNode::EndingNode::operator()(const DeBruijnEdge *edge) const {
+    return edge->getEndingNode();
+}
+
 //This function adds an edge to the Node, but only if the edge hasn't already
 //been added.
 void DeBruijnNode::addEdge(DeBruijnEdge * edge) {
@@ -71,20 +89,27 @@ void DeBruijnNode::resetNode()
 }
 
 QByteArray DeBruijnNode::getFasta(bool sign, bool newLines, bool evenIfEmpty) const {
-    QByteArray sequence = utils::sequenceToQByteArray(getSequence());
-    if (sequence.isEmpty() && !evenIfEmpty)
-        return {};
+    std::string fasta;
+    appendFasta(fasta, sign, newLines, evenIfEmpty);
+    return QByteArray::fromStdString(fasta);
+}
 
-    QByteArray fasta = ">";
-    fasta += getNodeNameForFasta(sign);
-    fasta += "\n";
-    if (newLines)
-        fasta += utils::addNewlinesToSequence(sequence);
-    else {
-        fasta += sequence;
-        fasta += "\n";
-    }
-    return fasta;
+void DeBruijnNode::appendFasta(std::string &out, bool sign, bool newLines, bool evenIfEmpty) const {
+    const Sequence &sequence = getSequence();
+    if (sequence.empty() && !evenIfEmpty)
+        return;
+
+    out += ">NODE_";
+    utils::appendString(out, m_name, sign ? m_name.length() : std::max<qsizetype>(m_name.length() - 1, 0));
+    out += "_length_";
+    utils::appendNumber(out, int64_t(getLength()));
+    out += "_cov_";
+    utils::appendNumber(out, getDepth());
+    out += '\n';
+
+    utils::FastaLineWrapper lines(out, newLines ? 70 : std::numeric_limits<size_t>::max());
+    lines.append(sequence, 0, sequence.size());
+    lines.finish();
 }
 
 QByteArray DeBruijnNode::getAAFasta(unsigned shift, bool sign, bool newLines, bool evenIfEmpty) const {
@@ -109,11 +134,9 @@ QByteArray DeBruijnNode::getAAFasta(unsigned shift, bool sign, bool newLines, bo
 }
 
 QByteArray DeBruijnNode::getUpstreamSequence(int upstreamSequenceLength) const {
-    std::vector<DeBruijnNode*> upstreamNodes = getUpstreamNodes();
-
     QByteArray bestUpstreamNodeSequence;
 
-    for (auto upstreamNode : upstreamNodes)
+    for (auto upstreamNode : upstreamNodes())
     {
         QByteArray upstreamNodeFullSequence = utils::sequenceToQByteArray(upstreamNode->getSequence());
         QByteArray upstreamNodeSequence;
@@ -146,13 +169,13 @@ QByteArray DeBruijnNode::getUpstreamSequence(int upstreamSequenceLength) const {
 
 unsigned DeBruijnNode::getLengthWithoutTrailingOverlap() const {
     unsigned length = getLength();
-    std::vector<DeBruijnEdge *> leavingEdges = getLeavingEdges();
+    auto leaving = leavingEdges();
 
-    if (leavingEdges.empty())
+    if (leaving.empty())
         return length;
 
     int maxOverlap = 0;
-    for (const auto *leavingEdge : leavingEdges)
+    for (const auto *leavingEdge : leaving)
         maxOverlap = std::max(maxOverlap, leavingEdge->getOverlap());
 
     if (maxOverlap > length)
@@ -178,33 +201,6 @@ QByteArray DeBruijnNode::getNodeNameForFasta(bool sign) const
 }
 
 
-// This function recursively labels all nodes as drawn that are within a
-// certain distance of this node.  Whichever node called this will
-// definitely be drawn, so that one is excluded from the recursive call.
-// FIXME: this function does not belong here
-void DeBruijnNode::labelNeighbouringNodesAsDrawn(int nodeDistance) {
-    std::unordered_set<DeBruijnNode*> worklist, seen;
-    worklist.insert(this);
-    for (int depth = 0; depth <= nodeDistance; depth++) {
-        for (auto *node : worklist) {
-            auto *nodeToMark =
-                        g_settings->doubleMode ? node : node->getCanonical();
-            nodeToMark->m_drawn = true;
-
-            for (auto *m_edge : node->m_edges) {
-                DeBruijnNode * otherNode = m_edge->getOtherNode(node);
-                if (!otherNode->thisNodeOrReverseComplementIsDrawn())
-                    seen.insert(otherNode);
-            }
-        }
-
-        if (seen.empty())
-            break;
-        worklist.clear();
-        worklist.swap(seen);
-    }
-}
-
 bool DeBruijnNode::isPositiveNode() const
 {
     QChar lastChar = m_name.at(m_name.length() - 1);
@@ -256,48 +252,28 @@ bool DeBruijnNode::isNodeConnected(DeBruijnNode * node) const {
 
 std::vector<DeBruijnEdge *> DeBruijnNode::getEnteringEdges() const
 {
-    std::vector<DeBruijnEdge *> returnVector;
-    for (auto *edge : m_edges) {
-        if (this == edge->getEndingNode())
-            returnVector.push_back(edge);
-    }
-    return returnVector;
+    auto entering = enteringEdges();
+    return {entering.begin(), entering.end()};
 }
 std::vector<DeBruijnEdge *> DeBruijnNode::getLeavingEdges() const
 {
-    std::vector<DeBruijnEdge *> returnVector;
-    for (auto *edge : m_edges) {
-        if (this == edge->getStartingNode())
-            returnVector.push_back(edge);
-    }
-    return returnVector;
+    auto leaving = leavingEdges();
+    return {leaving.begin(), leaving.end()};
 }
 
 
 
 std::vector<DeBruijnNode *> DeBruijnNode::getDownstreamNodes() const
 {
-    std::vector<DeBruijnEdge *> leavingEdges = getLeavingEdges();
-
-    std::vector<DeBruijnNode *> returnVector;
-    returnVector.reserve(leavingEdges.size());
-    for (auto *leavingEdge : leavingEdges)
-        returnVector.push_back(leavingEdge->getEndingNode());
-
-    return returnVector;
+    auto downstream = downstreamNodes();
+    return {downstream.begin(), downstream.end()};
 }
 
 
 std::vector<DeBruijnNode *> DeBruijnNode::getUpstreamNodes() const
 {
-    std::vector<DeBruijnEdge *> enteringEdges = getEnteringEdges();
-
-    std::vector<DeBruijnNode *> returnVector;
-    returnVector.reserve(enteringEdges.size());
-    for (auto *enteringEdge : enteringEdges)
-        returnVector.push_back(enteringEdge->getStartingNode());
-
-    return returnVector;
+    auto upstream = upstreamNodes();
+    return {upstream.begin(), upstream.end()};
 }
 
 bool DeBruijnNode::isInDepthRange(double min, double max) const
@@ -344,10 +320,7 @@ int DeBruijnNode::getDeadEndCount() const
     if (m_edges.empty())
         return 2;
 
-    std::vector<DeBruijnEdge *> enteringEdges = getEnteringEdges();
-    std::vector<DeBruijnEdge *> leavingEdges = getLeavingEdges();
-
-    if (!enteringEdges.empty() && !leavingEdges.empty())
+    if (!enteringEdges().empty() && !leavingEdges().empty())
         return 0;
     else
         return 1;
@@ -17,12 +17,15 @@
 
 #pragma once
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/iterator_range.h"
 #include "seq/sequence.hpp"
 #include "small_vector/small_pod_vector.hpp"
 
 #include <QColor>
 #include <QByteArray>
+#include <algorithm>
+#include <string>
 #include <vector>
 
 class DeBruijnEdge;
@@ -51,6 +54,8 @@ public:
     unsigned getLengthWithoutTrailingOverlap() const;
 
     QByteArray getFasta(bool sign, bool newLines = true, bool evenIfEmpty = true) const;
+    // Same as getFasta(), but appends the record to out
+    void appendFasta(std::string &out, bool sign, bool newLines = true, bool evenIfEmpty = true) const;
     QByteArray getAAFasta(unsigned shift, bool sign, bool newLines, bool evenIfEmpty) const;
 
     char getBaseAt(int i) const {if (i >= 0 && i < m_sequence.size()) return m_sequence[i]; else return '\0';} // NOTE
@@ -67,6 +72,28 @@ public:
     auto edges() { return llvm::make_range(edgeBegin(), edgeEnd()); }
     const auto edges() const { return llvm::make_range(edgeBegin(), edgeEnd()); }
 
+    //Lazy views over the edges of the node, nothing is allocated. The edge
+    //predicates are defined in debruijnnode.cpp, so this header does not
+    //need DeBruijnEdge to be complete.
+    struct IsEnteringEdge {
+        const DeBruijnNode *node;
+        bool operator()(const DeBruijnEdge *edge) const;
+    };
+    struct IsLeavingEdge {
+        const DeBruijnNode *node;
+        bool operator()(const DeBruijnEdge *edge) const;
+    };
+    struct StartingNode {
+        DeBruijnNode *operator()(const DeBruijnEdge *edge) const;
+    };
+    struct EndingNode {
+        DeBruijnNode *operator()(const DeBruijnEdge *edge) const;
+    };
+    auto enteringEdges() const { return llvm::make_filter_range(edges(), IsEnteringEdge{this}); }
+    auto leavingEdges() const { return llvm::make_filter_range(edges(), IsLeavingEdge{this}); }
+    auto upstreamNodes() const { return llvm::map_range(enteringEdges(), StartingNode()); }
+    auto downstreamNodes() const { return llvm::map_range(leavingEdges(), EndingNode()); }
+
     std::vector<DeBruijnEdge *> getEnteringEdges() const;
     std::vector<DeBruijnEdge *> getLeavingEdges() const;
     std::vector<DeBruijnNode *> getDownstreamNodes() const;
@@ -98,7 +125,11 @@ public:
     void resetNode();
     void addEdge(DeBruijnEdge * edge);
     void removeEdge(DeBruijnEdge * edge);
-    void labelNeighbouringNodesAsDrawn(int nodeDistance);
+    // Removes all edges matching pred in a single pass
+    template<class Pred>
+    void removeEdgesIf(Pred pred) {
+        m_edges.erase(std::remove_if(m_edges.begin(), m_edges.end(), pred), m_edges.end());
+    }
     void setDepth(double newDepth) {m_depth = newDepth;}
     void setName(QString newName) {m_name = std::move(newName);}
 
@@ -0,0 +1,99 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "editjournal.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+void EditJournal::setLimit(size_t limit) {
+    m_limit = limit;
+    trim();
+}
+
+void EditJournal::begin(const QString &description) {
+    if (m_depth++ == 0)
+        m_current.description = description;
+}
+
+void EditJournal::end() {
+    if (m_depth == 0 || --m_depth > 0)
+        return;
+
+    Edit edit = std::move(m_current);
+    m_current = Edit();
+    if (edit.steps.empty())
+        return;
+
+    // A new edit makes everything that was undone before unreachable
+    for (auto &undoneEdit : m_redo)
+        release(undoneEdit, false);
+    m_redo.clear();
+
+    m_undo.push_back(std::move(edit));
+    trim();
+}
+
+void EditJournal::record(EditStep step) {
+    if (recording())
+        m_current.steps.push_back(std::move(step));
+}
+
+void EditJournal::undone() {
+    m_redo.push_back(std::move(m_undo.back()));
+    m_undo.pop_back();
+}
+
+void EditJournal::redone() {
+    m_undo.push_back(std::move(m_redo.back()));
+    m_redo.pop_back();
+}
+
+void EditJournal::clear() {
+    for (auto &edit : m_undo)
+        release(edit, true);
+    for (auto &edit : m_redo)
+        release(edit, false);
+    m_undo.clear();
+    m_redo.clear();
+    m_current = Edit();
+    m_depth = 0;
+}
+
+void EditJournal::trim() {
+    while (m_undo.size() > m_limit) {
+        release(m_undo.front(), true);
+        m_undo.pop_front();
+    }
+}
+
+//Frees the objects of the edit that are out of the graph: the removed ones
+//if the edit is applied and the added ones if it was undone. An object could
+//be both added and removed within a single edit, it is freed exactly once.
+void EditJournal::release(Edit &edit, bool applied) {
+    for (auto &step : edit.steps) {
+        auto *change = std::get_if<GraphChange>(&step);
+        if (!change || change->added == applied)
+            continue;
+
+        for (auto *edge : change->edges)
+            delete edge;
+        for (auto *node : change->nodes)
+            delete node;
+        change->edges.clear();
+        change->nodes.clear();
+    }
+}
@@ -0,0 +1,115 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QColor>
+#include <QPointF>
+#include <QString>
+
+#include <deque>
+#include <variant>
+#include <vector>
+
+class DeBruijnNode;
+class DeBruijnEdge;
+
+// Nodes and edges that were added to or removed from the graph. Removed
+// objects are kept alive, so undoing a change only relinks them. Whichever
+// side of the change is currently out of the graph is owned by the journal.
+struct GraphChange {
+    bool added = false;
+    std::vector<DeBruijnNode *> nodes;
+    std::vector<DeBruijnEdge *> edges;
+    // Line points of the node graphics items at the time the nodes left the
+    // scene, empty if none of them was drawn
+    std::vector<std::vector<QPointF>> linePoints;
+};
+
+// Node pair renaming, names are given without +/-
+struct NodeRename {
+    QString oldName;
+    QString newName;
+};
+
+// An invalid colour stands for "no custom colour"
+struct NodeColourChange {
+    const DeBruijnNode *node;
+    QColor oldColour;
+    QColor newColour;
+};
+
+struct NodeDepthChange {
+    DeBruijnNode *node;
+    double oldDepth;
+    double newDepth;
+};
+
+using EditStep = std::variant<GraphChange, NodeRename, NodeColourChange, NodeDepthChange>;
+
+// A single user-visible edit, i.e. everything that is undone at once
+struct Edit {
+    QString description;
+    std::vector<EditStep> steps;
+};
+
+// Undo / redo stacks of graph edits. Every edit only stores what it changed,
+// so recording, undoing and redoing are all proportional to the size of the
+// edit rather than to the size of the graph.
+class EditJournal {
+public:
+    EditJournal() = default;
+    EditJournal(const EditJournal &) = delete;
+    EditJournal &operator=(const EditJournal &) = delete;
+    ~EditJournal() { clear(); }
+
+    // Maximum number of edits that could be undone, 0 disables the journal
+    void setLimit(size_t limit);
+    [[nodiscard]] size_t limit() const { return m_limit; }
+
+    // Steps are only recorded between begin() and end(). Nested pairs are
+    // folded into the outermost edit, edits without any steps are dropped.
+    void begin(const QString &description);
+    void end();
+    [[nodiscard]] bool recording() const { return m_limit && m_depth; }
+    void record(EditStep step);
+
+    [[nodiscard]] bool canUndo() const { return !m_undo.empty(); }
+    [[nodiscard]] bool canRedo() const { return !m_redo.empty(); }
+    [[nodiscard]] QString undoDescription() const { return canUndo() ? m_undo.back().description : QString(); }
+    [[nodiscard]] QString redoDescription() const { return canRedo() ? m_redo.back().description : QString(); }
+
+    // The edit to be reverted (reapplied) next. Once this is done, undone()
+    // (redone()) moves it over to the other stack.
+    Edit &nextUndo() { return m_undo.back(); }
+    Edit &nextRedo() { return m_redo.back(); }
+    void undone();
+    void redone();
+
+    // Drops all edits, freeing the objects that are no longer in the graph
+    void clear();
+
+private:
+    static void release(Edit &edit, bool applied);
+    void trim();
+
+    size_t m_limit = 0;
+    unsigned m_depth = 0;
+    Edit m_current;
+    std::deque<Edit> m_undo;
+    std::deque<Edit> m_redo;
+};
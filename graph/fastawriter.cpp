@@ -17,37 +17,191 @@
 
 #include "fastawriter.h"
 #include "assemblygraph.h"
+#include "debruijnnode.h"
+#include "path.h"
+#include "recordwriter.h"
+#include "sequenceutils.h"
 
-#include <QFile>
-#include <QTextStream>
+#include "parallel_hashmap/phmap.h"
+
+#include <algorithm>
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace utils {
-    bool saveEntireGraphToFasta(const QString &filename,
-                                const AssemblyGraph &graph) {
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    // Fully decoded node sequences shared by the threads formatting paths.
+    // Least recently used sequences are dropped once the capacity (in bases)
+    // is exceeded. The cache is split into independently locked shards, so
+    // the threads rarely wait for each other.
+    class DecodedSequenceCache {
+    public:
+        explicit DecodedSequenceCache(size_t capacity)
+                : m_shardCapacity(capacity / shardCount) {}
+
+        std::shared_ptr<const std::string> get(const DeBruijnNode *node) {
+            Shard &shard = m_shards[phmap::Hash<const DeBruijnNode *>()(node) % shardCount];
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                auto it = shard.index.find(node);
+                if (it != shard.index.end()) {
+                    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                    return it->second->second;
+                }
+            }
+
+            // Decode without holding the lock. Another thread might be
+            // decoding the same node, then the first one to finish wins.
+            auto decoded = std::make_shared<std::string>();
+            appendSequence(*decoded, node->getSequence());
+
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto [it, inserted] = shard.index.try_emplace(node);
+            if (!inserted)
+                return it->second->second;
+
+            shard.lru.emplace_front(node, decoded);
+            it->second = shard.lru.begin();
+            shard.size += decoded->size();
+            while (shard.size > m_shardCapacity && shard.lru.size() > 1) {
+                const auto &victim = shard.lru.back();
+                shard.size -= victim.second->size();
+                shard.index.erase(victim.first);
+                shard.lru.pop_back();
+            }
+
+            return decoded;
+        }
+
+    private:
+        static constexpr size_t shardCount = 64;
+
+        using Entry = std::pair<const DeBruijnNode *, std::shared_ptr<const std::string>>;
+        struct Shard {
+            std::mutex mutex;
+            std::list<Entry> lru;
+            phmap::flat_hash_map<const DeBruijnNode *, std::list<Entry>::iterator> index;
+            size_t size = 0;
+        };
+
+        size_t m_shardCapacity;
+        std::array<Shard, shardCount> m_shards;
+    };
+
+    // Bases kept decoded while writing paths
+    static constexpr size_t decodedSequenceCacheCapacity = size_t(256) << 20;
+    // Shorter nodes are cheaper to decode than to look up
+    static constexpr size_t minCachedNodeLength = 64;
+
+    static void appendPathFasta(std::string &out, const QString &name, const Path &path,
+                                DecodedSequenceCache &cache) {
+        out += '>';
+        appendString(out, name);
+        if (path.isCircular())
+            out += " (circular)";
+        out += '\n';
+
+        FastaLineWrapper lines(out);
+        for (const auto &piece : path.getSequencePieces()) {
+            lines.appendNs(piece.ns);
+
+            size_t length = piece.to - piece.from;
+            const Sequence &sequence = piece.node->getSequence();
+            if (sequence.size() < minCachedNodeLength)
+                lines.append(sequence, piece.from, length);
+            else
+                lines.append(cache.get(piece.node)->data() + piece.from, length);
+        }
+        lines.finish();
+    }
+
+    static bool saveNodesToFasta(const QString &filename,
+                                 const std::vector<const DeBruijnNode *> &nodes,
+                                 bool sign, bool bgzip) {
+        RecordWriter writer(filename, bgzip);
+        if (!writer.open())
             return false;
 
-        QTextStream out(&file);
+        if (!writer.writeRecords(nodes.size(),
+                                 [&](std::string &out, size_t i) {
+                                     nodes[i]->appendFasta(out, sign);
+                                 },
+                                 true))
+            return false;
+
+        return writer.close();
+    }
+
+    bool saveEntireGraphToFasta(const QString &filename,
+                                const AssemblyGraph &graph,
+                                bool bgzip) {
+        std::vector<const DeBruijnNode *> nodes;
+        nodes.reserve(graph.m_deBruijnGraphNodes.size());
         for (const auto *node: graph.m_deBruijnGraphNodes)
-            out << node->getFasta(true);
+            nodes.push_back(node);
 
-        return true;
+        return saveNodesToFasta(filename, nodes, true, bgzip);
     }
 
     bool saveEntireGraphToFastaOnlyPositiveNodes(const QString &filename,
-                                                 const AssemblyGraph &graph) {
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-            return false;
-
-        QTextStream out(&file);
+                                                 const AssemblyGraph &graph,
+                                                 bool bgzip) {
+        std::vector<const DeBruijnNode *> nodes;
         for (const auto *node: graph.m_deBruijnGraphNodes) {
             if (node->isPositiveNode())
-                out << node->getFasta(false);
+                nodes.push_back(node);
         }
 
-        return true;
+        return saveNodesToFasta(filename, nodes, false, bgzip);
+    }
+
+    bool savePathsToFasta(const QString &filename,
+                          const std::vector<std::pair<QString, const Path *>> &paths,
+                          bool bgzip) {
+        RecordWriter writer(filename, bgzip);
+        if (!writer.open())
+            return false;
+
+        // A single walk could span a whole chromosome, so paths are formatted
+        // one per chunk
+        DecodedSequenceCache cache(decodedSequenceCacheCapacity);
+        if (!writer.writeRecords(paths.size(),
+                                 [&](std::string &out, size_t i) {
+                                     appendPathFasta(out, paths[i].first, *paths[i].second, cache);
+                                 },
+                                 true, 1))
+            return false;
+
+        return writer.close();
     }
 
-}
\ No newline at end of file
+    bool saveAllPathsToFasta(const QString &filename,
+                             const AssemblyGraph &graph,
+                             bool bgzip) {
+        std::vector<std::pair<QString, const Path *>> paths;
+        paths.reserve(graph.m_deBruijnGraphPaths.size());
+        for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
+            paths.emplace_back(QString::fromStdString(it.key()), &it.value());
+
+        return savePathsToFasta(filename, paths, bgzip);
+    }
+
+    bool saveAllWalksToFasta(const QString &filename,
+                             const AssemblyGraph &graph,
+                             bool bgzip) {
+        std::vector<std::pair<QString, const Path *>> walks;
+        walks.reserve(graph.m_deBruijnGraphWalks.size());
+        for (auto it = graph.m_deBruijnGraphWalks.begin(); it != graph.m_deBruijnGraphWalks.end(); ++it) {
+            const Walk &walk = it.value();
+            QString name = QString::fromStdString(walk.sampleId) + "#" + QString::number(walk.hapIndex) + "#" +
+                           QString::fromStdString(it.key()) + ":" +
+                           QString::number(walk.seqStart) + "-" + QString::number(walk.seqEnd);
+            walks.emplace_back(std::move(name), &walk.walk);
+        }
+
+        return savePathsToFasta(filename, walks, bgzip);
+    }
+}
@@ -17,12 +17,36 @@
 
 #pragma once
 
+#include <QString>
+
+#include <utility>
+#include <vector>
+
 class AssemblyGraph;
-class QString;
+class Path;
 
 namespace utils {
+    // Records are formatted in parallel and written in graph order. If bgzip
+    // is set, the output is BGZF-compressed (suitable for samtools faidx).
     bool saveEntireGraphToFasta(const QString &filename,
-                                const AssemblyGraph &graph);
+                                const AssemblyGraph &graph,
+                                bool bgzip = false);
     bool saveEntireGraphToFastaOnlyPositiveNodes(const QString &filename,
-                                                 const AssemblyGraph &graph);
+                                                 const AssemblyGraph &graph,
+                                                 bool bgzip = false);
+
+    // Paths are formatted concurrently and written in the given order. Node
+    // sequences are decoded once and shared between the paths through an LRU
+    // cache, as pangenome paths go through the same nodes over and over.
+    bool savePathsToFasta(const QString &filename,
+                          const std::vector<std::pair<QString, const Path *>> &paths,
+                          bool bgzip = false);
+    // All P-lines of the graph, named by path name
+    bool saveAllPathsToFasta(const QString &filename,
+                             const AssemblyGraph &graph,
+                             bool bgzip = false);
+    // All W-lines of the graph, named sample#haplotype#sequence:start-end
+    bool saveAllWalksToFasta(const QString &filename,
+                             const AssemblyGraph &graph,
+                             bool bgzip = false);
 }
@@ -14,33 +14,59 @@
 
 // You should have received a copy of the GNU General Public License
 // along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
-
 #include "gfawriter.h"
 
 #include "assemblygraph.h"
 #include "debruijnedge.h"
 #include "path.h"
+#include "recordwriter.h"
 #include "sequenceutils.h"
 #include "program/colormap.h"
 
-#include <QFile>
-#include <QTextStream>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 namespace gfa {
-    static void printTags(QByteArray &out, const std::vector<gfa::tag> &tags) {
+    enum class DepthTag { None, Depth, Count };
+
+    static void appendSign(std::string &out, const DeBruijnNode *node) {
+        const QString &name = node->getName();
+        out += name.isEmpty() ? '+' : char(name.back().unicode());
+    }
+
+    static void appendNameWithoutSign(std::string &out, const DeBruijnNode *node) {
+        const QString &name = node->getName();
+        utils::appendString(out, name, std::max<qsizetype>(name.length() - 1, 0));
+    }
+
+    // Decodes the sequence straight into the output buffer. If the sequence
+    // is missing, it will just give "*"
+    static size_t appendSequence(std::string &out, const DeBruijnNode *node) {
+        if (node->sequenceIsMissing()) {
+            out += '*';
+            return 1;
+        }
+
+        const Sequence &seq = node->getSequence();
+        utils::appendSequence(out, seq);
+        return seq.size();
+    }
+
+    static void appendTags(std::string &out, const std::vector<gfa::tag> &tags) {
         for (const auto &tag: tags) {
             out += '\t';
             out += tag.name[0];
             out += tag.name[1];
-            out += ":";
+            out += ':';
             out += tag.type;
-            out += ":";
+            out += ':';
             std::visit([&](const auto &val) {
                 using T = std::decay_t<decltype(val)>;
                 if constexpr (std::is_same_v<T, int64_t>) {
-                    out += qPrintable(QString::number(val));
+                    utils::appendNumber(out, val);
                 } else if constexpr (std::is_same_v<T, float>) {
-                    out += qPrintable(QString::number(val));
+                    utils::appendNumber(out, double(val));
                 } else if constexpr (std::is_same_v<T, std::string>) {
                     out += val;
                 }
@@ -48,96 +74,97 @@ namespace gfa {
         }
     }
 
-    // This function gets the node's sequence for a GFA file.
-    // If the sequence is missing, it will just give "*"
-    QByteArray getSequenceForGfa(const DeBruijnNode *node) {
-        if (node->sequenceIsMissing())
-            return {"*"};
-
-        return utils::sequenceToQByteArray(node->getSequence());
-    }
-
-    static QByteArray getGfaSegmentLine(const DeBruijnNode *node, const AssemblyGraph &graph,
-                                        const QString &depthTag) {
-        QByteArray gfaSequence = getSequenceForGfa(node);
-
-        QByteArray gfaSegmentLine = "S";
-        gfaSegmentLine += "\t" + node->getNameWithoutSign().toLatin1();
-        gfaSegmentLine += "\t" + gfaSequence;
-        gfaSegmentLine += "\tLN:i:" + QString::number(gfaSequence.length()).toLatin1();
+    static void appendSegmentLine(std::string &out, const DeBruijnNode *node, const AssemblyGraph &graph,
+                                  DepthTag depthTag) {
+        out += "S\t";
+        appendNameWithoutSign(out, node);
+        out += '\t';
+        size_t length = appendSequence(out, node);
+        out += "\tLN:i:";
+        utils::appendNumber(out, int64_t(length));
 
         //We use the depthTag to guide how we save the node depth.
         //If it is empty, that implies that the loaded graph did not have depth
         //information and so we don't save depth.
-        if (depthTag == "DP" || depthTag == "dp")
-            gfaSegmentLine += "\tDP:f:" + QString::number(node->getDepth()).toLatin1();
-        else if (depthTag == "KC" || depthTag == "RC" || depthTag == "FC")
-            gfaSegmentLine += "\t" + depthTag.toLatin1() + ":i:" +
-                              QString::number(int(node->getDepth() * gfaSequence.length() + 0.5)).toLatin1();
+        if (depthTag == DepthTag::Depth) {
+            out += "\tDP:f:";
+            utils::appendNumber(out, node->getDepth());
+        } else if (depthTag == DepthTag::Count) {
+            out += '\t';
+            utils::appendString(out, graph.m_depthTag);
+            out += ":i:";
+            utils::appendNumber(out, int64_t(int(node->getDepth() * length + 0.5)));
+        }
 
         //If the user has included custom labels or colours, include those.
         QString label = graph.getCustomLabel(node);
-        if (!label.isEmpty())
-            gfaSegmentLine += "\tLB:Z:" + label.toLatin1();
+        if (!label.isEmpty()) {
+            out += "\tLB:Z:";
+            utils::appendString(out, label);
+        }
 
         QString rcLabel = graph.getCustomLabel(node->getReverseComplement());
-        if (!rcLabel.isEmpty())
-            gfaSegmentLine += "\tL2:Z:" + rcLabel.toLatin1();
-        if (graph.hasCustomColour(node))
-            gfaSegmentLine += "\tCL:Z:" + getColourName(graph.getCustomColour(node)).toLatin1();
-        if (graph.hasCustomColour(node->getReverseComplement()))
-            gfaSegmentLine += "\tC2:Z:" + getColourName(graph.getCustomColour(node->getReverseComplement())).toLatin1();
+        if (!rcLabel.isEmpty()) {
+            out += "\tL2:Z:";
+            utils::appendString(out, rcLabel);
+        }
+        if (graph.hasCustomColour(node)) {
+            out += "\tCL:Z:";
+            utils::appendString(out, getColourName(graph.getCustomColour(node)));
+        }
+        if (graph.hasCustomColour(node->getReverseComplement())) {
+            out += "\tC2:Z:";
+            utils::appendString(out, getColourName(graph.getCustomColour(node->getReverseComplement())));
+        }
 
         auto tagIt = graph.m_nodeTags.find(node);
         if (tagIt != graph.m_nodeTags.end())
-            printTags(gfaSegmentLine, tagIt->second);
-
-        return gfaSegmentLine;
+            appendTags(out, tagIt->second);
     }
 
-    static QByteArray getGfaLinkLine(const DeBruijnEdge *edge, const AssemblyGraph &graph) {
+    static void appendLinkLine(std::string &out, const DeBruijnEdge *edge, const AssemblyGraph &graph) {
         const DeBruijnNode *startingNode = edge->getStartingNode();
         const DeBruijnNode *endingNode = edge->getEndingNode();
         bool isJump = edge->getOverlapType() == JUMP;
 
-        QByteArray gfaLinkLine = isJump ? "J\t" : "L\t";
-        gfaLinkLine += qPrintable(startingNode->getNameWithoutSign());
-        gfaLinkLine += '\t';
-        gfaLinkLine += qPrintable(startingNode->getSign());
-        gfaLinkLine += '\t';
-        gfaLinkLine += qPrintable(endingNode->getNameWithoutSign());
-        gfaLinkLine += '\t';
-        gfaLinkLine += qPrintable(endingNode->getSign());
-        gfaLinkLine += '\t';
+        out += isJump ? "J\t" : "L\t";
+        appendNameWithoutSign(out, startingNode);
+        out += '\t';
+        appendSign(out, startingNode);
+        out += '\t';
+        appendNameWithoutSign(out, endingNode);
+        out += '\t';
+        appendSign(out, endingNode);
+        out += '\t';
         // Emit overlap for normal links and distance for jump links
         if (isJump) {
-            gfaLinkLine += edge->getOverlap() == 0 ? "*" : qPrintable(QString::number(edge->getOverlap()));
+            if (edge->getOverlap() == 0)
+                out += '*';
+            else
+                utils::appendNumber(out, int64_t(edge->getOverlap()));
         } else {
-            gfaLinkLine += qPrintable(QString::number(edge->getOverlap()));
-            gfaLinkLine += "M";
+            utils::appendNumber(out, int64_t(edge->getOverlap()));
+            out += 'M';
         }
 
         if (graph.hasCustomColour(edge)) {
-            gfaLinkLine += "\tCL:Z:";
-            gfaLinkLine += qPrintable(getColourName(graph.getCustomColour(edge)));
+            out += "\tCL:Z:";
+            utils::appendString(out, getColourName(graph.getCustomColour(edge)));
         }
         if (!edge->isOwnReverseComplement() && graph.hasCustomColour(edge->getReverseComplement())) {
-            gfaLinkLine += "\tC2:Z:";
-            gfaLinkLine += qPrintable(getColourName(graph.getCustomColour(edge->getReverseComplement())));
+            out += "\tC2:Z:";
+            utils::appendString(out, getColourName(graph.getCustomColour(edge->getReverseComplement())));
         }
 
         auto tagIt = graph.m_edgeTags.find(edge);
         if (tagIt != graph.m_edgeTags.end())
-            printTags(gfaLinkLine, tagIt->second);
-
-        return gfaLinkLine;
+            appendTags(out, tagIt->second);
     }
 
-    static QByteArray getGfaPathLine(const std::string &name, const Path &path,
-                                     const AssemblyGraph &graph) {
-        QByteArray gfaPathLine = "P\t";
-        gfaPathLine += name;
-        gfaPathLine += '\t';
+    static void appendPathLine(std::string &out, const std::string &name, const Path &path) {
+        out += "P\t";
+        out += name;
+        out += '\t';
 
         const auto &nodes = path.nodes();
         const auto &edges = path.edges();
@@ -146,77 +173,82 @@ namespace gfa {
         // same length for circular paths
         for (size_t i = 0; i < edges.size(); ++i) {
             const auto *edge = edges[i];
-            gfaPathLine += qPrintable(nodes[i]->getName());
-            gfaPathLine += edge->getOverlapType() == JUMP ? ';' : ',';
+            utils::appendString(out, nodes[i]->getName());
+            out += edge->getOverlapType() == JUMP ? ';' : ',';
         }
         // Handle last node: for circular paths we're adding extra node here
         if (nodes.size() == edges.size()) { // circular path
-            gfaPathLine += qPrintable(nodes.front()->getName());
+            utils::appendString(out, nodes.front()->getName());
         } else {
-            gfaPathLine += qPrintable(nodes.back()->getName());
+            utils::appendString(out, nodes.back()->getName());
         }
+    }
 
-        return gfaPathLine;
+    static DepthTag getDepthTag(const QString &depthTag) {
+        if (depthTag == "DP" || depthTag == "dp")
+            return DepthTag::Depth;
+        if (depthTag == "KC" || depthTag == "RC" || depthTag == "FC")
+            return DepthTag::Count;
+        return DepthTag::None;
     }
 
-    bool saveEntireGraph(const QString &filename,
-                         const AssemblyGraph &graph) {
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    template<class NodePredicate>
+    static bool saveGraph(const QString &filename, const AssemblyGraph &graph, bool parallel,
+                          NodePredicate shouldSave) {
+        utils::RecordWriter writer(filename);
+        if (!writer.open())
             return false;
 
-        QTextStream out(&file);
-
+        std::vector<const DeBruijnNode *> nodesToSave;
         for (const auto *node: graph.m_deBruijnGraphNodes) {
-            if (node->isPositiveNode())
-                out << getGfaSegmentLine(node, graph, graph.m_depthTag) << '\n';
+            if (node->isPositiveNode() && shouldSave(node))
+                nodesToSave.push_back(node);
         }
 
-        QList<const DeBruijnEdge *> edgesToSave;
+        DepthTag depthTag = getDepthTag(graph.m_depthTag);
+        if (!writer.writeRecords(nodesToSave.size(),
+                                 [&](std::string &out, size_t i) {
+                                     appendSegmentLine(out, nodesToSave[i], graph, depthTag);
+                                     out += '\n';
+                                 },
+                                 parallel))
+            return false;
+
+        std::vector<const DeBruijnEdge *> edgesToSave;
         for (const DeBruijnEdge *edge : graph.m_deBruijnGraphEdges) {
-            if (edge->isPositiveEdge())
+            if (edge->isPositiveEdge() &&
+                shouldSave(edge->getStartingNode()) && shouldSave(edge->getEndingNode()))
                 edgesToSave.push_back(edge);
         }
 
         std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
 
-        for (const auto *edge: edgesToSave)
-            out << getGfaLinkLine(edge, graph) << '\n';
-
-        for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
-            out << getGfaPathLine(it.key(), *it, graph) << '\n';
-
-        return true;
-    }
-
-    bool saveVisibleGraph(const QString &filename, const AssemblyGraph &graph) {
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        if (!writer.writeRecords(edgesToSave.size(),
+                                 [&](std::string &out, size_t i) {
+                                     appendLinkLine(out, edgesToSave[i], graph);
+                                     out += '\n';
+                                 },
+                                 parallel))
             return false;
 
-        QTextStream out(&file);
-
-        for (const auto *node: graph.m_deBruijnGraphNodes) {
-            if (node->thisNodeOrReverseComplementIsDrawn() && node->isPositiveNode())
-                out << getGfaSegmentLine(node, graph, graph.m_depthTag) << '\n';
-        }
-
-        QList<const DeBruijnEdge *> edgesToSave;
-        for (const DeBruijnEdge *edge : graph.m_deBruijnGraphEdges) {
-            if (edge->getStartingNode()->thisNodeOrReverseComplementIsDrawn() &&
-                edge->getEndingNode()->thisNodeOrReverseComplementIsDrawn() &&
-                edge->isPositiveEdge())
-                edgesToSave.push_back(edge);
+        std::string &out = writer.buffer();
+        for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it) {
+            appendPathLine(out, it.key(), *it);
+            out += '\n';
+            if (!writer.flushIfFull())
+                return false;
         }
 
-        std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
-
-        for (const auto *node: edgesToSave)
-            out << getGfaLinkLine(node, graph) << '\n';
+        return writer.close();
+    }
 
-        for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
-            out << getGfaPathLine(it.key(), *it, graph) << '\n';
+    bool saveEntireGraph(const QString &filename, const AssemblyGraph &graph, bool parallel) {
+        return saveGraph(filename, graph, parallel,
+                         [](const DeBruijnNode *) { return true; });
+    }
 
-        return true;
+    bool saveVisibleGraph(const QString &filename, const AssemblyGraph &graph, bool parallel) {
+        return saveGraph(filename, graph, parallel,
+                         [](const DeBruijnNode *node) { return node->thisNodeOrReverseComplementIsDrawn(); });
     }
 }
@@ -22,8 +22,12 @@
 class AssemblyGraph;
 
 namespace gfa {
+    // When parallel is set, chunks of segment and link lines are formatted
+    // concurrently; the output is identical to the sequential one.
     bool saveEntireGraph(const QString &filename,
-                         const AssemblyGraph &graph);
+                         const AssemblyGraph &graph,
+                         bool parallel = false);
     bool saveVisibleGraph(const QString &filename,
-                          const AssemblyGraph &graph);
+                          const AssemblyGraph &graph,
+                          bool parallel = false);
 }
\ No newline at end of file
@@ -24,61 +24,122 @@
 #include "graph/assemblygraph.h"
 #include "program/globals.h"
 #include "program/settings.h"
+#include "ui/bandagegraphicsscene.h"
+#include "ui/bandagegraphicsview.h"
 
 #include <QPainterPathStroker>
 #include <QPainter>
 #include <QPen>
 #include <QLineF>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
 
 GraphicsItemEdge::GraphicsItemEdge(DeBruijnEdge *deBruijnEdge,
                                    const AssemblyGraph &graph,
                                    QGraphicsItem *parent)
     : QGraphicsPathItem(parent), m_deBruijnEdge(deBruijnEdge) {
-    m_edgeColor = graph.getCustomColour(deBruijnEdge);
-    auto style = graph.getCustomStyle(deBruijnEdge);
-    m_penStyle = style.lineStyle;
-    if (style.width > 0)
-        m_width = style.width;
-    else
-        m_width = deBruijnEdge->getOverlapType() == EdgeOverlapType::EXTRA_LINK ?
-                  g_settings->linkWidth : g_settings->edgeWidth;
+    Style style = getStyle(deBruijnEdge, graph);
+    m_edgeColor = style.colour;
+    m_penStyle = style.penStyle;
+    m_width = style.width;
 
     remakePath();
 }
 
-void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) {
+GraphicsItemEdge::Style GraphicsItemEdge::getStyle(const DeBruijnEdge *edge, const AssemblyGraph &graph) {
+    Style style;
+    style.colour = graph.getCustomColour(edge);
+    auto customStyle = graph.getCustomStyle(edge);
+    style.penStyle = customStyle.lineStyle;
+    if (customStyle.width > 0)
+        style.width = customStyle.width;
+    else
+        style.width = edge->getOverlapType() == EdgeOverlapType::EXTRA_LINK ?
+                      g_settings->linkWidth : g_settings->edgeWidth;
+
+    return style;
+}
+
+GraphicsItemEdge::~GraphicsItemEdge() {
+    BandageGraphicsScene::trackItemChange(this, ItemSceneChange);
+}
+
+QVariant GraphicsItemEdge::itemChange(GraphicsItemChange change, const QVariant &value) {
+    BandageGraphicsScene::trackItemChange(this, change);
+    return QGraphicsPathItem::itemChange(change, value);
+}
+
+void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget * widget) {
+    // Short edges are drawn by the view in batches
+    if (BandageGraphicsView::isPaintingViewport(painter, widget) &&
+        isSimplified(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform())))
+        return;
+
     QColor penColour = isSelected() ? g_settings->selectionColour : m_edgeColor;
     QPen edgePen(QBrush(penColour), m_width, m_penStyle, Qt::RoundCap);
     painter->setPen(edgePen);
     painter->drawPath(path());
 }
 
+double GraphicsItemEdge::screenLength(double levelOfDetail) const {
+    QRectF rect = path().controlPointRect();
+    return std::max(rect.width(), rect.height()) * levelOfDetail;
+}
+
+bool GraphicsItemEdge::isSimplified(double levelOfDetail) const {
+    return g_settings->lodEdgeLength.on && screenLength(levelOfDetail) < g_settings->lodEdgeLength;
+}
+
+void GraphicsItemEdge::addSimplified(SimplifiedItems &items, double levelOfDetail) const {
+    if (screenLength(levelOfDetail) < g_settings->lodEdgeLength / 4.0)
+        return;
+
+    QColor penColour = isSelected() ? g_settings->selectionColour : m_edgeColor;
+    items.edgeLines[{ penColour.rgba(), m_width, m_penStyle }].emplace_back(path().elementAt(0),
+                                                                          path().currentPosition());
+}
+
 QPainterPath GraphicsItemEdge::shape() const {
+    if (!m_shapeValid) {
+        m_shape = makeShape(path(), m_width);
+        m_shapeValid = true;
+    }
+
+    return m_shape;
+}
+
+QPainterPath GraphicsItemEdge::makeShape(const QPainterPath &path, float width) {
     QPainterPathStroker stroker;
-    stroker.setWidth(m_width);
+    stroker.setWidth(width);
     stroker.setCapStyle(Qt::RoundCap);
     stroker.setJoinStyle(Qt::RoundJoin);
-    return stroker.createStroke(path());
+    return stroker.createStroke(path);
+}
+
+const DrawnNode *GraphicsItemEdge::graphicsItemNode(const DeBruijnNode *node) {
+    return node->getGraphicsItemNode();
 }
 
 static void getControlPointLocations(const DeBruijnEdge *edge,
+                                     const GraphicsItemEdge::DrawnNodeLookup &drawnNode,
                                      QLineF &start, QLineF &end) {
     DeBruijnNode *startingNode = edge->getStartingNode();
     DeBruijnNode *endingNode = edge->getEndingNode();
 
-    if (const auto *startingGraphicsItemNode = startingNode->getGraphicsItemNode()) {
-        start = startingGraphicsItemNode->getLastSegment();
-    } else if (const auto *startingGraphicsItemRcNode =
-               startingNode->getReverseComplement()->getGraphicsItemNode()) {
-        auto segment = startingGraphicsItemRcNode->getFirstSegment();
+    if (const auto *startingDrawnNode = drawnNode(startingNode)) {
+        start = startingDrawnNode->getLastSegment();
+    } else if (const auto *startingDrawnRcNode =
+               drawnNode(startingNode->getReverseComplement())) {
+        auto segment = startingDrawnRcNode->getFirstSegment();
         start.setPoints(segment.p2(), segment.p1());
     }
 
-    if (const auto *endingGraphicsItemNode = endingNode->getGraphicsItemNode()) {
-        end = endingGraphicsItemNode->getFirstSegment();
-    } else if (const auto *endingGraphicsItemRcNode
-               = endingNode->getReverseComplement()->getGraphicsItemNode()) {
-        auto segment = endingGraphicsItemRcNode->getLastSegment();
+    if (const auto *endingDrawnNode = drawnNode(endingNode)) {
+        end = endingDrawnNode->getFirstSegment();
+    } else if (const auto *endingDrawnRcNode
+               = drawnNode(endingNode->getReverseComplement())) {
+        auto segment = endingDrawnRcNode->getLastSegment();
         end.setPoints(segment.p2(), segment.p1());
     }
 }
@@ -148,8 +209,14 @@ static void makeOrdinaryPath(QPainterPath &path,
 
 
 void GraphicsItemEdge::remakePath() {
+    setPath(makePath(m_deBruijnEdge, graphicsItemNode));
+    m_shapeValid = false;
+    m_shape = QPainterPath();
+}
+
+QPainterPath GraphicsItemEdge::makePath(const DeBruijnEdge *edge, const DrawnNodeLookup &drawnNode) {
     QLineF startSegment, endSegment;
-    getControlPointLocations(m_deBruijnEdge, startSegment, endSegment);
+    getControlPointLocations(edge, drawnNode, startSegment, endSegment);
 
     QPainterPath path;
 
@@ -157,13 +224,13 @@ void GraphicsItemEdge::remakePath() {
     // is made of only one line segment, then a special path is
     // required, otherwise the edge will be mostly hidden underneath
     // the node.
-    DeBruijnNode *startingNode = m_deBruijnEdge->getStartingNode();
-    DeBruijnNode *endingNode = m_deBruijnEdge->getEndingNode();
+    DeBruijnNode *startingNode = edge->getStartingNode();
+    DeBruijnNode *endingNode = edge->getEndingNode();
     if (startingNode == endingNode) {
-        GraphicsItemNode * graphicsItemNode = startingNode->getGraphicsItemNode();
-        if (!graphicsItemNode)
-            graphicsItemNode = startingNode->getReverseComplement()->getGraphicsItemNode();
-        if (graphicsItemNode && graphicsItemNode->m_linePoints.size() == 2)
+        const DrawnNode * startingDrawnNode = drawnNode(startingNode);
+        if (!startingDrawnNode)
+            startingDrawnNode = drawnNode(startingNode->getReverseComplement());
+        if (startingDrawnNode && startingDrawnNode->m_linePoints.size() == 2)
             makeSpecialPathConnectingNodeToSelf(path, startSegment);
         else
             makeOrdinaryPath(path, startSegment, endSegment);
@@ -175,5 +242,5 @@ void GraphicsItemEdge::remakePath() {
     } else
         makeOrdinaryPath(path, startSegment, endSegment);
 
-    setPath(path);
+    return path;
 }
@@ -19,26 +19,64 @@
 #ifndef GRAPHICSITEMEDGE_H
 #define GRAPHICSITEMEDGE_H
 
+#include <QColor>
 #include <QGraphicsPathItem>
 #include <QPainterPath>
 #include <QPointF>
 
+#include <functional>
+
 class DeBruijnEdge;
+class DeBruijnNode;
+class DrawnNode;
 class AssemblyGraph;
+struct SimplifiedItems;
 
 class GraphicsItemEdge : public QGraphicsPathItem {
 public:
     explicit GraphicsItemEdge(DeBruijnEdge *deBruijnEdge, const AssemblyGraph &graph,
                               QGraphicsItem *parent = nullptr);
+    ~GraphicsItemEdge() override;
 
     void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) override;
     QPainterPath shape() const override;
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
     virtual void remakePath();
     DeBruijnEdge *edge() const { return m_deBruijnEdge; }
 
+    // Short edges are drawn by the view only as straight lines, tiny ones
+    // are not drawn at all
+    bool isSimplified(double levelOfDetail) const;
+    void addSimplified(SimplifiedItems &items, double levelOfDetail) const;
+
+    // Returns the drawn node of a graph node, or nullptr if it is not drawn
+    using DrawnNodeLookup = std::function<const DrawnNode *(const DeBruijnNode *)>;
+
+    struct Style {
+        QColor colour;
+        Qt::PenStyle penStyle;
+        float width;
+    };
+
+    // Custom style of the edge, or the default one from the settings
+    static Style getStyle(const DeBruijnEdge *edge, const AssemblyGraph &graph);
+    // Path between the drawn ends of the edge. A node that is not drawn is
+    // replaced by its drawn reverse complement.
+    static QPainterPath makePath(const DeBruijnEdge *edge, const DrawnNodeLookup &drawnNode);
+    // Path stroked with the edge width, used for hit testing
+    static QPainterPath makeShape(const QPainterPath &path, float width);
+
+protected:
+    static const DrawnNode *graphicsItemNode(const DeBruijnNode *node);
+
 private:
+    double screenLength(double levelOfDetail) const;
+
     DeBruijnEdge *m_deBruijnEdge;
+    // Stroked path used for hit testing, computed lazily after remakePath()
+    mutable QPainterPath m_shape;
+    mutable bool m_shapeValid = false;
     QColor m_edgeColor;
     Qt::PenStyle m_penStyle;
     float m_width;
@@ -96,24 +96,28 @@ static void makePathConnectingNodeToSelf(QPainterPath &path,
 }
 
 void GraphicsItemLink::remakePath() {
-    DeBruijnNode *startingNode = edge()->getStartingNode();
-    DeBruijnNode *endingNode = edge()->getEndingNode();
+    setPath(makePath(edge(), graphicsItemNode));
+}
+
+QPainterPath GraphicsItemLink::makePath(const DeBruijnEdge *edge, const DrawnNodeLookup &drawnNode) {
+    DeBruijnNode *startingNode = edge->getStartingNode();
+    DeBruijnNode *endingNode = edge->getEndingNode();
 
     // Link goes from the median of one node into median of other node.
     QLineF startMidSegment, endMidSegment;
 
-    if (const auto *startingGraphicsItemNode = startingNode->getGraphicsItemNode()) {
-        startMidSegment = startingGraphicsItemNode->getMedianSegment();
-    } else if (const auto *startingGraphicsItemRcNode =
-               startingNode->getReverseComplement()->getGraphicsItemNode()) {
-        startMidSegment = startingGraphicsItemRcNode->getMedianSegment();
+    if (const auto *startingDrawnNode = drawnNode(startingNode)) {
+        startMidSegment = startingDrawnNode->getMedianSegment();
+    } else if (const auto *startingDrawnRcNode =
+               drawnNode(startingNode->getReverseComplement())) {
+        startMidSegment = startingDrawnRcNode->getMedianSegment();
     }
 
-    if (const auto *endingGraphicsItemNode = endingNode->getGraphicsItemNode()) {
-        endMidSegment = endingGraphicsItemNode->getMedianSegment();
-    } else if (const auto *endingGraphicsItemRcNode
-               = endingNode->getReverseComplement()->getGraphicsItemNode()) {
-        endMidSegment = endingGraphicsItemRcNode->getMedianSegment();
+    if (const auto *endingDrawnNode = drawnNode(endingNode)) {
+        endMidSegment = endingDrawnNode->getMedianSegment();
+    } else if (const auto *endingDrawnRcNode
+               = drawnNode(endingNode->getReverseComplement())) {
+        endMidSegment = endingDrawnRcNode->getMedianSegment();
     }
 
     QPainterPath path;
@@ -127,5 +131,5 @@ void GraphicsItemLink::remakePath() {
         makeOrdinaryPath(path, startMidSegment, endMidSegment);
     }
 
-    setPath(path);
+    return path;
 }
@@ -33,6 +33,9 @@ public:
                               QGraphicsItem *parent = nullptr);
 
     void remakePath() override;
+
+    // Path from the middle of one drawn node to the middle of the other
+    static QPainterPath makePath(const DeBruijnEdge *edge, const DrawnNodeLookup &drawnNode);
 };
 
 #endif // GRAPHICSITEMEDGE_H
@@ -32,6 +32,7 @@
 
 #include <QTransform>
 #include <QPainterPathStroker>
+#include <QStyleOptionGraphicsItem>
 #include <QPainter>
 #include <QPen>
 #include <QMessageBox>
@@ -40,66 +41,131 @@
 
 #include <set>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <utility>
 
-//This constructor makes a new GraphicsItemNode by copying the line points of
-//the given node.
-GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
-                                   GraphicsItemNode * toCopy,
-                                   QGraphicsItem * parent) :
-    QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
-    m_linePoints(toCopy->m_linePoints),
-    m_colour(toCopy->m_colour),
-    m_width(toCopy->m_width),
-    m_grabIndex(toCopy->m_grabIndex),
-    m_hasArrow(toCopy->m_hasArrow) {
+//This constructor makes a new node by copying the line points of the given
+//node.
+DrawnNode::DrawnNode(DeBruijnNode * deBruijnNode, const DrawnNode &toCopy) :
+    m_deBruijnNode(deBruijnNode),
+    m_linePoints(toCopy.m_linePoints),
+    m_width(toCopy.m_width),
+    m_hasArrow(toCopy.m_hasArrow) {
     remakePath();
 }
 
-// This constructor makes a new GraphicsItemNode with a specific collection of
-// line points.
-GraphicsItemNode::GraphicsItemNode(DeBruijnNode *deBruijnNode,
-                                   double depthRelativeToMeanDrawnDepth,
-                                   const std::vector<QPointF> &linePoints,
-                                   QGraphicsItem *parent)
-        : QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
+// This constructor makes a new node with a specific collection of line points.
+DrawnNode::DrawnNode(DeBruijnNode *deBruijnNode,
+                     double depthRelativeToMeanDrawnDepth,
+                     const std::vector<QPointF> &linePoints)
+        : m_deBruijnNode(deBruijnNode),
           m_width(0),
-          m_grabIndex(0),
           m_hasArrow(g_settings->doubleMode || g_settings->arrowheadsInSingleMode) {
     m_linePoints.assign(linePoints.begin(), linePoints.end());
     setWidth(depthRelativeToMeanDrawnDepth);
     remakePath();
 }
 
-GraphicsItemNode::GraphicsItemNode(DeBruijnNode *deBruijnNode,
-                                   double depthRelativeToMeanDrawnDepth,
-                                   const adt::SmallPODVector<QPointF> &linePoints,
-                                   QGraphicsItem *parent)
-        : QGraphicsItem(parent), m_deBruijnNode(deBruijnNode),
+DrawnNode::DrawnNode(DeBruijnNode *deBruijnNode,
+                     double depthRelativeToMeanDrawnDepth,
+                     const adt::SmallPODVector<QPointF> &linePoints)
+        : m_deBruijnNode(deBruijnNode),
           m_width(0),
-          m_grabIndex(0),
           m_hasArrow(g_settings->doubleMode || g_settings->arrowheadsInSingleMode) {
     m_linePoints.assign(linePoints.begin(), linePoints.end());
     setWidth(depthRelativeToMeanDrawnDepth);
     remakePath();
 }
 
-float GraphicsItemNode::getNodeWidth(double depthRelativeToMeanDrawnDepth, double depthPower,
-                                     double depthEffectOnWidth, double averageNodeWidth) {
+GraphicsItemNode::GraphicsItemNode(DeBruijnNode * deBruijnNode,
+                                   GraphicsItemNode * toCopy,
+                                   QGraphicsItem * parent) :
+    QGraphicsItem(parent), DrawnNode(deBruijnNode, *toCopy),
+    m_colour(toCopy->m_colour),
+    m_grabIndex(toCopy->m_grabIndex) {}
+
+GraphicsItemNode::GraphicsItemNode(DeBruijnNode *deBruijnNode,
+                                   double depthRelativeToMeanDrawnDepth,
+                                   const std::vector<QPointF> &linePoints,
+                                   QGraphicsItem *parent)
+        : QGraphicsItem(parent), DrawnNode(deBruijnNode, depthRelativeToMeanDrawnDepth, linePoints),
+          m_grabIndex(0) {}
+
+GraphicsItemNode::GraphicsItemNode(DeBruijnNode *deBruijnNode,
+                                   double depthRelativeToMeanDrawnDepth,
+                                   const adt::SmallPODVector<QPointF> &linePoints,
+                                   QGraphicsItem *parent)
+        : QGraphicsItem(parent), DrawnNode(deBruijnNode, depthRelativeToMeanDrawnDepth, linePoints),
+          m_grabIndex(0) {}
+
+GraphicsItemNode::~GraphicsItemNode() {
+    BandageGraphicsScene::trackItemChange(this, ItemSceneChange);
+}
+
+QVariant GraphicsItemNode::itemChange(GraphicsItemChange change, const QVariant &value) {
+    BandageGraphicsScene::trackItemChange(this, change);
+    return QGraphicsItem::itemChange(change, value);
+}
+
+float DrawnNode::getNodeWidth(double depthRelativeToMeanDrawnDepth, double depthPower,
+                              double depthEffectOnWidth, double averageNodeWidth) {
     if (depthRelativeToMeanDrawnDepth < 0.0)
         depthRelativeToMeanDrawnDepth = 0.0;
     double widthRelativeToAverage = (pow(depthRelativeToMeanDrawnDepth, depthPower) - 1.0) * depthEffectOnWidth + 1.0;
     return float(averageNodeWidth * widthRelativeToAverage);
 }
 
-void GraphicsItemNode::setWidth(double depthRelativeToMeanDrawnDepth, double averageNodeWidth,
-                                double depthPower, double depthEffectOnWidth) {
+void DrawnNode::setWidth(double depthRelativeToMeanDrawnDepth, double averageNodeWidth,
+                         double depthPower, double depthEffectOnWidth) {
     m_width = getNodeWidth(depthRelativeToMeanDrawnDepth,
                            depthPower, depthEffectOnWidth, averageNodeWidth);
     if (m_width < 0.0)
         m_width = 0.0;
+    invalidateGeometry();
+}
+
+void GraphicsItemNode::setWidth(double depthRelativeToMeanDrawnDepth, double averageNodeWidth,
+                                double depthPower, double depthEffectOnWidth) {
+    prepareGeometryChange();
+    DrawnNode::setWidth(depthRelativeToMeanDrawnDepth, averageNodeWidth, depthPower, depthEffectOnWidth);
+}
+
+void DrawnNode::invalidateGeometry() {
+    m_shapeValid = false;
+    m_shape = QPainterPath();
+    m_cumulativeLengths.clear();
+}
+
+//Path length from the start of the node to each of the line points.
+const std::vector<double> &DrawnNode::cumulativeLengths() const {
+    if (!m_cumulativeLengths.empty() || m_linePoints.empty())
+        return m_cumulativeLengths;
+
+    m_cumulativeLengths.reserve(m_linePoints.size());
+    double lengthSoFar = 0.0;
+    m_cumulativeLengths.push_back(lengthSoFar);
+    for (size_t i = 0; i < m_linePoints.size() - 1; ++i) {
+        QLineF line(m_linePoints[i], m_linePoints[i + 1]);
+        lengthSoFar += line.length();
+        m_cumulativeLengths.push_back(lengthSoFar);
+    }
+
+    return m_cumulativeLengths;
+}
+
+//Returns the index of the first segment whose end is at or past the given
+//fraction of the path (or the index of the last point if there is none).
+size_t DrawnNode::findSegment(double fraction) const {
+    const auto &lengths = cumulativeLengths();
+    if (lengths.empty())
+        return 0;
+
+    double totalLength = lengths.back();
+    auto it = std::partition_point(lengths.begin() + 1, lengths.end(),
+                                   [&](double length) { return length / totalLength < fraction; });
+    return size_t(it - lengths.begin()) - 1;
 }
 
 static double distance(QPointF p1, QPointF p2) {
@@ -153,7 +219,19 @@ static bool anyNodeDisplayText() {
            g_settings->displayNodeCsvData;
 }
 
-void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *)
+void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget * widget)
+{
+    //At low zoom most nodes are thinner than a pixel, so there is no point in
+    //building their outline and drawing all the details. The view draws such
+    //nodes in batches.
+    if (BandageGraphicsView::isPaintingViewport(painter, widget) &&
+        isSimplified(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform())))
+        return;
+
+    draw(painter, m_colour, isSelected(), g_settings->positionTextNodeCentre);
+}
+
+void DrawnNode::draw(QPainter * painter, const QColor &colour, bool selected, bool labelsAtCentre) const
 {
     static AnnotationGroup::AnnotationVector emptyAnnotations{};
 
@@ -161,12 +239,12 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
     //I use it for debugging graphics issues.
 //    painter->setBrush(Qt::NoBrush);
 //    painter->setPen(QPen(Qt::black, 1.0));
-//    painter->drawRect(boundingRect());
+//    painter->drawRect(bounds());
 
-    QPainterPath outlinePath = shape();
+    QPainterPath outlinePath = copyPath(outline());
 
     //Fill the node's colour
-    QBrush brush(m_colour);
+    QBrush brush(colour);
     painter->fillPath(outlinePath, brush);
 
     //If the node has an arrow, then it's necessary to use the outline
@@ -195,7 +273,7 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
     //Draw the node outline
     QColor outlineColour = g_settings->outlineColour;
     double outlineThickness = g_settings->outlineThickness;
-    if (isSelected())
+    if (selected)
     {
         outlineColour = g_settings->selectionColour;
         outlineThickness = g_settings->selectionThickness;
@@ -236,7 +314,7 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
         }
 
         std::vector<QPointF> centres;
-        if (g_settings->positionTextNodeCentre)
+        if (labelsAtCentre)
             centres.push_back(getCentre(m_linePoints));
         else
             centres = getCentres();
@@ -265,7 +343,29 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
 }
 
 
-void GraphicsItemNode::drawTextPathAtLocation(QPainter * painter, const QPainterPath &textPath, QPointF centre)
+bool GraphicsItemNode::isSimplified(double levelOfDetail) const
+{
+    return g_settings->lodNodeWidth.on && m_width * levelOfDetail < g_settings->lodNodeWidth;
+}
+
+//Adds the node as a polyline of its width (or as a single point when the
+//whole node is smaller than a pixel) without outline, annotations or labels.
+void GraphicsItemNode::addSimplified(SimplifiedItems &items, double levelOfDetail) const
+{
+    QRgb colour = (isSelected() ? g_settings->selectionColour : m_colour).rgba();
+
+    QRectF rect = m_path.controlPointRect();
+    if (std::max(rect.width(), rect.height()) * levelOfDetail < 1.0)
+    {
+        items.nodePoints[colour].push_back(m_linePoints[m_linePoints.size() / 2]);
+        return;
+    }
+
+    items.nodeLines[{ colour, m_width }].addPath(m_path);
+}
+
+
+void DrawnNode::drawTextPathAtLocation(QPainter * painter, const QPainterPath &textPath, QPointF centre)
 {
     QRectF textBoundingRect = textPath.boundingRect();
     double textHeight = textBoundingRect.height();
@@ -300,7 +400,28 @@ void GraphicsItemNode::drawTextPathAtLocation(QPainter * painter, const QPainter
     painter->translate(-centre);
 }
 
-QPainterPath GraphicsItemNode::shape() const
+QPainterPath DrawnNode::copyPath(const QPainterPath &path)
+{
+    //Assigning a QPainterPath only shares the data, adding it to an empty
+    //path copies the elements.
+    QPainterPath copy;
+    copy.addPath(path);
+    copy.setFillRule(path.fillRule());
+    return copy;
+}
+
+QPainterPath DrawnNode::outline() const
+{
+    if (!m_shapeValid)
+    {
+        m_shape = makeShape();
+        m_shapeValid = true;
+    }
+
+    return m_shape;
+}
+
+QPainterPath DrawnNode::makeShape() const
 {
     //If there is only one segment, and it is shorter than half its
     //width, then the arrow head will not be made with 45 degree
@@ -456,6 +577,7 @@ void GraphicsItemNode::fixEdgePaths(std::vector<GraphicsItemNode *> * nodes) con
 void GraphicsItemNode::shiftPoints(QPointF difference)
 {
     prepareGeometryChange();
+    invalidateGeometry();
 
     if (g_settings->nodeDragging == NO_DRAGGING)
         return;
@@ -480,7 +602,7 @@ void GraphicsItemNode::shiftPoints(QPointF difference)
     }
 }
 
-void GraphicsItemNode::remakePath()
+void DrawnNode::remakePath()
 {
     QPainterPath path;
 
@@ -489,6 +611,7 @@ void GraphicsItemNode::remakePath()
         path.lineTo(m_linePoints[i]);
 
     m_path = path;
+    invalidateGeometry();
 }
 
 static QPointF findIntermediatePoint(QPointF p1, QPointF p2, double p1Value, double p2Value, double targetValue) {
@@ -497,98 +620,69 @@ static QPointF findIntermediatePoint(QPointF p1, QPointF p2, double p1Value, dou
     return difference * fraction + p1;
 }
 
-QPainterPath GraphicsItemNode::makePartialPath(double startFraction, double endFraction)
+QPainterPath DrawnNode::makePartialPath(double startFraction, double endFraction) const
 {
     if (endFraction < startFraction)
         std::swap(startFraction, endFraction);
 
+    const auto &lengths = cumulativeLengths();
     double totalLength = getNodePathLength();
 
+    //Skip all segments before the starting fraction and start the path in the
+    //segment that covers it.
     QPainterPath path;
-    bool pathStarted = false;
-    double lengthSoFar = 0.0;
-    for (size_t i = 0; i < m_linePoints.size() - 1; ++i)
+    size_t i = findSegment(startFraction);
+    if (i + 1 >= m_linePoints.size())
+        return path;
+
+    path.moveTo(findIntermediatePoint(m_linePoints[i], m_linePoints[i + 1],
+                                      lengths[i] / totalLength, lengths[i + 1] / totalLength,
+                                      startFraction));
+    for (; i + 1 < m_linePoints.size(); ++i)
     {
         QPointF point1 = m_linePoints[i];
         QPointF point2 = m_linePoints[i + 1];
-        QLineF line(point1, point2);
-
-        double point1Fraction = lengthSoFar / totalLength;
-        lengthSoFar += line.length();
-        double point2Fraction = lengthSoFar / totalLength;
+        double point1Fraction = lengths[i] / totalLength;
+        double point2Fraction = lengths[i + 1] / totalLength;
 
-        //If the path hasn't yet begun and this segment is before
-        //the starting fraction, do nothing.
-        if (!pathStarted && point2Fraction < startFraction)
-            continue;
-
-        //If the path hasn't yet begun but this segment covers the starting
-        //fraction, start the path now.
-        if (!pathStarted && point2Fraction >= startFraction)
+        //If this segment hasn't yet reached the end, just continue the path.
+        if (point2Fraction < endFraction)
         {
-            pathStarted = true;
-            path.moveTo(findIntermediatePoint(point1, point2, point1Fraction, point2Fraction, startFraction));
-        }
-
-        //If the path is in progress and this segment hasn't yet reached the end,
-        //just continue the path.
-        if (pathStarted && point2Fraction < endFraction)
             path.lineTo(point2);
-
-        //If the path is in progress and this segment passes the end, finish the line.
-        if (pathStarted && point2Fraction >= endFraction)
-        {
-            path.lineTo(findIntermediatePoint(point1, point2, point1Fraction, point2Fraction, endFraction));
-            return path;
+            continue;
         }
+
+        //If this segment passes the end, finish the line.
+        path.lineTo(findIntermediatePoint(point1, point2, point1Fraction, point2Fraction, endFraction));
+        return path;
     }
 
     return path;
 }
 
 
-double GraphicsItemNode::getNodePathLength()
+double DrawnNode::getNodePathLength() const
 {
-    double totalLength = 0.0;
-    for (size_t i = 0; i < m_linePoints.size() - 1; ++i)
-    {
-        QLineF line(m_linePoints[i], m_linePoints[i + 1]);
-        totalLength += line.length();
-    }
-    return totalLength;
+    const auto &lengths = cumulativeLengths();
+    return lengths.empty() ? 0.0 : lengths.back();
 }
 
 //This function will find the point that is a certain fraction of the way along the node's path.
-QPointF GraphicsItemNode::findLocationOnPath(double fraction)
+QPointF DrawnNode::findLocationOnPath(double fraction) const
 {
+    const auto &lengths = cumulativeLengths();
     double totalLength = getNodePathLength();
 
-    double lengthSoFar = 0.0;
-    for (size_t i = 0; i < m_linePoints.size() - 1; ++i)
-    {
-        QPointF point1 = m_linePoints[i];
-        QPointF point2 = m_linePoints[i + 1];
-        QLineF line(point1, point2);
-
-        double point1Fraction = lengthSoFar / totalLength;
-        lengthSoFar += line.length();
-        double point2Fraction = lengthSoFar / totalLength;
-
-        //If point2 hasn't yet reached the target, do nothing.
-        if (point2Fraction < fraction)
-            continue;
-
-        //If the path hasn't yet begun but this segment covers the starting
-        //fraction, start the path now.
-        if (point2Fraction >= fraction)
-            return findIntermediatePoint(point1, point2, point1Fraction, point2Fraction, fraction);
-    }
+    size_t i = findSegment(fraction);
+    if (i + 1 >= m_linePoints.size())
+        return {}; //The target point should always be found, but just in case.
 
-    //The code shouldn't get here, as the target point should have been found in the above loop.
-    return {};
+    return findIntermediatePoint(m_linePoints[i], m_linePoints[i + 1],
+                                 lengths[i] / totalLength, lengths[i + 1] / totalLength,
+                                 fraction);
 }
 
-bool GraphicsItemNode::usePositiveNodeColour() const
+bool DrawnNode::usePositiveNodeColour() const
 {
     return !m_hasArrow || m_deBruijnNode->isPositiveNode();
 }
@@ -598,7 +692,7 @@ bool GraphicsItemNode::usePositiveNodeColour() const
 //then there is just one visible centre.  If none of the node is visible, then
 //there are no visible centres.  If multiple parts of the node are visible, then there
 //are multiple visible centres.
-std::vector<QPointF> GraphicsItemNode::getCentres() const
+std::vector<QPointF> DrawnNode::getCentres() const
 {
     std::vector<QPointF> centres;
     std::vector<QPointF> currentRun;
@@ -660,7 +754,7 @@ std::vector<QPointF> GraphicsItemNode::getCentres() const
     return centres;
 }
 
-QLineF GraphicsItemNode::getMedianSegment() const {
+QLineF DrawnNode::getMedianSegment() const {
     // If the number of segments is even, we just return the middle segment:
     // [-----]x[-----]y[-----]
     // Otherwise, we return the centres of two middle segments
@@ -677,7 +771,7 @@ QLineF GraphicsItemNode::getMedianSegment() const {
     }
 }
 
-QStringList GraphicsItemNode::getNodeText() const
+QStringList DrawnNode::getNodeText() const
 {
     QStringList nodeText;
 
@@ -713,10 +807,10 @@ QSize GraphicsItemNode::getNodeTextSize(const QString& text)
 //the node's path, because of the outline.  The selection outline is
 //the largest outline we can expect, so use that to define the bounding
 //rectangle.
-QRectF GraphicsItemNode::boundingRect() const
+QRectF DrawnNode::bounds() const
 {
     double extraSize = g_settings->selectionThickness / 2.0;
-    QRectF bound = shape().boundingRect();
+    QRectF bound = outline().boundingRect();
 
     bound.setTop(bound.top() - extraSize);
     bound.setBottom(bound.bottom() + extraSize);
@@ -731,20 +825,30 @@ QRectF GraphicsItemNode::boundingRect() const
 //This function shifts all the node's points to the left (relative to its
 //direction).  This is used in double mode to prevent nodes from displaying
 //directly on top of their complement nodes.
-void GraphicsItemNode::shiftPointsLeft()
+void DrawnNode::shiftPointsLeft()
 {
     shiftPointSideways(true);
 }
 
-void GraphicsItemNode::shiftPointsRight()
+void DrawnNode::shiftPointsRight()
 {
     shiftPointSideways(false);
 }
 
-void GraphicsItemNode::shiftPointSideways(bool left)
+void GraphicsItemNode::shiftPointsLeft()
+{
+    prepareGeometryChange();
+    DrawnNode::shiftPointsLeft();
+}
+
+void GraphicsItemNode::shiftPointsRight()
 {
     prepareGeometryChange();
+    DrawnNode::shiftPointsRight();
+}
 
+void DrawnNode::shiftPointSideways(bool left)
+{
     //The collection of line points should be at least
     //two large.  But just to be safe, quit now if it
     //is not.
@@ -799,14 +903,14 @@ void GraphicsItemNode::shiftPointSideways(bool left)
 }
 
 
-double GraphicsItemNode::indexToFraction(int64_t pos) const {
+double DrawnNode::indexToFraction(int64_t pos) const {
     return static_cast<double>(pos) / m_deBruijnNode->getLength();
 }
 
 
 //This function outlines and shades the appropriate part of a node if it is
 //in the user-specified path.
-void GraphicsItemNode::exactPathHighlightNode(QPainter * painter)
+void DrawnNode::exactPathHighlightNode(QPainter * painter) const
 {
     if (g_memory->userSpecifiedPath.containsNode(m_deBruijnNode))
         pathHighlightNode2(painter, m_deBruijnNode, false, &g_memory->userSpecifiedPath);
@@ -819,7 +923,7 @@ void GraphicsItemNode::exactPathHighlightNode(QPainter * painter)
 
 //This function outlines and shades the appropriate part of a node if it is
 //in the user-specified path.
-void GraphicsItemNode::queryPathHighlightNode(QPainter * painter)
+void DrawnNode::queryPathHighlightNode(QPainter * painter) const
 {
     if (g_memory->queryPaths.empty())
         return;
@@ -849,14 +953,14 @@ static void pathHighlightNode3(QPainter * painter,
     painter->drawPath(highlightPath);
 }
 
-void GraphicsItemNode::pathHighlightNode2(QPainter * painter,
-                                          DeBruijnNode * node,
-                                          bool reverse,
-                                          Path * path)
+void DrawnNode::pathHighlightNode2(QPainter * painter,
+                                   DeBruijnNode * node,
+                                   bool reverse,
+                                   Path * path) const
 {
     int numberOfTimesInMiddle = path->numberOfOccurrencesInMiddleOfPath(node);
     for (int i = 0; i < numberOfTimesInMiddle; ++i)
-        pathHighlightNode3(painter, shape());
+        pathHighlightNode3(painter, outline());
 
     bool isStartingNode = path->isStartingNode(node);
     bool isEndingNode = path->isEndingNode(node);
@@ -877,9 +981,9 @@ void GraphicsItemNode::pathHighlightNode2(QPainter * painter,
 
 
 
-QPainterPath GraphicsItemNode::buildPartialHighlightPath(double startFraction,
-                                                         double endFraction,
-                                                         bool reverse)
+QPainterPath DrawnNode::buildPartialHighlightPath(double startFraction,
+                                                  double endFraction,
+                                                  bool reverse) const
 {
     if (reverse)
     {
@@ -906,7 +1010,7 @@ QPainterPath GraphicsItemNode::buildPartialHighlightPath(double startFraction,
     QPainterPath highlightPath = stroker.createStroke(partialPath);
 
     if (m_hasArrow)
-        highlightPath = highlightPath.intersected(shape());
+        highlightPath = highlightPath.intersected(outline());
 
     return highlightPath;
 }
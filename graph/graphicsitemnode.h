@@ -33,42 +33,46 @@
 
 class DeBruijnNode;
 class Path;
+struct SimplifiedItems;
 
-class GraphicsItemNode : public QGraphicsItem
+// Geometry and drawing of a node, without any QGraphicsItem state. Graphics
+// items are built on top of it; image export draws these directly.
+class DrawnNode
 {
 public:
-    GraphicsItemNode(DeBruijnNode * deBruijnNode,
-                     GraphicsItemNode * toCopy,
-                     QGraphicsItem * parent = nullptr);
-    GraphicsItemNode(DeBruijnNode * deBruijnNode,
-                     double depthRelativeToMeanDrawnDepth,
-                     const std::vector<QPointF> &linePoints,
-                     QGraphicsItem * parent = nullptr);
-    GraphicsItemNode(DeBruijnNode * deBruijnNode,
-                     double depthRelativeToMeanDrawnDepth,
-                     const adt::SmallPODVector<QPointF> &linePoints,
-                     QGraphicsItem * parent = nullptr);
+    DrawnNode(DeBruijnNode * deBruijnNode, const DrawnNode &toCopy);
+    DrawnNode(DeBruijnNode * deBruijnNode,
+              double depthRelativeToMeanDrawnDepth,
+              const std::vector<QPointF> &linePoints);
+    DrawnNode(DeBruijnNode * deBruijnNode,
+              double depthRelativeToMeanDrawnDepth,
+              const adt::SmallPODVector<QPointF> &linePoints);
 
     DeBruijnNode * m_deBruijnNode;
     adt::SmallPODVector<QPointF> m_linePoints;
-    QColor m_colour;
     QPainterPath m_path;
     float m_width;
-    size_t m_grabIndex : 31;
-    bool m_hasArrow : 1;
+    bool m_hasArrow;
 
-    static QSize getNodeTextSize(const QString& text);
     static float getNodeWidth(double depthRelativeToMeanDrawnDepth,
                               double depthPower,
                               double depthEffectOnWidth,
                               double averageNodeWidth);
     static void drawTextPathAtLocation(QPainter *painter, const QPainterPath& textPath, QPointF centre);
+    // Copy of the path that does not share any data with it. Paint engines
+    // cache data in the path, so a path painted from several threads at once
+    // needs a copy per thread.
+    static QPainterPath copyPath(const QPainterPath &path);
+
+    // Draws the node with its annotations, path highlighting and labels.
+    // Labels are put either at the node centre or at the centres of its
+    // parts visible in the graph view.
+    void draw(QPainter * painter, const QColor &colour, bool selected, bool labelsAtCentre) const;
+    // Node shape, including the arrowhead
+    QPainterPath outline() const;
+    // Outline bounds, enlarged to fit the selection outline
+    QRectF bounds() const;
 
-    void mousePressEvent(QGraphicsSceneMouseEvent * event) override;
-    void mouseMoveEvent(QGraphicsSceneMouseEvent * event) override;
-    void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) override;
-    QPainterPath shape() const override;
-    void shiftPoints(QPointF difference);
     void remakePath();
     bool usePositiveNodeColour() const;
 
@@ -86,24 +90,77 @@ public:
     }
 
     std::vector<QPointF> getCentres() const;
-    void setNodeColour(QColor color) { m_colour = color; }
     QStringList getNodeText() const;
     void setWidth(double depthRelativeToMeanDrawnDepth,
                   double averageNodeWidth = 5.0,
                   double depthPower = 0.5, double depthEffectOnWidth = 0.5);
-    QPainterPath makePartialPath(double startFraction, double endFraction);
-    double getNodePathLength();
-    QPointF findLocationOnPath(double fraction);
-    QRectF boundingRect() const override;
+    QPainterPath makePartialPath(double startFraction, double endFraction) const;
+    double getNodePathLength() const;
+    QPointF findLocationOnPath(double fraction) const;
     void shiftPointsLeft();
     void shiftPointsRight();
-    void fixEdgePaths(std::vector<GraphicsItemNode *> * nodes = nullptr) const;
     double indexToFraction(int64_t pos) const;
 
+protected:
+    void invalidateGeometry();
+
 private:
-    void exactPathHighlightNode(QPainter * painter);
-    void queryPathHighlightNode(QPainter * painter);
-    void pathHighlightNode2(QPainter * painter, DeBruijnNode * node, bool reverse, Path * path);
-    QPainterPath buildPartialHighlightPath(double startFraction, double endFraction, bool reverse);
+    // Outline and path lengths are computed lazily and cached until the
+    // line points or the width change
+    mutable QPainterPath m_shape;
+    mutable bool m_shapeValid = false;
+    mutable std::vector<double> m_cumulativeLengths;
+
+    QPainterPath makeShape() const;
+    const std::vector<double> &cumulativeLengths() const;
+    size_t findSegment(double fraction) const;
+
+    void exactPathHighlightNode(QPainter * painter) const;
+    void queryPathHighlightNode(QPainter * painter) const;
+    void pathHighlightNode2(QPainter * painter, DeBruijnNode * node, bool reverse, Path * path) const;
+    QPainterPath buildPartialHighlightPath(double startFraction, double endFraction, bool reverse) const;
     void shiftPointSideways(bool left);
 };
+
+class GraphicsItemNode : public QGraphicsItem, public DrawnNode
+{
+public:
+    GraphicsItemNode(DeBruijnNode * deBruijnNode,
+                     GraphicsItemNode * toCopy,
+                     QGraphicsItem * parent = nullptr);
+    GraphicsItemNode(DeBruijnNode * deBruijnNode,
+                     double depthRelativeToMeanDrawnDepth,
+                     const std::vector<QPointF> &linePoints,
+                     QGraphicsItem * parent = nullptr);
+    GraphicsItemNode(DeBruijnNode * deBruijnNode,
+                     double depthRelativeToMeanDrawnDepth,
+                     const adt::SmallPODVector<QPointF> &linePoints,
+                     QGraphicsItem * parent = nullptr);
+    ~GraphicsItemNode() override;
+
+    QColor m_colour;
+    size_t m_grabIndex;
+
+    static QSize getNodeTextSize(const QString& text);
+
+    void mousePressEvent(QGraphicsSceneMouseEvent * event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent * event) override;
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) override;
+    QPainterPath shape() const override { return outline(); }
+    QRectF boundingRect() const override { return bounds(); }
+    void shiftPoints(QPointF difference);
+
+    void setNodeColour(QColor color) { m_colour = color; }
+    void setWidth(double depthRelativeToMeanDrawnDepth,
+                  double averageNodeWidth = 5.0,
+                  double depthPower = 0.5, double depthEffectOnWidth = 0.5);
+    void shiftPointsLeft();
+    void shiftPointsRight();
+    void fixEdgePaths(std::vector<GraphicsItemNode *> * nodes = nullptr) const;
+
+    //Below the level-of-detail width the view draws the node only as a
+    //polyline of its width (or as a point, if it is smaller than a pixel)
+    bool isSimplified(double levelOfDetail) const;
+    void addSimplified(SimplifiedItems &items, double levelOfDetail) const;
+};
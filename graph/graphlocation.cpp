@@ -19,6 +19,7 @@
 #include "graphlocation.h"
 
 #include "debruijnnode.h"
+#include "debruijnedge.h"
 #include "assemblygraph.h"
 
 
@@ -102,7 +103,7 @@ void GraphLocation::moveForward(int change)
 
     // If there aren't enough bases left, then we recursively try with the
     // next nodes.
-    for (auto *node : m_node->getDownstreamNodes())
+    for (auto *node : m_node->downstreamNodes())
     {
         GraphLocation nextNodeLocation = GraphLocation::startOfNode(node);
         nextNodeLocation.moveForward(change - basesLeftInNode - 1);
@@ -134,7 +135,7 @@ void GraphLocation::moveBackward(int change)
 
     //If there aren't enough bases left, then we recursively try with the
     //next nodes.
-    for (auto *node : m_node->getUpstreamNodes())
+    for (auto *node : m_node->upstreamNodes())
     {
         GraphLocation nextNodeLocation = GraphLocation::endOfNode(node);
         nextNodeLocation.moveBackward(change - basesLeftInNode - 1);
@@ -24,27 +24,58 @@
 
 #include "program/globals.h"
 #include "program/settings.h"
+#include "program/random.h"
 
 #define TINYCOLORMAP_WITH_QT5
 #include <colormap/tinycolormap.hpp>
 #include "parallel_hashmap/phmap.h"
 
-#include <unordered_set>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+namespace {
+// Colours the nodes concurrently, colours[i] is set to fn(nodes[i])
+template<class Fn>
+void colourConcurrently(llvm::ArrayRef<const DrawnNode *> nodes,
+                        llvm::MutableArrayRef<QColor> colours, Fn &&fn) {
+    assert(nodes.size() == colours.size());
+    QtConcurrent::blockingMap(colours.begin(), colours.end(), [&](QColor &colour) {
+        colour = fn(nodes[&colour - colours.data()]);
+    });
+}
 
-#include <QApplication>
+QColor colourByFraction(double value, double lowValue, double highValue,
+                        tinycolormap::ColormapType map) {
+    float fraction = (value - lowValue) / (highValue - lowValue);
+    return tinycolormap::GetColor(fraction, map).ConvertToQColor();
+}
+}
 
 INodeColorer::INodeColorer(NodeColorScheme scheme)
     : m_graph(g_assemblyGraph), m_scheme(scheme) {
 }
 
-std::pair<QColor, QColor> INodeColorer::get(const GraphicsItemNode *node,
-                                            const GraphicsItemNode *rcNode) {
+std::pair<QColor, QColor> INodeColorer::get(const DrawnNode *node,
+                                            const DrawnNode *rcNode) {
     QColor posColor = this->get(node);
     QColor negColor = rcNode ? this->get(rcNode) : posColor;
 
     return { posColor, negColor };
 }
 
+void INodeColorer::colourAll(llvm::ArrayRef<const DrawnNode *> nodes,
+                             llvm::MutableArrayRef<QColor> colours) {
+    colourConcurrently(nodes, colours, [this](const DrawnNode *node) {
+        return this->get(node);
+    });
+}
+
 std::unique_ptr<INodeColorer> INodeColorer::create(NodeColorScheme scheme) {
     switch (scheme) {
         case UNIFORM_COLOURS:
@@ -70,21 +101,29 @@ std::unique_ptr<INodeColorer> INodeColorer::create(NodeColorScheme scheme) {
     return nullptr;
 }
 
-QColor DepthNodeColorer::get(const GraphicsItemNode *node) {
-    const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
-    double depth = deBruijnNode->getDepth();
+std::pair<double, double> DepthNodeColorer::depthRange() const {
+    if (g_settings->autoDepthValue)
+        return { m_graph->m_firstQuartileDepth, m_graph->m_thirdQuartileDepth };
 
-    double lowValue = g_settings->lowDepthValue, highValue = g_settings->highDepthValue;
-    if (g_settings->autoDepthValue) {
-        lowValue = m_graph->m_firstQuartileDepth;
-        highValue = m_graph->m_thirdQuartileDepth;
-    }
+    return { g_settings->lowDepthValue, g_settings->highDepthValue };
+}
+
+QColor DepthNodeColorer::get(const DrawnNode *node) {
+    auto [lowValue, highValue] = depthRange();
+    return colourByFraction(node->m_deBruijnNode->getDepth(), lowValue, highValue,
+                            colorMap(g_settings->colorMap));
+}
 
-    float fraction = (depth - lowValue) / (highValue - lowValue);
-    return tinycolormap::GetColor(fraction, colorMap(g_settings->colorMap)).ConvertToQColor();
+void DepthNodeColorer::colourAll(llvm::ArrayRef<const DrawnNode *> nodes,
+                                 llvm::MutableArrayRef<QColor> colours) {
+    auto range = depthRange();
+    auto map = colorMap(g_settings->colorMap);
+    colourConcurrently(nodes, colours, [=](const DrawnNode *node) {
+        return colourByFraction(node->m_deBruijnNode->getDepth(), range.first, range.second, map);
+    });
 }
 
-QColor UniformNodeColorer::get(const GraphicsItemNode *node) {
+QColor UniformNodeColorer::get(const DrawnNode *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     if (deBruijnNode->isSpecialNode())
@@ -95,11 +134,16 @@ QColor UniformNodeColorer::get(const GraphicsItemNode *node) {
         return g_settings->uniformNegativeNodeColour;
 }
 
-QColor RandomNodeColorer::get(const GraphicsItemNode *node) {
+RandomNodeColorer::RandomNodeColorer(NodeColorScheme scheme)
+    : INodeColorer(scheme), m_seed(rng::seed()) {
+}
+
+QColor RandomNodeColorer::get(const DrawnNode *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
-    // Make a colour with a random hue.
-    int hue = rand() % 360;
+    // Make a colour with a random hue (derived from the node name, so it is
+    // stable for a given seed).
+    int hue = int(rng::mix(m_seed, deBruijnNode->getNameWithoutSign()) % 360);
     QColor posColour;
     posColour.setHsl(hue,
                      g_settings->randomColourPositiveSaturation,
@@ -118,12 +162,13 @@ QColor RandomNodeColorer::get(const GraphicsItemNode *node) {
     return posColour;
 }
 
-std::pair<QColor, QColor> RandomNodeColorer::get(const GraphicsItemNode *node, const GraphicsItemNode *rcNode) {
+std::pair<QColor, QColor> RandomNodeColorer::get(const DrawnNode *node, const DrawnNode *rcNode) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
-    // Make a colour with a random hue.  Assign a colour to both this node and
+    // Make a colour with a random hue (derived from the node name, so it is
+    // stable for a given seed).  Assign a colour to both this node and
     // its complement so their hue matches.
-    int hue = rand() % 360;
+    int hue = int(rng::mix(m_seed, deBruijnNode->getNameWithoutSign()) % 360);
     QColor posColour;
     posColour.setHsl(hue,
                      g_settings->randomColourPositiveSaturation,
@@ -142,76 +187,14 @@ std::pair<QColor, QColor> RandomNodeColorer::get(const GraphicsItemNode *node, c
     return { posColour, negColour };
 }
 
-QColor GrayNodeColorer::get(const GraphicsItemNode *node) {
+QColor GrayNodeColorer::get(const DrawnNode *node) {
     return g_settings->grayColor;
 }
 
-QColor CustomNodeColorer::get(const GraphicsItemNode *node) {
+QColor CustomNodeColorer::get(const DrawnNode *node) {
     return m_graph->getCustomColourForDisplay(node->m_deBruijnNode);;
 }
 
-// This function differs from the above by including all reverse complement
-// nodes in the path search.
-static std::vector<DeBruijnNode *>
-getNodesCommonToAllPaths(std::vector< std::vector <DeBruijnNode *> > &paths,
-                         bool includeReverseComplements) {
-    std::vector<DeBruijnNode *> commonNodes;
-
-    //If there are no paths, then return the empty vector.
-    if (paths.empty())
-        return commonNodes;
-
-    //If there is only one path in path, then they are all common nodes
-    commonNodes = paths[0];
-    if (paths.size() == 1)
-        return commonNodes;
-
-    //If there are two or more paths, it's necessary to find the intersection.
-    for (size_t i = 1; i < paths.size(); ++i) {
-        QApplication::processEvents();
-        std::vector<DeBruijnNode *> *path = &paths[i];
-
-        // If we are including reverse complements in the search,
-        // then it is necessary to build a new vector that includes
-        // reverse complement nodes and then use that vector.
-        std::vector<DeBruijnNode *> pathWithReverseComplements;
-        if (includeReverseComplements) {
-            for (auto *node : *path) {
-                pathWithReverseComplements.push_back(node);
-                pathWithReverseComplements.push_back(node->getReverseComplement());
-            }
-            path = &pathWithReverseComplements;
-        }
-
-        // Combine the commonNodes vector with the path vector,
-        // excluding any repeats.
-        std::sort(commonNodes.begin(), commonNodes.end());
-        std::sort(path->begin(), path->end());
-        std::vector<DeBruijnNode *> newCommonNodes;
-        std::set_intersection(commonNodes.begin(), commonNodes.end(), path->begin(), path->end(), std::back_inserter(newCommonNodes));
-        commonNodes = newCommonNodes;
-    }
-
-    return commonNodes;
-}
-
-
-// This function checks whether this node has any path leading outward that
-// unambiguously leads to the given node.
-// It checks a number of steps as set by the contiguitySearchSteps setting.
-// If includeReverseComplement is true, then this function returns true if
-// all paths lead either to the node or its reverse complement node.
-static bool doesPathLeadOnlyToNode(DeBruijnNode *sNode, const DeBruijnNode *tNode, bool includeReverseComplement) {
-    for (auto *edge : sNode->edges()) {
-        bool outgoingEdge = (sNode == edge->getStartingNode());
-        if (edge->leadsOnlyToNode(outgoingEdge, g_settings->contiguitySearchSteps, tNode,
-                                  { sNode }, includeReverseComplement))
-            return true;
-    }
-
-    return false;
-}
-
 ContiguityStatus ContiguityNodeColorer::getContiguityStatus(const DeBruijnNode* node) const {
     auto it = m_nodeStatuses.find(node);
     if (it == m_nodeStatuses.end())
@@ -220,86 +203,7 @@ ContiguityStatus ContiguityNodeColorer::getContiguityStatus(const DeBruijnNode*
     return it->second;
 }
 
-//This function only upgrades a node's status, never downgrades.
-void ContiguityNodeColorer::upgradeContiguityStatus(const DeBruijnNode *node,
-                                                    ContiguityStatus newStatus) {
-    auto &status = m_nodeStatuses[node];
-    if (newStatus > status)
-        status = newStatus;
-}
-
-// This function determines the contiguity of nodes relative to this one.
-// It has two steps:
-// -First, for each edge leaving this node, all paths outward are found.
-//  Any nodes in any path are MAYBE_CONTIGUOUS, and nodes in all of the
-//  paths are CONTIGUOUS.
-// -Second, it is necessary to check in the opposite direction - for each
-//  of the MAYBE_CONTIGUOUS nodes, do they have a path that unambiguously
-//  leads to this node?  If so, then they are CONTIGUOUS.
-void ContiguityNodeColorer::determineContiguity(DeBruijnNode* node) {
-    upgradeContiguityStatus(node, STARTING);
-
-    //A set is used to store all nodes found in the paths, as the nodes
-    //that show up as MAYBE_CONTIGUOUS will have their paths checked
-    //to this node.
-    std::set<DeBruijnNode *> allCheckedNodes;
-
-    //For each path leaving this node, find all possible paths
-    //outward.  Nodes in any of the paths for an edge are
-    //MAYBE_CONTIGUOUS.  Nodes in all of the paths for an edge
-    //are CONTIGUOUS.
-    for (auto edge : node->edges()) {
-        bool outgoingEdge = (node == edge->getStartingNode());
-
-        std::vector<std::vector<DeBruijnNode *>> allPaths;
-        edge->tracePaths(outgoingEdge, g_settings->contiguitySearchSteps, allPaths, node);
-
-        // Set all nodes in the paths as MAYBE_CONTIGUOUS
-        for (auto &path : allPaths) {
-            QApplication::processEvents();
-            for (auto *pNode : path) {
-                upgradeContiguityStatus(pNode, MAYBE_CONTIGUOUS);
-                allCheckedNodes.insert(node);
-            }
-        }
-
-        // Set all common nodes as CONTIGUOUS_STRAND_SPECIFIC
-        for (auto *pNode : getNodesCommonToAllPaths(allPaths, false))
-            upgradeContiguityStatus(pNode, CONTIGUOUS_STRAND_SPECIFIC);
-
-        // Set all common nodes (when including reverse complement nodes)
-        // as CONTIGUOUS_EITHER_STRAND
-        for (auto *pNode : getNodesCommonToAllPaths(allPaths, true)) {
-            upgradeContiguityStatus(pNode, CONTIGUOUS_EITHER_STRAND);
-            upgradeContiguityStatus(pNode->getReverseComplement(), CONTIGUOUS_EITHER_STRAND);
-        }
-    }
-
-    //For each node that was checked, then we check to see if any
-    //of its paths leads unambiuously back to the starting node (this node).
-    for (auto *cNode : allCheckedNodes) {
-        QApplication::processEvents();
-        ContiguityStatus status = getContiguityStatus(cNode);
-
-        //First check without reverse complement target for
-        //strand-specific contiguity.
-        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
-            doesPathLeadOnlyToNode(cNode, node, false))
-            upgradeContiguityStatus(cNode, CONTIGUOUS_STRAND_SPECIFIC);
-
-        //Now check including the reverse complement target for
-        //either strand contiguity.
-        if (status != CONTIGUOUS_STRAND_SPECIFIC &&
-            status != CONTIGUOUS_EITHER_STRAND &&
-            doesPathLeadOnlyToNode(cNode, node, true)) {
-            upgradeContiguityStatus(cNode, CONTIGUOUS_EITHER_STRAND);
-            upgradeContiguityStatus(cNode->getReverseComplement(), CONTIGUOUS_EITHER_STRAND);
-        }
-    }
-}
-
-
-QColor ContiguityNodeColorer::get(const GraphicsItemNode *node) {
+QColor ContiguityNodeColorer::get(const DrawnNode *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     // For single nodes, display the colour of whichever of the
@@ -325,100 +229,140 @@ QColor ContiguityNodeColorer::get(const GraphicsItemNode *node) {
     }
 }
 
-QColor GCNodeColorer::get(const GraphicsItemNode *node) {
-    const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
-    float lowValue = 0.2, highValue = 0.8, value = deBruijnNode->getGC();
-    float fraction = (value - lowValue) / (highValue - lowValue);
-    return tinycolormap::GetColor(fraction, colorMap(g_settings->colorMap)).ConvertToQColor();
+QColor GCNodeColorer::get(const DrawnNode *node) {
+    return colourByFraction(node->m_deBruijnNode->getGC(), 0.2, 0.8,
+                            colorMap(g_settings->colorMap));
+}
+
+void GCNodeColorer::colourAll(llvm::ArrayRef<const DrawnNode *> nodes,
+                              llvm::MutableArrayRef<QColor> colours) {
+    auto map = colorMap(g_settings->colorMap);
+    colourConcurrently(nodes, colours, [=](const DrawnNode *node) {
+        return colourByFraction(node->m_deBruijnNode->getGC(), 0.2, 0.8, map);
+    });
 }
 
-QColor TagValueNodeColorer::get(const GraphicsItemNode *node) {
+QColor TagValueNodeColorer::get(const DrawnNode *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
-    auto tags = m_graph->m_nodeTags.find(deBruijnNode);
-    if (tags != m_graph->m_nodeTags.end()) {
-        if (auto tag = gfa::getTag(m_tagName.c_str(), tags->second)) {
-            std::stringstream stream;
-            stream << *tag;
-            return m_allTags.at(stream.str());
-        }
+    if (m_tagColours) {
+        auto it = m_tagColours->find(deBruijnNode);
+        if (it != m_tagColours->end())
+            return it->second;
     }
 
     return m_graph->getCustomColourForDisplay(deBruijnNode);
 }
 
+void TagValueNodeColorer::setTagName(const std::string &tagName) {
+    m_tagName = tagName;
+    auto it = m_nodeColours.find(m_tagName);
+    m_tagColours = it == m_nodeColours.end() ? nullptr : &it->second;
+}
+
 void TagValueNodeColorer::reset() {
-    m_allTags.clear();
-    m_tagNames.clear();
+    m_nodeColours.clear();
 
-    // Collect all tags and their corresponding values
+    // Collect the distinct values of every tag. Values are compared as they
+    // were parsed, so numbers are ordered by value.
+    using TagValue = decltype(gfa::tag::val);
+    std::unordered_map<std::string, std::map<TagValue, QColor>> tagValues;
     for (const auto &entry : m_graph->m_nodeTags) {
-        for (const auto &tag: entry.second) {
-            std::stringstream stream;
-            stream << tag;
-            std::string tagWithValue = stream.str();
-            std::string tagName{std::string_view(tag.name, 2)};
-            m_allTags.insert(tagWithValue, QColor());
-            m_tagNames.insert(tagName);
-        }
+        for (const auto &tag: entry.second)
+            tagValues[std::string(tag.name, 2)].try_emplace(tag.val);
     }
 
     // Assign colors
-    for (const auto &tagName : m_tagNames) {
-        auto tagRange = m_allTags.equal_prefix_range(tagName);
-        size_t sz = std::distance(tagRange.first, tagRange.second), i = 0;
-        for (auto it = tagRange.first; it != tagRange.second; ++it) {
-            *it = tinycolormap::GetColor(double(i) / double(sz),
-                                         colorMap(g_settings->colorMap)).ConvertToQColor();
+    auto map = colorMap(g_settings->colorMap);
+    for (auto &entry : tagValues) {
+        size_t sz = entry.second.size(), i = 0;
+        for (auto &value : entry.second) {
+            value.second = tinycolormap::GetColor(double(i) / double(sz), map).ConvertToQColor();
             i += 1;
         }
     }
 
-    if (!m_tagNames.empty())
-        m_tagName = *m_tagNames.begin();
+    // Remember the colour of every node in the graph. Only the first tag of a
+    // given name counts, same as for gfa::getTag()
+    for (const auto *node : m_graph->m_deBruijnGraphNodes) {
+        auto tags = m_graph->m_nodeTags.find(node);
+        if (tags == m_graph->m_nodeTags.end())
+            continue;
+
+        for (const auto &tag: tags->second) {
+            std::string tagName(tag.name, 2);
+            m_nodeColours[tagName].try_emplace(node, tagValues[tagName].at(tag.val));
+        }
+    }
+
+    // Keep the current tag if it is still there
+    if (!m_nodeColours.empty() && !m_nodeColours.count(m_tagName))
+        m_tagName = m_nodeColours.begin()->first;
+    setTagName(m_tagName);
 }
 
-QColor CSVNodeColorer::get(const GraphicsItemNode *node) {
+QColor CSVNodeColorer::get(const DrawnNode *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
+    const CsvData &csvData = m_graph->m_csvData;
 
-    auto val = m_graph->getCsvLine(deBruijnNode, m_colIdx);
-    if (!val || m_colIdx >= m_colors.size())
+    auto row = csvData.nodeRow(deBruijnNode);
+    if (!row || m_colIdx >= csvData.columnCount())
         return m_graph->getCustomColourForDisplay(deBruijnNode);
 
-    const auto &cols = m_colors[m_colIdx];
-    auto col = cols.find(val->toStdString());
-    if (col == cols.end())
+    uint32_t value = csvData.column(m_colIdx).rows[*row];
+    if (value >= m_valueColours.size() || !m_valueColours[value].isValid())
         return m_graph->getCustomColourForDisplay(deBruijnNode);
 
-    return *col;;
+    return m_valueColours[value];
 }
 
-void CSVNodeColorer::reset() {
-    m_colors.clear();
-
-    size_t columns = m_graph->m_csvHeaders.size();
-    m_colors.resize(columns);
-    // Store all unique values into a map
-    for (const auto &entry : m_graph->m_nodeCSVData) {
-        const auto &row = entry.second;
-        for (size_t i = 0; i < row.size() && i < columns; ++i) {
-            const auto &cell = row[i];
-            m_colors[i].insert(cell.toStdString(), QColor(cell));
+void CSVNodeColorer::setColumnIdx(unsigned idx) {
+    m_colIdx = idx;
+    m_valueColours.clear();
+
+    const CsvData &csvData = m_graph->m_csvData;
+    if (m_colIdx >= csvData.columnCount())
+        return;
+
+    const auto &column = csvData.column(m_colIdx);
+    auto map = colorMap(g_settings->colorMap);
+    m_valueColours.resize(column.values.size());
+    if (column.type == CsvData::ColumnType::NUMBER) {
+        // Numbers are coloured by value, empty values are not coloured
+        double lowValue = std::numeric_limits<double>::max(), highValue = std::numeric_limits<double>::lowest();
+        for (double number : column.numbers) {
+            if (std::isnan(number))
+                continue;
+            lowValue = std::min(lowValue, number);
+            highValue = std::max(highValue, number);
         }
-    }
+        if (highValue <= lowValue)
+            highValue = lowValue + 1;
 
-    // Assign all invalid colors according to colormap
-    for (auto &column : m_colors) {
-        size_t invalid = 0;
-        for (const auto &entry : column)
-            invalid += !entry.isValid();
-        size_t i = 0;
-        for (auto &entry : column) {
-            if (entry.isValid())
-                continue;
-            entry = tinycolormap::GetColor(double(i) / double(invalid),
-                                           colorMap(g_settings->colorMap)).ConvertToQColor();
-            i += 1;
+        for (size_t i = 0; i < column.numbers.size(); ++i) {
+            if (!std::isnan(column.numbers[i]))
+                m_valueColours[i] = colourByFraction(column.numbers[i], lowValue, highValue, map);
         }
+        return;
+    }
+
+    // Values that are colours keep them, the others are given colours from
+    // the colormap in sorted order
+    std::vector<uint32_t> uncoloured;
+    for (uint32_t i = 0; i < column.values.size(); ++i) {
+        if (column.colours[i].isValid())
+            m_valueColours[i] = column.colours[i];
+        else
+            uncoloured.push_back(i);
     }
+
+    std::sort(uncoloured.begin(), uncoloured.end(),
+              [&column](uint32_t a, uint32_t b) { return column.values[a] < column.values[b]; });
+    for (size_t i = 0; i < uncoloured.size(); ++i)
+        m_valueColours[uncoloured[i]] = tinycolormap::GetColor(double(i) / double(uncoloured.size()),
+                                                              map).ConvertToQColor();
+}
+
+void CSVNodeColorer::reset() {
+    setColumnIdx(m_colIdx);
 }
@@ -17,11 +17,13 @@
 
 #pragma once
 
+#include "llvm/ADT/ArrayRef.h"
+
 #include <QColor>
 #include <QSharedPointer>
 
 class AssemblyGraph;
-class GraphicsItemNode;
+class DrawnNode;
 
 // This needs to be synchronizes with selection combo box!
 enum NodeColorScheme : int {
@@ -42,9 +44,13 @@ public:
     explicit INodeColorer(NodeColorScheme scheme);
     virtual ~INodeColorer() = default;
 
-    [[nodiscard]] virtual QColor get(const GraphicsItemNode *node) = 0;
-    [[nodiscard]] virtual std::pair<QColor, QColor> get(const GraphicsItemNode *node,
-                                                        const GraphicsItemNode *rcNode);
+    [[nodiscard]] virtual QColor get(const DrawnNode *node) = 0;
+    [[nodiscard]] virtual std::pair<QColor, QColor> get(const DrawnNode *node,
+                                                        const DrawnNode *rcNode);
+    // Colours many nodes at once, colours[i] is set to the colour of nodes[i].
+    // Nodes are coloured concurrently, so get() must not modify the colorer.
+    virtual void colourAll(llvm::ArrayRef<const DrawnNode *> nodes,
+                           llvm::MutableArrayRef<QColor> colours);
     virtual void reset() {};
     [[nodiscard]] virtual const char* name() const = 0;
 
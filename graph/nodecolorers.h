@@ -20,42 +20,58 @@
 #include "nodecolorer.h"
 #include "contiguity.h"
 
-#include <tsl/htrie_map.h>
+#include "parallel_hashmap/phmap.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <unordered_set>
 #include <unordered_map>
 
 class DepthNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
+    void colourAll(llvm::ArrayRef<const DrawnNode *> nodes,
+                   llvm::MutableArrayRef<QColor> colours) override;
     [[nodiscard]] const char* name() const override { return "Color by depth"; };
+
+private:
+    // Depths mapped to the ends of the colormap
+    [[nodiscard]] std::pair<double, double> depthRange() const;
 };
 
 class UniformNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
     [[nodiscard]] const char* name() const override { return "Uniform color"; };
 };
 
 class RandomNodeColorer : public INodeColorer {
 public:
-    using INodeColorer::INodeColorer;
+    explicit RandomNodeColorer(NodeColorScheme scheme);
 
-    QColor get(const GraphicsItemNode *node) override;
-    [[nodiscard]] std::pair<QColor, QColor> get(const GraphicsItemNode *node,
-                                                const GraphicsItemNode *rcNode) override;
+    QColor get(const DrawnNode *node) override;
+    [[nodiscard]] std::pair<QColor, QColor> get(const DrawnNode *node,
+                                                const DrawnNode *rcNode) override;
     [[nodiscard]] const char* name() const override { return "Random colors"; };
+
+    // Hues are derived from the seed and the node names. The seed defaults to
+    // the session seed; a fresh one gives a new set of colours.
+    void setSeed(uint64_t seed) { m_seed = seed; }
+    [[nodiscard]] uint64_t seed() const { return m_seed; }
+
+private:
+    uint64_t m_seed;
 };
 
 class GrayNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
     [[nodiscard]] const char* name() const override { return "Gray colors"; };
 };
 
@@ -63,7 +79,7 @@ class CustomNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
     [[nodiscard]] const char* name() const override { return "Custom colors"; };
 };
 
@@ -76,22 +92,22 @@ public:
     void reset() override { return m_nodeStatuses.clear(); }
     bool empty() const { return m_nodeStatuses.empty(); }
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
     [[nodiscard]] const char* name() const override { return "Color by contiguity"; };
 
-    void determineContiguity(DeBruijnNode*);
     ContiguityStatus getContiguityStatus(const DeBruijnNode*) const;
-    void upgradeContiguityStatus(const DeBruijnNode *node,
-                                 ContiguityStatus newStatus);
 
-    std::unordered_map<const DeBruijnNode*, ContiguityStatus> m_nodeStatuses;
+    // Filled in by contiguity::determine()
+    ContiguityStatuses m_nodeStatuses;
 };
 
 class GCNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
+    void colourAll(llvm::ArrayRef<const DrawnNode *> nodes,
+                   llvm::MutableArrayRef<QColor> colours) override;
     [[nodiscard]] const char* name() const override { return "Color by GC content"; };
 };
 
@@ -103,21 +119,28 @@ public:
             TagValueNodeColorer::reset();
     }
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
     void reset() override;
     [[nodiscard]] const char* name() const override { return "Color by tag value"; };
 
-    void setTagName(const std::string &tagName) { m_tagName = tagName; }
+    void setTagName(const std::string &tagName);
     [[nodiscard]] auto tagNames() const {
-        std::vector<std::string> names(m_tagNames.begin(), m_tagNames.end());
+        std::vector<std::string> names;
+        for (const auto &entry : m_nodeColours)
+            names.push_back(entry.first);
         std::sort(names.begin(), names.end());
         return names;
     }
 
 private:
+    using NodeColours = phmap::flat_hash_map<const DeBruijnNode *, QColor>;
+
     std::string m_tagName = "";
-    tsl::htrie_map<char, QColor> m_allTags;
-    std::unordered_set<std::string> m_tagNames;
+    // Colour of every tagged node for each tag name, so colouring a node
+    // does not need to format and look up its tag value. Nodes are keyed by
+    // address, so this has to be rebuilt by reset() once the graph is edited.
+    std::unordered_map<std::string, NodeColours> m_nodeColours;
+    const NodeColours *m_tagColours = nullptr;
 };
 
 class CSVNodeColorer : public INodeColorer {
@@ -127,13 +150,15 @@ public:
         if (m_graph)
             CSVNodeColorer::reset();
     }
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const DrawnNode *node) override;
     void reset() override;
     [[nodiscard]] const char* name() const override { return "Color by CSV columns"; };
 
-    void setColumnIdx(unsigned idx) { m_colIdx = idx; }
+    void setColumnIdx(unsigned idx);
 
 private:
     unsigned m_colIdx = 0;
-    std::vector<tsl::htrie_map<char, QColor>> m_colors;
+    // Colours of the distinct values of the current column, invalid for the
+    // values that are not coloured
+    std::vector<QColor> m_valueColours;
 };
@@ -0,0 +1,182 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "nodenameindex.h"
+
+#include <algorithm>
+
+// Suffix array construction by induced sorting (SA-IS), linear in the text
+// length. s contains values in [0, upper].
+static std::vector<int> suffixArray(const std::vector<int> &s, int upper) {
+    int n = int(s.size());
+    if (n == 0)
+        return {};
+    if (n == 1)
+        return { 0 };
+    if (n == 2)
+        return s[0] < s[1] ? std::vector<int>{ 0, 1 } : std::vector<int>{ 1, 0 };
+
+    std::vector<int> sa(n);
+    // S-type (true) or L-type (false) suffixes
+    std::vector<bool> ls(n);
+    for (int i = n - 2; i >= 0; --i)
+        ls[i] = s[i] == s[i + 1] ? ls[i + 1] : s[i] < s[i + 1];
+
+    // Bucket boundaries: sumL[c] is the start of bucket c, sumS[c] is the
+    // start of the S-type part of bucket c
+    std::vector<int> sumL(upper + 1), sumS(upper + 1);
+    for (int i = 0; i < n; ++i) {
+        if (!ls[i])
+            sumS[s[i]]++;
+        else
+            sumL[s[i] + 1]++;
+    }
+    for (int i = 0; i <= upper; ++i) {
+        sumS[i] += sumL[i];
+        if (i < upper)
+            sumL[i + 1] += sumS[i];
+    }
+
+    auto induce = [&](const std::vector<int> &lms) {
+        std::fill(sa.begin(), sa.end(), -1);
+        std::vector<int> buf(upper + 1);
+        std::copy(sumS.begin(), sumS.end(), buf.begin());
+        for (int d : lms) {
+            if (d == n)
+                continue;
+            sa[buf[s[d]]++] = d;
+        }
+        std::copy(sumL.begin(), sumL.end(), buf.begin());
+        sa[buf[s[n - 1]]++] = n - 1;
+        for (int i = 0; i < n; ++i) {
+            int v = sa[i];
+            if (v >= 1 && !ls[v - 1])
+                sa[buf[s[v - 1]]++] = v - 1;
+        }
+        std::copy(sumL.begin(), sumL.end(), buf.begin());
+        for (int i = n - 1; i >= 0; --i) {
+            int v = sa[i];
+            if (v >= 1 && ls[v - 1])
+                sa[--buf[s[v - 1] + 1]] = v - 1;
+        }
+    };
+
+    std::vector<int> lmsMap(n + 1, -1), lms;
+    int m = 0;
+    for (int i = 1; i < n; ++i) {
+        if (!ls[i - 1] && ls[i])
+            lmsMap[i] = m++;
+    }
+    lms.reserve(m);
+    for (int i = 1; i < n; ++i) {
+        if (!ls[i - 1] && ls[i])
+            lms.push_back(i);
+    }
+
+    induce(lms);
+
+    if (m) {
+        // Name the sorted LMS substrings and sort them recursively
+        std::vector<int> sortedLms;
+        sortedLms.reserve(m);
+        for (int v : sa) {
+            if (lmsMap[v] != -1)
+                sortedLms.push_back(v);
+        }
+
+        std::vector<int> recS(m);
+        int recUpper = 0;
+        recS[lmsMap[sortedLms[0]]] = 0;
+        for (int i = 1; i < m; ++i) {
+            int l = sortedLms[i - 1], r = sortedLms[i];
+            int endL = lmsMap[l] + 1 < m ? lms[lmsMap[l] + 1] : n;
+            int endR = lmsMap[r] + 1 < m ? lms[lmsMap[r] + 1] : n;
+            bool same = true;
+            if (endL - l != endR - r)
+                same = false;
+            else {
+                while (l < endL && s[l] == s[r]) {
+                    ++l;
+                    ++r;
+                }
+                if (l == n || s[l] != s[r])
+                    same = false;
+            }
+            if (!same)
+                ++recUpper;
+            recS[lmsMap[sortedLms[i]]] = recUpper;
+        }
+
+        auto recSa = suffixArray(recS, recUpper);
+        for (int i = 0; i < m; ++i)
+            sortedLms[i] = lms[recSa[i]];
+        induce(sortedLms);
+    }
+
+    return sa;
+}
+
+void NodeNameIndex::clear() {
+    m_built = false;
+    m_text.clear();
+    m_suffixArray.clear();
+    m_nameStarts.clear();
+    m_nodes.clear();
+}
+
+void NodeNameIndex::buildSuffixArray() {
+    // Shift the bytes, so the name separator is the smallest character
+    std::vector<int> s(m_text.size());
+    for (size_t i = 0; i < m_text.size(); ++i)
+        s[i] = m_text[i] == '\0' ? 0 : int((unsigned char)m_text[i]);
+
+    std::vector<int> sa = suffixArray(s, 255);
+    m_suffixArray.assign(sa.begin(), sa.end());
+}
+
+std::vector<DeBruijnNode *> NodeNameIndex::find(std::string_view pattern) const {
+    if (pattern.empty())
+        return m_nodes;
+
+    // Suffixes starting with the pattern form a contiguous range. Patterns
+    // never contain NUL, so every match lies within a single name.
+    std::string_view text(m_text);
+    auto prefix = [&](uint32_t pos) {
+        return text.substr(pos, pattern.size());
+    };
+    auto lo = std::partition_point(m_suffixArray.begin(), m_suffixArray.end(),
+                                   [&](uint32_t pos) { return prefix(pos) < pattern; });
+    auto hi = std::partition_point(lo, m_suffixArray.end(),
+                                   [&](uint32_t pos) { return prefix(pos) == pattern; });
+
+    std::vector<uint32_t> hits;
+    hits.reserve(hi - lo);
+    for (auto it = lo; it != hi; ++it)
+        hits.push_back(uint32_t(std::upper_bound(m_nameStarts.begin(), m_nameStarts.end(), *it) -
+                                m_nameStarts.begin() - 1));
+
+    // A name could contain the pattern several times
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+    std::vector<DeBruijnNode *> result;
+    result.reserve(hits.size());
+    for (uint32_t hit : hits)
+        result.push_back(m_nodes[hit]);
+
+    return result;
+}
@@ -0,0 +1,64 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class DeBruijnNode;
+
+// Substring index over node names: a suffix array over all names
+// concatenated (each followed by a NUL). Finding all names containing a
+// pattern is a binary search over the suffixes, i.e. O(|pattern| log N + hits)
+// instead of scanning every name.
+class NodeNameIndex {
+public:
+    // Names are expected in the order results should be reported in
+    template<class NodeMap>
+    void build(const NodeMap &nodes) {
+        clear();
+        std::string name;
+        for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+            it.key(name);
+            m_nameStarts.push_back(uint32_t(m_text.size()));
+            m_nodes.push_back(it.value());
+            m_text += name;
+            m_text += '\0';
+        }
+        buildSuffixArray();
+        m_built = true;
+    }
+
+    void clear();
+    [[nodiscard]] bool isBuilt() const { return m_built; }
+
+    // Returns the nodes whose name contains the pattern, each node once and
+    // in the order of build()
+    [[nodiscard]] std::vector<DeBruijnNode *> find(std::string_view pattern) const;
+
+private:
+    void buildSuffixArray();
+
+    bool m_built = false;
+    std::string m_text;
+    std::vector<uint32_t> m_suffixArray;
+    std::vector<uint32_t> m_nameStarts;
+    std::vector<DeBruijnNode *> m_nodes;
+};
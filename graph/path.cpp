@@ -25,6 +25,7 @@
 #include <QRegularExpression>
 #include <QStringList>
 #include <QApplication>
+#include <algorithm>
 #include <limits>
 #include <unordered_set>
 
@@ -367,50 +368,94 @@ bool Path::checkForOtherEdges() {
 
 
 
-//This function extracts the sequence for the whole path.  It uses the overlap
-//value in the edges to remove sequences that are duplicated at the end of one
-//node and the start of the next.
-QByteArray Path::getPathSequence() const
+//This function splits the sequence for the whole path into pieces of the
+//node sequences.  It uses the overlap value in the edges to remove sequences
+//that are duplicated at the end of one node and the start of the next.
+std::vector<Path::SequencePiece> Path::getSequencePieces() const
 {
+    std::vector<SequencePiece> pieces;
     if (m_nodes.empty())
-        return "";
+        return pieces;
+
+    pieces.reserve(m_nodes.size());
 
-    QByteArray sequence;
-    QByteArray firstNodeSequence = utils::sequenceToQByteArray(m_nodes[0]->getSequence());
+    //Positive overlaps trim bases from the start of the node (unless the node
+    //is shorter than the overlap), negative ones add Ns.
+    auto addNode = [&](const DeBruijnNode *node, int overlap) {
+        SequencePiece piece{ 0, node, 0, node->getSequence().size() };
+        if (overlap > 0 && size_t(overlap) <= piece.to)
+            piece.from = overlap;
+        else if (overlap < 0)
+            piece.ns = -overlap;
+        pieces.push_back(piece);
+    };
 
     //If the path is circular, we trim the overlap from the first node.
     if (isCircular())
-    {
-        int overlap = m_edges.back()->getOverlap();
-        if (overlap != 0)
-            firstNodeSequence = utils::modifySequenceUsingOverlap(firstNodeSequence, overlap);
-        sequence += firstNodeSequence;
-    }
+        addNode(m_nodes[0], m_edges.back()->getOverlap());
 
     //If the path is linear, then we begin either with the entire first node
     //sequence or part of it.
     else
     {
-        int rightChars = firstNodeSequence.length() - m_startLocation.getPosition() + 1;
-        sequence += firstNodeSequence.right(rightChars);
+        size_t size = m_nodes[0]->getSequence().size();
+        long long rightChars = (long long)size - m_startLocation.getPosition() + 1;
+        rightChars = std::clamp<long long>(rightChars, 0, size);
+        pieces.push_back({ 0, m_nodes[0], size - size_t(rightChars), size });
     }
 
     //The middle nodes are not affected by whether or not the path is circular
     //or has partial node ends.
-    for (int i = 1; i < m_nodes.size(); ++i)
-    {
-        int overlap = m_edges[i-1]->getOverlap();
-        QByteArray nodeSequence = utils::sequenceToQByteArray(m_nodes[i]->getSequence());
-        if (overlap != 0)
-            nodeSequence = utils::modifySequenceUsingOverlap(nodeSequence, overlap);
-        sequence += nodeSequence;
-    }
+    for (size_t i = 1; i < m_nodes.size(); ++i)
+        addNode(m_nodes[i], m_edges[i-1]->getOverlap());
 
+    size_t length = 0;
+    for (const auto &piece : pieces)
+        length += piece.ns + piece.to - piece.from;
+
+    //Trim the end of the last node, possibly spanning several pieces.
     DeBruijnNode * lastNode = m_nodes.back();
-    int amountToTrimFromEnd = lastNode->getLength() - m_endLocation.getPosition();
-    sequence.chop(amountToTrimFromEnd);
+    long long amountToTrimFromEnd = (long long)lastNode->getLength() - m_endLocation.getPosition();
+    size_t toTrim = std::clamp<long long>(amountToTrimFromEnd, 0, length);
+    while (toTrim > 0) {
+        SequencePiece &piece = pieces.back();
+        size_t fromSequence = std::min(toTrim, piece.to - piece.from);
+        piece.to -= fromSequence;
+        toTrim -= fromSequence;
+
+        size_t fromNs = std::min(toTrim, piece.ns);
+        piece.ns -= fromNs;
+        toTrim -= fromNs;
 
-    return sequence;
+        if (toTrim > 0)
+            pieces.pop_back();
+    }
+
+    return pieces;
+}
+
+//This function extracts the sequence for the whole path. The pieces are
+//copied in 2-bit form into a single buffer.
+Sequence Path::getSequence() const
+{
+    std::vector<SequencePiece> pieces = getSequencePieces();
+
+    size_t length = 0;
+    for (const auto &piece : pieces)
+        length += piece.ns + piece.to - piece.from;
+
+    SequenceBuilder builder(length);
+    for (const auto &piece : pieces) {
+        builder.appendNs(piece.ns);
+        builder.append(piece.node->getSequence(), piece.from, piece.to);
+    }
+
+    return builder.build();
+}
+
+QByteArray Path::getPathSequence() const
+{
+    return utils::sequenceToQByteArray(getSequence());
 }
 
 int Path::getLength() const {
@@ -520,8 +565,8 @@ bool Path::canNodeFitOnEnd(DeBruijnNode * node, Path * extendedPath) const {
         return false;
 
     DeBruijnNode * lastNode = m_nodes.back();
-    for (auto *edge : lastNode->edges()) {
-        if (edge->getStartingNode() == lastNode && edge->getEndingNode() == node) {
+    for (auto *edge : lastNode->leavingEdges()) {
+        if (edge->getEndingNode() == node) {
             *extendedPath = *this;
             extendedPath->m_edges.push_back(edge);
             extendedPath->m_nodes.push_back(node);
@@ -543,8 +588,8 @@ bool Path::canNodeFitAtStart(DeBruijnNode * node, Path *extendedPath) const {
         return false;
 
     DeBruijnNode * firstNode = m_nodes.front();
-    for (auto *edge : firstNode->edges()) {
-        if (edge->getStartingNode() == node && edge->getEndingNode() == firstNode) {
+    for (auto *edge : firstNode->enteringEdges()) {
+        if (edge->getStartingNode() == node) {
             *extendedPath = *this;
             extendedPath->m_edges.insert(extendedPath->m_edges.begin(), edge);
             extendedPath->m_nodes.insert(extendedPath->m_nodes.begin(), node);
@@ -572,8 +617,7 @@ QList<Path> Path::extendPathInAllPossibleWays() const
         return returnList;
 
     DeBruijnNode * lastNode = m_nodes.back();
-    std::vector<DeBruijnEdge *> nextEdges = lastNode->getLeavingEdges();
-    for (auto nextEdge : nextEdges)
+    for (auto *nextEdge : lastNode->leavingEdges())
     {
         DeBruijnNode * nextNode = nextEdge->getEndingNode();
 
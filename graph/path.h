@@ -21,6 +21,8 @@
 
 #include "graphlocation.h"
 
+#include "seq/sequence.hpp"
+
 #include <QByteArray>
 #include <QList>
 #include <QString>
@@ -67,6 +69,15 @@ public:
     bool isCircular() const;
     bool haveSameNodes(const Path& other) const;
     bool hasNodeSubset(const Path& other) const;
+    // A run of Ns followed by the bases [from, to) of the node sequence
+    struct SequencePiece {
+        size_t ns;
+        const DeBruijnNode *node;
+        size_t from, to;
+    };
+    // The pieces the path sequence consists of, in order
+    [[nodiscard]] std::vector<SequencePiece> getSequencePieces() const;
+    [[nodiscard]] Sequence getSequence() const;
     [[nodiscard]] QByteArray getPathSequence() const;
     [[nodiscard]] QByteArray getFasta(QString name = "") const;
     [[nodiscard]] QByteArray getAAFasta(unsigned shift, QString name = "") const;
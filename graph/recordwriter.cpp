@@ -0,0 +1,210 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "recordwriter.h"
+
+#include <QThread>
+#include <QtConcurrent>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+namespace utils {
+    // Buffered data is written out once it grows beyond this size
+    static constexpr size_t flushThreshold = 4 << 20;
+    // Bounds on the number of records formatted by a single task
+    static constexpr size_t minRecordsPerChunk = 16;
+    static constexpr size_t maxRecordsPerChunk = 1024;
+    // Uncompressed size of a BGZF block, the same as used by bgzip / htslib.
+    // This guarantees that the compressed block fits into 64K.
+    static constexpr size_t bgzfBlockSize = 0xff00;
+
+    // Empty BGZF block marking the end of file
+    static constexpr unsigned char bgzfEof[28] = {
+        0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+        0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+
+    static void putLE(unsigned char *out, uint32_t val, unsigned bytes) {
+        for (unsigned i = 0; i < bytes; ++i)
+            out[i] = (val >> (8 * i)) & 0xff;
+    }
+
+    // Compresses a single BGZF block: a gzip member with the 'BC' extra
+    // field holding the total block size.
+    static bool compressBgzfBlock(const char *data, size_t size, std::string &out) {
+        static constexpr size_t headerSize = 18, footerSize = 8;
+
+        z_stream zs{};
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+
+        out.resize(headerSize + deflateBound(&zs, uInt(size)) + footerSize);
+        auto *block = reinterpret_cast<unsigned char *>(out.data());
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        zs.avail_in = uInt(size);
+        zs.next_out = block + headerSize;
+        zs.avail_out = uInt(out.size() - headerSize - footerSize);
+        int res = deflate(&zs, Z_FINISH);
+        size_t compressedSize = zs.total_out;
+        deflateEnd(&zs);
+        if (res != Z_STREAM_END)
+            return false;
+
+        size_t blockSize = headerSize + compressedSize + footerSize;
+        static constexpr unsigned char header[16] = {
+            0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00
+        };
+        std::copy(std::begin(header), std::end(header), block);
+        putLE(block + 16, uint32_t(blockSize - 1), 2);
+
+        unsigned char *footer = block + headerSize + compressedSize;
+        putLE(footer, uint32_t(crc32(crc32(0, nullptr, 0), reinterpret_cast<const Bytef *>(data), uInt(size))), 4);
+        putLE(footer + 4, uint32_t(size), 4);
+
+        out.resize(blockSize);
+        return true;
+    }
+
+    RecordWriter::RecordWriter(const QString &filename, bool bgzip)
+            : m_file(filename), m_bgzip(bgzip) {}
+
+    bool RecordWriter::open() {
+        QIODevice::OpenMode mode = QIODevice::WriteOnly;
+        if (!m_bgzip)
+            mode |= QIODevice::Text;
+        if (!m_file.open(mode))
+            return false;
+
+        m_buffer.reserve(flushThreshold + (flushThreshold >> 2));
+        return true;
+    }
+
+    bool RecordWriter::close() {
+        if (!flush())
+            return false;
+
+        if (m_bgzip) {
+            if (!writeBgzfBlocks(true) ||
+                m_file.write(reinterpret_cast<const char *>(bgzfEof), sizeof(bgzfEof)) != sizeof(bgzfEof))
+                return false;
+        }
+
+        m_file.close();
+        return m_file.error() == QFileDevice::NoError;
+    }
+
+    bool RecordWriter::flush() {
+        bool res = write(m_buffer);
+        m_buffer.clear();
+        return res;
+    }
+
+    bool RecordWriter::flushIfFull() {
+        return m_buffer.size() < flushThreshold || flush();
+    }
+
+    bool RecordWriter::write(const std::string &data) {
+        if (data.empty())
+            return true;
+
+        if (!m_bgzip)
+            return m_file.write(data.data(), qint64(data.size())) == qint64(data.size());
+
+        m_pending += data;
+        return m_pending.size() < flushThreshold || writeBgzfBlocks(false);
+    }
+
+    // Compresses the pending data into BGZF blocks concurrently. Unless all is
+    // set, the trailing partial block is kept for later.
+    bool RecordWriter::writeBgzfBlocks(bool all) {
+        size_t blockCount = all ?
+                            (m_pending.size() + bgzfBlockSize - 1) / bgzfBlockSize :
+                            m_pending.size() / bgzfBlockSize;
+        if (blockCount == 0)
+            return true;
+
+        std::vector<size_t> blocks(blockCount);
+        std::iota(blocks.begin(), blocks.end(), 0);
+        std::vector<std::string> compressed(blockCount);
+        std::atomic<bool> ok = true;
+        QtConcurrent::blockingMap(blocks, [&](size_t block) {
+            size_t start = block * bgzfBlockSize;
+            size_t size = std::min(bgzfBlockSize, m_pending.size() - start);
+            if (!compressBgzfBlock(m_pending.data() + start, size, compressed[block]))
+                ok = false;
+        });
+        if (!ok)
+            return false;
+
+        for (const auto &block : compressed) {
+            if (m_file.write(block.data(), qint64(block.size())) != qint64(block.size()))
+                return false;
+        }
+
+        m_pending.erase(0, std::min(m_pending.size(), blockCount * bgzfBlockSize));
+        return true;
+    }
+
+    bool RecordWriter::writeRecords(size_t count,
+                                    const std::function<void(std::string &, size_t)> &format,
+                                    bool parallel, size_t recordsPerChunk) {
+        size_t threads = std::max(1, QThread::idealThreadCount());
+        size_t chunksPerRound = recordsPerChunk ? threads : threads * 4;
+        if (!recordsPerChunk)
+            recordsPerChunk = std::clamp(count / (threads * 4),
+                                         minRecordsPerChunk, maxRecordsPerChunk);
+        if (!parallel || count <= recordsPerChunk) {
+            for (size_t i = 0; i < count; ++i) {
+                format(m_buffer, i);
+                if (!flushIfFull())
+                    return false;
+            }
+            return true;
+        }
+
+        if (!flush())
+            return false;
+
+        size_t chunkCount = (count + recordsPerChunk - 1) / recordsPerChunk;
+        std::vector<std::string> chunkBuffers(std::min(chunkCount, chunksPerRound));
+        std::vector<size_t> chunks;
+        for (size_t first = 0; first < chunkCount; first += chunksPerRound) {
+            size_t last = std::min(first + chunksPerRound, chunkCount);
+            chunks.resize(last - first);
+            std::iota(chunks.begin(), chunks.end(), first);
+            QtConcurrent::blockingMap(chunks, [&](size_t chunk) {
+                std::string &out = chunkBuffers[chunk - first];
+                out.clear();
+                size_t end = std::min(count, (chunk + 1) * recordsPerChunk);
+                for (size_t i = chunk * recordsPerChunk; i < end; ++i)
+                    format(out, i);
+            });
+
+            for (size_t chunk = first; chunk < last; ++chunk) {
+                if (!write(chunkBuffers[chunk - first]))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,102 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace utils {
+    // Buffered writer for text formats consisting of independent records
+    // (FASTA, GFA). Records are appended to a reusable buffer which is written
+    // out in large blocks. If bgzip is set, the output is compressed into
+    // BGZF blocks, so the resulting file is still a valid gzip file, but can
+    // also be indexed with samtools faidx.
+    class RecordWriter {
+    public:
+        explicit RecordWriter(const QString &filename, bool bgzip = false);
+
+        bool open();
+        // Flushes all pending data; for BGZF output also writes the
+        // end-of-file marker block.
+        bool close();
+
+        std::string &buffer() { return m_buffer; }
+        bool flush();
+        // Flushes only if the buffer has grown large enough
+        bool flushIfFull();
+
+        // Calls format(out, i) for each i in [0, count), appending the
+        // records in order. In parallel mode chunks of records are formatted
+        // concurrently into separate buffers. For large records the chunk
+        // size could be given explicitly, then only one chunk per thread is
+        // kept in memory at a time.
+        bool writeRecords(size_t count,
+                          const std::function<void(std::string &, size_t)> &format,
+                          bool parallel, size_t recordsPerChunk = 0);
+
+    private:
+        bool write(const std::string &data);
+        bool writeBgzfBlocks(bool all);
+
+        QFile m_file;
+        bool m_bgzip;
+        std::string m_buffer;
+        // Uncompressed data not yet written as complete BGZF blocks
+        std::string m_pending;
+    };
+
+    // Appends the first len characters of str. Names are almost always plain
+    // ASCII, so copy them directly and only fall back to UTF-8 conversion
+    // when needed.
+    inline void appendString(std::string &out, const QString &str, qsizetype len) {
+        const QChar *chars = str.constData();
+        size_t pos = out.size();
+        out.resize(pos + len);
+        for (qsizetype i = 0; i < len; ++i) {
+            char16_t c = chars[i].unicode();
+            if (c >= 0x80) {
+                out.resize(pos);
+                out += QStringView(chars, len).toUtf8().toStdString();
+                return;
+            }
+            out[pos + i] = char(c);
+        }
+    }
+
+    inline void appendString(std::string &out, const QString &str) {
+        appendString(out, str, str.length());
+    }
+
+    inline void appendNumber(std::string &out, int64_t val) {
+        char buf[24];
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), val).ptr);
+    }
+
+    // Matches QString::number(double) and QByteArray::number(double), i.e. %g
+    // with 6 significant digits
+    inline void appendNumber(std::string &out, double val) {
+        QByteArray str = QByteArray::number(val, 'g', 6);
+        out.append(str.constData(), size_t(str.size()));
+    }
+}
@@ -18,7 +18,6 @@
 #include "sequenceutils.h"
 
 #include <QByteArray>
-#include <QRegularExpression>
 #include <QStringList>
 
 namespace utils {
@@ -39,33 +38,6 @@ namespace utils {
         return output;
     }
 
-    QStringList splitCsv(const QString &line, const QString &sep) {
-        // TODO: use libraries for parsing CSV
-        QRegularExpression rx(R"(("(?:[^"]|"")*"|[^)" + sep + "]*)(?:" + sep + "|$)");
-        QStringList list;
-
-        auto it = rx.globalMatch(line);
-        while (it.hasNext()) {
-            auto match = it.next();
-            QString field = match.captured().replace("\"\"", "\"");
-            if (field.endsWith(sep)) {
-                field.chop(sep.length());
-            }
-            if (!field.isEmpty() && field[0] == '"' && field[field.length() - 1] == '"') {
-                field = field.mid(1, field.length() - 2);
-            }
-            list << field;
-        }
-
-        // regexp always matches empty string at the end
-        // if string ends with separator then we need to store it
-        if (!line.endsWith(sep)) {
-            list.pop_back();
-        }
-
-        return list;
-    }
-
     QByteArray modifySequenceUsingOverlap(QByteArray sequence, int overlap) {
         if (overlap > 0) {
             int rightChars = sequence.length() - overlap;
@@ -23,12 +23,81 @@
 
 #include "seq/sequence.hpp"
 
+#include <algorithm>
+#include <string>
+
 namespace utils {
     static inline QByteArray sequenceToQByteArray(const Sequence &sequence) {
-        auto sequence_str = sequence.str();
-        return {sequence_str.c_str(), static_cast<qsizetype>(sequence_str.size())};
+        QByteArray res(static_cast<qsizetype>(sequence.size()), Qt::Uninitialized);
+        char *dst = res.data();
+        for (size_t i = 0, e = sequence.size(); i < e; ++i)
+            dst[i] = sequence[i];
+        return res;
+    }
+
+    // Decodes length bases of the sequence starting at from straight into out
+    static inline void appendSequence(std::string &out, const Sequence &sequence,
+                                      size_t from, size_t length) {
+        size_t pos = out.size();
+        out.resize(pos + length);
+        char *dst = out.data() + pos;
+        for (size_t i = 0; i < length; ++i)
+            dst[i] = sequence[from + i];
     }
 
+    static inline void appendSequence(std::string &out, const Sequence &sequence) {
+        appendSequence(out, sequence, 0, sequence.size());
+    }
+
+    // Appends the sequence lines of a FASTA record to out, wrapped the same way
+    // as addNewlinesToSequence does. The sequence may be given in several
+    // pieces; finish() ends the last line.
+    class FastaLineWrapper {
+    public:
+        explicit FastaLineWrapper(std::string &out, size_t interval = 70)
+            : m_out(out), m_interval(interval) {}
+
+        void append(const char *bases, size_t length) {
+            appendLines(length, [&](size_t count) {
+                m_out.append(bases, count);
+                bases += count;
+            });
+        }
+
+        void append(const Sequence &sequence, size_t from, size_t length) {
+            appendLines(length, [&](size_t count) {
+                appendSequence(m_out, sequence, from, count);
+                from += count;
+            });
+        }
+
+        void appendNs(size_t length) {
+            appendLines(length, [&](size_t count) { m_out.append(count, 'N'); });
+        }
+
+        void finish() { m_out += '\n'; }
+
+    private:
+        template<class AppendBases>
+        void appendLines(size_t length, AppendBases &&appendBases) {
+            while (length > 0) {
+                if (m_column == m_interval) {
+                    m_out += '\n';
+                    m_column = 0;
+                }
+
+                size_t count = std::min(length, m_interval - m_column);
+                appendBases(count);
+                length -= count;
+                m_column += count;
+            }
+        }
+
+        std::string &m_out;
+        size_t m_interval;
+        size_t m_column = 0;
+    };
+
     // This function is used when making FASTA outputs - it breaks a sequence into
     // separate lines.  The default interval is 70, as that seems to be what NCBI
     // uses.
@@ -36,15 +105,6 @@ namespace utils {
     QByteArray addNewlinesToSequence(const QByteArray &sequence,
                                      int interval = 70);
 
-    // Split a QString according to CSV rules
-    // @param line  line of a csv
-    // @param sep   field separator to use
-    // @result      list of fields with escaping removed
-    //
-    // Known Bugs: CSV (as per RFC4180) allows multi-line fields (\r\n between "..."), which
-    //             can't be parsed line-by line, hence isn't supported.
-    QStringList splitCsv(const QString& line, const QString& sep=",");
-
     // This function will trim bases from the start of a sequence (in the case of
     // positive overlap) or add Ns to the start (in the case of negative overlap).
     QByteArray modifySequenceUsingOverlap(QByteArray sequence, int overlap);
@@ -19,6 +19,7 @@
 
 #include <csv/csv.hpp>
 
+#include <random>
 #include <sstream>
 
 namespace bed {
@@ -52,6 +53,8 @@ std::vector<Line> load(const std::filesystem::path &path) {
 
     csv::CSVRow row;
     std::vector<Line> res;
+    // Fixed sequence, so colours of items without itemRgb do not change between loads
+    std::minstd_rand colourGenerator;
     while (csvReader.read_row(row)) {
         // At least 3 columns are mandatory
         if (row.size() < 3)
@@ -116,7 +119,8 @@ std::vector<Line> load(const std::filesystem::path &path) {
             if (itemRgbString != "0") {
                 rgbArray = parseIntArray(itemRgbString);
             } else {
-                rgbArray = { rand() & 0xFF, rand() & 0xFF, rand() & 0xFF };
+                for (int c = 0; c < 3; ++c)
+                    rgbArray.push_back(int64_t(colourGenerator() & 0xFF));
             }
             bedLine.itemRgb.r = rgbArray[0];
             bedLine.itemRgb.g = rgbArray[1];
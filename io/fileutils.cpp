@@ -19,101 +19,176 @@
 
 #include <QTextStream>
 #include <QFile>
-#include <QChar>
-#include <QApplication>
+#include <QFileInfo>
 #include <QRegularExpression>
 
-namespace utils {
-    bool readFastxFile(const QString &filename, std::vector<QString> &names,
-                       std::vector<QByteArray> &sequences) {
-        QChar firstChar = QChar(0);
-        QFile inputFile(filename);
-        if (!inputFile.open(QIODevice::ReadOnly))
-            return false;
+#include <zlib.h>
 
-        QTextStream in(&inputFile);
-        QString firstLine = in.readLine();
-        firstChar = firstLine.at(0);
-        inputFile.close();
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
 
-        if (firstChar == '>')
-            return readFastaFile(filename, names, sequences);
-        else if (firstChar == '@')
-            return readFastqFile(filename, names, sequences);
+namespace utils {
+    // Buffered reader of FASTA / FASTQ records in the spirit of kseq.h.
+    // gzip-compressed input is decompressed transparently, plain files are
+    // read as is.
+    class FastxReader {
+    public:
+        static constexpr size_t bufferSize = 1 << 20;
+
+        FastxReader(gzFile file, size_t totalSize, const ProgressCallback &progress)
+                : m_file(file), m_buffer(bufferSize), m_totalSize(totalSize), m_progress(progress) {}
+
+        // Reads the next record, returns false at the end of the input
+        bool next(std::string &name, std::string &sequence, bool &isFastq) {
+            if (m_last == 0) {
+                // Skip everything up to the next header
+                int c;
+                while ((c = getc()) >= 0 && c != '>' && c != '@')
+                    ;
+                if (c < 0)
+                    return false;
+                m_last = c;
+            }
 
-        return false;
-    }
+            name.clear();
+            sequence.clear();
+            readLine(&name);
+            if (!name.empty() && name.back() == '\r')
+                name.pop_back();
+
+            // Sequence lines continue up to the next header or the FASTQ
+            // separator line
+            int c;
+            while ((c = getc()) >= 0 && c != '>' && c != '@' && c != '+') {
+                if (c == '\n')
+                    continue;
+                sequence += char(c);
+                readLine(&sequence);
+            }
+            removeWhitespace(sequence);
 
+            isFastq = c == '+';
+            if (!isFastq) {
+                m_last = std::max(c, 0);
+                return true;
+            }
 
-    bool readFastaFile(const QString &filename, std::vector<QString> &names,
-                       std::vector<QByteArray> &sequences) {
-        QFile inputFile(filename);
-        if (!inputFile.open(QIODevice::ReadOnly))
-            return false;
+            // Skip the rest of separator line and as many quality lines as
+            // needed to cover the sequence (qualities may start with '@').
+            readLine(nullptr);
+            size_t qualitiesLength = 0;
+            while (qualitiesLength < sequence.size()) {
+                m_qualities.clear();
+                if (!readLine(&m_qualities))
+                    break;
+                removeWhitespace(m_qualities);
+                qualitiesLength += m_qualities.size();
+            }
+            m_last = 0;
 
-        QString name = "";
-        QByteArray sequence = "";
+            return true;
+        }
 
-        QTextStream in(&inputFile);
-        while (!in.atEnd()) {
-            QApplication::processEvents();
+        bool failed() const { return m_failed; }
 
-            QString line = in.readLine();
+    private:
+        bool fill() {
+            if (m_eof)
+                return false;
 
-            if (line.length() == 0)
-                continue;
+            int read = gzread(m_file, m_buffer.data(), unsigned(m_buffer.size()));
+            if (read <= 0) {
+                m_eof = true;
+                m_failed = read < 0;
+                return false;
+            }
 
-            if (line.at(0) == '>') {
-                //If there is a current sequence, add it to the vectors now.
-                if (name.length() > 0) {
-                    names.push_back(name);
-                    sequences.push_back(sequence);
-                }
+            m_pos = 0;
+            m_end = size_t(read);
+            if (m_progress)
+                m_progress(size_t(gzoffset(m_file)), m_totalSize);
 
-                line.remove(0, 1); //Remove '>' from start
-                name = line;
-                sequence = "";
-            } else //It's a sequence line
-                sequence += line.simplified().toLatin1();
+            return true;
         }
 
-        //Add the last target to the results now.
-        if (name.length() > 0) {
-            names.push_back(name);
-            sequences.push_back(sequence);
+        int getc() {
+            if (m_pos == m_end && !fill())
+                return -1;
+            return static_cast<unsigned char>(m_buffer[m_pos++]);
         }
 
-            return true;
-    }
-
-
-    bool readFastqFile(const QString &filename, std::vector<QString> &names,
-                       std::vector<QByteArray> &sequences) {
-        QFile inputFile(filename);
-        if (!inputFile.open(QIODevice::ReadOnly))
-            return false;
+        // Appends the rest of the current line (without the newline) to out,
+        // or skips it if out is null. Returns false if nothing could be read.
+        bool readLine(std::string *out) {
+            bool read = false;
+            while (m_pos < m_end || fill()) {
+                read = true;
+                const char *start = m_buffer.data() + m_pos;
+                const char *newline = static_cast<const char *>(std::memchr(start, '\n', m_end - m_pos));
+                size_t length = newline ? size_t(newline - start) : m_end - m_pos;
+                if (out)
+                    out->append(start, length);
+                m_pos += length;
+                if (newline) {
+                    ++m_pos;
+                    break;
+                }
+            }
 
-        QTextStream in(&inputFile);
-        while (!in.atEnd()) {
-            QApplication::processEvents();
+            return read;
+        }
 
-            QString name = in.readLine().simplified();
-            QByteArray sequence = in.readLine().simplified().toLocal8Bit();
-            in.readLine();  // separator
-            in.readLine();  // qualities
+        static void removeWhitespace(std::string &str) {
+            str.erase(std::remove_if(str.begin(), str.end(),
+                                     [](char c) { return c == ' ' || c == '\t' || c == '\r'; }),
+                      str.end());
+        }
 
-            if (name.length() == 0)
-                continue;
-            if (sequence.length() == 0)
-                continue;
-            if (name.at(0) != '@')
+        gzFile m_file;
+        std::vector<char> m_buffer;
+        size_t m_pos = 0, m_end = 0;
+        // The header character of the next record if it was already consumed
+        int m_last = 0;
+        bool m_eof = false, m_failed = false;
+        std::string m_qualities;
+
+        size_t m_totalSize;
+        const ProgressCallback &m_progress;
+    };
+
+    bool readFastxFile(const QString &filename, const FastxRecordCallback &record,
+                       const ProgressCallback &progress) {
+        std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
+                fp(gzopen(QFile::encodeName(filename).constData(), "rb"), gzclose);
+        if (!fp)
+            return false;
+        gzbuffer(fp.get(), 1 << 18);
+
+        FastxReader reader(fp.get(), size_t(QFileInfo(filename).size()), progress);
+        std::string name, sequence;
+        bool isFastq, headerSeen = false;
+        while (reader.next(name, sequence, isFastq)) {
+            headerSeen = true;
+            if (name.empty() || (isFastq && sequence.empty()))
                 continue;
-            name.remove(0, 1); //Remove '@' from start
-            names.push_back(name);
-            sequences.push_back(sequence);
+
+            record(name, sequence);
         }
 
-        return true;
+        return headerSeen && !reader.failed();
+    }
+
+    bool readFastxFile(const QString &filename, std::vector<QString> &names,
+                       std::vector<QByteArray> &sequences,
+                       const ProgressCallback &progress) {
+        return readFastxFile(filename,
+                             [&](std::string_view name, std::string_view sequence) {
+                                 names.push_back(QString::fromUtf8(name.data(), qsizetype(name.size())));
+                                 sequences.emplace_back(sequence.data(), qsizetype(sequence.size()));
+                             },
+                             progress);
     }
 
     bool readHmmFile(const QString &filename,
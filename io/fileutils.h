@@ -19,17 +19,28 @@
 
 #include <QString>
 #include <QByteArray>
+
+#include <functional>
+#include <string_view>
 #include <vector>
 
 namespace utils {
-    bool readFastxFile(const QString &filename, std::vector<QString> &names,
-                       std::vector<QByteArray> &sequences);
+    // Reports the number of bytes of the input file processed so far and the
+    // total file size (both refer to the compressed data for gzip input).
+    using ProgressCallback = std::function<void(size_t processed, size_t total)>;
+    using FastxRecordCallback = std::function<void(std::string_view name, std::string_view sequence)>;
+
+    // Reads a FASTA or FASTQ file (possibly gzip-compressed) and calls record
+    // for every entry with the full header line (without '>' / '@') and the
+    // sequence with all whitespace removed. Records with empty names are
+    // skipped, as are FASTQ records with empty sequences. The views are only
+    // valid during the call.
+    bool readFastxFile(const QString &filename, const FastxRecordCallback &record,
+                       const ProgressCallback &progress = {});
 
-    bool readFastaFile(const QString &filename, std::vector<QString> &names,
-                       std::vector<QByteArray> &sequences);
-
-    bool readFastqFile(const QString &filename, std::vector<QString> &names,
-                       std::vector<QByteArray> &sequences);
+    bool readFastxFile(const QString &filename, std::vector<QString> &names,
+                       std::vector<QByteArray> &sequences,
+                       const ProgressCallback &progress = {});
 
     bool readHmmFile(const QString &filename,
                      std::vector<QString> &names, std::vector<unsigned> &lengths,
@@ -0,0 +1,172 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "coarsening.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
+#include "graph/debruijnedge.h"
+
+#include <deque>
+
+namespace layout {
+
+bool CoarseGraph::isLayoutEdge(const DeBruijnEdge *edge) {
+    if (edge->getOverlapType() == JUMP || edge->getOverlapType() == EXTRA_LINK)
+        return false;
+
+    // In single mode only one edge out of the reverse-complement pair is drawn,
+    // however we need to traverse both of them.
+    return edge->isDrawn() || edge->getReverseComplement()->isDrawn();
+}
+
+// Counts the layout edges leaving (or entering) the node, returning the last
+// one seen. Unlike DeBruijnNode::getLeavingEdges this does not allocate.
+static size_t countLayoutEdges(const DeBruijnNode *node, bool leaving,
+                               const DeBruijnEdge **last = nullptr) {
+    size_t count = 0;
+    for (const auto *edge : node->edges()) {
+        if ((leaving ? edge->getStartingNode() : edge->getEndingNode()) != node ||
+            !CoarseGraph::isLayoutEdge(edge))
+            continue;
+
+        ++count;
+        if (last)
+            *last = edge;
+    }
+
+    return count;
+}
+
+static const DeBruijnEdge *uniqueLayoutEdge(const DeBruijnNode *node, bool leaving) {
+    const DeBruijnEdge *edge = nullptr;
+    return countLayoutEdges(node, leaving, &edge) == 1 ? edge : nullptr;
+}
+
+void CoarseGraph::build(unsigned maxTipLength) {
+    m_chains.clear();
+    m_members.clear();
+    m_internalEdges.clear();
+
+    auto claim = [&](const DeBruijnNode *node, uint32_t chain) {
+        m_members[node] = { chain, 0, true };
+        if (node->getReverseComplement() != node)
+            m_members[node->getReverseComplement()] = { chain, 0, false };
+    };
+    auto markInternal = [&](const DeBruijnEdge *edge) {
+        m_internalEdges.insert(edge);
+        m_internalEdges.insert(edge->getReverseComplement());
+    };
+
+    for (auto *node : m_graph.m_deBruijnGraphNodes) {
+        if (!node->thisNodeOrReverseComplementIsDrawn() || m_members.contains(node))
+            continue;
+
+        uint32_t chainIdx = m_chains.size();
+        std::deque<DeBruijnNode *> chain{node};
+        claim(node, chainIdx);
+
+        // Extend forward as much as possible. The conditions here are the
+        // same as in AssemblyGraph::mergeAllPossible.
+        while (const auto *edge = uniqueLayoutEdge(chain.back(), true)) {
+            DeBruijnNode *next = edge->getEndingNode();
+            if (m_members.contains(next) ||
+                uniqueLayoutEdge(next, false) != edge)
+                break;
+
+            chain.push_back(next);
+            claim(next, chainIdx);
+            markInternal(edge);
+        }
+
+        // Extend backward as much as possible.
+        while (const auto *edge = uniqueLayoutEdge(chain.front(), false)) {
+            DeBruijnNode *prev = edge->getStartingNode();
+            if (m_members.contains(prev) ||
+                uniqueLayoutEdge(prev, true) != edge)
+                break;
+
+            chain.push_front(prev);
+            claim(prev, chainIdx);
+            markInternal(edge);
+        }
+
+        addChain({ chain.begin(), chain.end() });
+    }
+
+    markTips(maxTipLength);
+}
+
+void CoarseGraph::addChain(std::vector<DeBruijnNode *> nodes) {
+    CoarseChain chain;
+    chain.nodes = std::move(nodes);
+
+    for (uint32_t i = 0; i < chain.nodes.size(); ++i) {
+        const DeBruijnNode *node = chain.nodes[i];
+        chain.length += node->getLength();
+
+        m_members[node].index = i;
+        if (node->getReverseComplement() != node)
+            m_members[node->getReverseComplement()].index = i;
+    }
+
+    m_chains.emplace_back(std::move(chain));
+}
+
+// A tip is a short chain that is a dead end on one side and has a single edge
+// on the other side. Tips hanging off other tips are kept as-is, as otherwise
+// there would be nothing to attach them to.
+void CoarseGraph::markTips(unsigned maxTipLength) {
+    if (maxTipLength == 0)
+        return;
+
+    std::vector<bool> candidate(m_chains.size(), false);
+    for (uint32_t i = 0; i < m_chains.size(); ++i) {
+        auto &chain = m_chains[i];
+        if (chain.length > maxTipLength)
+            continue;
+
+        const DeBruijnEdge *frontEdge = nullptr, *backEdge = nullptr;
+        size_t frontCount = countLayoutEdges(chain.front(), false, &frontEdge);
+        size_t backCount = countLayoutEdges(chain.back(), true, &backEdge);
+        if (frontCount + backCount != 1)
+            continue;
+
+        const DeBruijnEdge *edge = frontCount ? frontEdge : backEdge;
+        const DeBruijnNode *other = frontCount ? edge->getStartingNode() : edge->getEndingNode();
+        if (member(other)->chain == i)
+            continue;
+
+        chain.attachEdge = edge;
+        chain.attachedAtFront = frontCount != 0;
+        candidate[i] = true;
+    }
+
+    for (auto &chain : m_chains) {
+        if (!chain.attachEdge)
+            continue;
+
+        const DeBruijnNode *other = chain.attachedAtFront ?
+                                    chain.attachEdge->getStartingNode() : chain.attachEdge->getEndingNode();
+        if (candidate[member(other)->chain])
+            chain.attachEdge = nullptr;
+        else
+            chain.isTip = true;
+    }
+}
+
+}
@@ -0,0 +1,91 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel_hashmap/phmap.h"
+
+#include <cstdint>
+#include <vector>
+
+class AssemblyGraph;
+class DeBruijnNode;
+class DeBruijnEdge;
+
+namespace layout {
+
+// A maximal simple non-branching run of drawn nodes. Nodes are stored in the
+// order of traversal, i.e. every node is oriented so that there is a single
+// edge leading from nodes[i] to nodes[i+1]. This is exactly the chain that
+// AssemblyGraph::mergeAllPossible would have merged into a single node.
+struct CoarseChain {
+    std::vector<DeBruijnNode *> nodes;
+    unsigned long long length = 0;
+
+    // Short dead-end chains are not laid out on their own, instead they are
+    // bundled onto the node they are attached to via the given edge.
+    bool isTip = false;
+    bool attachedAtFront = false;
+    const DeBruijnEdge *attachEdge = nullptr;
+
+    DeBruijnNode *front() const { return nodes.front(); }
+    DeBruijnNode *back() const { return nodes.back(); }
+};
+
+// Non-mutating contraction of the drawn part of the graph into chains. Every
+// drawn node (or its reverse complement in single mode) belongs to exactly one
+// chain.
+class CoarseGraph {
+public:
+    struct Member {
+        uint32_t chain;
+        uint32_t index;
+        bool forward;
+    };
+
+    explicit CoarseGraph(const AssemblyGraph &graph)
+            : m_graph(graph) {}
+
+    void build(unsigned maxTipLength);
+
+    [[nodiscard]] const AssemblyGraph &graph() const { return m_graph; }
+    [[nodiscard]] const std::vector<CoarseChain> &chains() const { return m_chains; }
+
+    // Returns the chain position of a node in either orientation, or nullptr
+    // if the node is not drawn.
+    const Member *member(const DeBruijnNode *node) const {
+        auto it = m_members.find(node);
+        return it == m_members.end() ? nullptr : &it->second;
+    }
+
+    // Edges connecting consecutive nodes of a chain (in both orientations).
+    bool isInternal(const DeBruijnEdge *edge) const { return m_internalEdges.contains(edge); }
+
+    // Edges that take part in the layout: drawn, not jumps or extra links.
+    static bool isLayoutEdge(const DeBruijnEdge *edge);
+
+private:
+    void addChain(std::vector<DeBruijnNode *> nodes);
+    void markTips(unsigned maxTipLength);
+
+    const AssemblyGraph &m_graph;
+    std::vector<CoarseChain> m_chains;
+    phmap::flat_hash_map<const DeBruijnNode *, Member> m_members;
+    phmap::flat_hash_set<const DeBruijnEdge *> m_internalEdges;
+};
+
+}
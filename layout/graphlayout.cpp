@@ -18,7 +18,11 @@
 #include "graphlayout.h"
 
 #include "graph/assemblygraph.h"
+#include "graph/debruijnedge.h"
 #include "graph/graphicsitemnode.h"
+#include "program/settings.h"
+
+#include <cmath>
 
 namespace layout {
     GraphLayout fromGraph(const AssemblyGraph &graph, bool simplified) {
@@ -55,4 +59,39 @@ namespace layout {
         for (auto &entry : graph.m_deBruijnGraphEdges)
             entry->determineIfDrawn();
     }
+
+    // FIXME: move to settings
+    static double getNodeLengthPerMegabase() {
+        if (g_settings->nodeLengthMode == AUTO_NODE_LENGTH)
+            return g_settings->autoNodeLengthPerMegabase;
+
+        return g_settings->manualNodeLengthPerMegabase;
+    }
+
+    double getDrawnNodeLength(const DeBruijnNode *node) {
+        double drawnNodeLength = getNodeLengthPerMegabase() * double(node->getLength()) / 1000000.0;
+        if (drawnNodeLength < g_settings->minimumNodeLength)
+            drawnNodeLength = g_settings->minimumNodeLength;
+        return drawnNodeLength;
+    }
+
+    int getNumberOfSegments(double drawnNodeLength) {
+        int numberOfSegments = ceil(drawnNodeLength / g_settings->nodeSegmentLength);
+        if (numberOfSegments <= 0)
+            numberOfSegments = 1;
+        return numberOfSegments;
+    }
+
+    std::vector<DeBruijnEdge *> orderedEdges(const AssemblyGraph &graph) {
+        std::vector<DeBruijnEdge *> res;
+        res.reserve(graph.m_deBruijnGraphEdges.size());
+        for (auto *node : graph.m_deBruijnGraphNodes) {
+            for (auto *edge : node->edges()) {
+                if (edge->getStartingNode() == node)
+                    res.push_back(edge);
+            }
+        }
+
+        return res;
+    }
 }
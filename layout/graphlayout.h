@@ -22,7 +22,10 @@
 
 #include <QPointF>
 
+#include <vector>
+
 class DeBruijnNode;
+class DeBruijnEdge;
 class AssemblyGraph;
 
 template<class T>
@@ -54,4 +57,12 @@ using GraphLayout = GraphLayoutStorage<QPointF>;
 namespace layout {
     GraphLayout fromGraph(const AssemblyGraph &graph, bool simplified = false);
     void apply(AssemblyGraph &graph, const GraphLayout &layout);
+
+    // Length of the node in layout units and the number of segments it is split into
+    double getDrawnNodeLength(const DeBruijnNode *node);
+    int getNumberOfSegments(double drawnNodeLength);
+
+    // All graph edges in an order that does not depend on memory addresses
+    // (unlike iteration over the edge set), so layouts are reproducible
+    std::vector<DeBruijnEdge *> orderedEdges(const AssemblyGraph &graph);
 }
\ No newline at end of file
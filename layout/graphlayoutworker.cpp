@@ -17,11 +17,14 @@
 // along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "graphlayoutworker.h"
+#include "coarsening.h"
+#include "linearlayout.h"
 #include "graph/assemblygraph.h"
 #include "graph/debruijnnode.h"
 #include "graph/debruijnedge.h"
 
 #include "program/settings.h"
+#include "program/random.h"
 
 #include "ogdf/basic/GraphCopy.h"
 #include "ogdf/basic/simple_graph_alg.h"
@@ -33,12 +36,13 @@
 #include <QFutureSynchronizer>
 #include <QtConcurrent>
 
-#include <ctime>
+#include <cassert>
+#include <cmath>
+#include <optional>
 
-GraphLayouter::GraphLayouter(int graphLayoutQuality, bool useLinearLayout,
+GraphLayouter::GraphLayouter(int graphLayoutQuality,
                              double graphLayoutComponentSeparation, double aspectRatio)
         :   m_graphLayoutQuality(graphLayoutQuality),
-            m_useLinearLayout(useLinearLayout),
             m_graphLayoutComponentSeparation(graphLayoutComponentSeparation),
             m_aspectRatio(aspectRatio)
 {}
@@ -47,8 +51,8 @@ class FMMGraphLayout : public GraphLayouter {
 public:
     using GraphLayouter::GraphLayouter;
 
-    void init() override {
-        init(m_layout);
+    void init(int seed) override {
+        init(m_layout, seed);
     }
 
     void cancel() override {
@@ -62,17 +66,15 @@ public:
     }
 
 private:
-    void init(ogdf::FMMMLayout &layout) const {
-        layout.randSeed(clock());
+    void init(ogdf::FMMMLayout &layout, int seed) const {
+        layout.randSeed(seed);
         layout.useHighLevelOptions(false);
         layout.unitEdgeLength(1.0);
         layout.allowedPositions(ogdf::FMMMOptions::AllowedPositions::All);
         layout.pageRatio(m_aspectRatio);
         layout.minDistCC(m_graphLayoutComponentSeparation);
         layout.stepsForRotatingComponents(50); // Helps to make linear graph components more horizontal.
-        layout.initialPlacementForces(m_useLinearLayout ?
-                                      ogdf::FMMMOptions::InitialPlacementForces::KeepPositions :
-                                      ogdf::FMMMOptions::InitialPlacementForces::RandomTime);
+        layout.initialPlacementForces(ogdf::FMMMOptions::InitialPlacementForces::RandomRandIterNr);
 
         switch (m_graphLayoutQuality) {
             case 0:
@@ -113,36 +115,214 @@ GraphLayoutWorker::GraphLayoutWorker(int graphLayoutQuality, bool useLinearLayou
           m_graphLayoutComponentSeparation(graphLayoutComponentSeparation),
           m_aspectRatio(aspectRatio) {}
 
-// FIXME: move to settings
-static double getNodeLengthPerMegabase() {
-    if (g_settings->nodeLengthMode == AUTO_NODE_LENGTH)
-        return g_settings->autoNodeLengthPerMegabase;
+// In coarsened layout even very long nodes (and chains) are represented by a
+// limited number of OGDF nodes
+static int getCappedNumberOfOgdfGraphEdges(double drawnNodeLength) {
+    return std::min(layout::getNumberOfSegments(drawnNodeLength), int(g_settings->maxNodeSegments));
+}
+
+using OGDFGraphLayout = GraphLayoutStorage<ogdf::node>;
+
+// Layout of the coarse graph: each chain is laid out as a single line of OGDF
+// nodes, member nodes are then interpolated along it. Tips do not have OGDF
+// nodes at all and are placed next to their attachment points afterwards.
+class CoarseOGDFLayout {
+public:
+    explicit CoarseOGDFLayout(const AssemblyGraph &graph)
+            : m_coarse(graph) {}
 
+    void build(ogdf::Graph &ogdfGraph, ogdf::GraphAttributes &GA,
+               ogdf::EdgeArray<double> &edgeLengths);
+    void interpolate(const ogdf::GraphAttributes &GA, GraphLayout &layout) const;
 
-    return g_settings->manualNodeLengthPerMegabase;
+private:
+    struct Anchor {
+        size_t chain;
+        size_t segment;
+    };
+
+    // Returns the OGDF node where the given node starts (or ends) in the coarse
+    // layout. Tips do not have any.
+    std::optional<Anchor> anchor(const DeBruijnNode *node, bool atEnd) const;
+
+    template<class PointAt>
+    static void addChainNodes(const layout::CoarseChain &chain,
+                              const std::vector<double> &offsets,
+                              GraphLayout &layout, PointAt pointAt);
+
+    layout::CoarseGraph m_coarse;
+    // Per-chain OGDF nodes and drawn offsets of chain nodes (plus total length)
+    std::vector<std::vector<ogdf::node>> m_segments;
+    std::vector<std::vector<double>> m_offsets;
+};
+
+void CoarseOGDFLayout::build(ogdf::Graph &ogdfGraph, ogdf::GraphAttributes &GA,
+                             ogdf::EdgeArray<double> &edgeLengths) {
+    m_coarse.build(g_settings->coarseTipLength);
+
+    const auto &chains = m_coarse.chains();
+    m_segments.resize(chains.size());
+    m_offsets.resize(chains.size());
+    for (size_t i = 0; i < chains.size(); ++i) {
+        const auto &chain = chains[i];
+
+        auto &offsets = m_offsets[i];
+        offsets.reserve(chain.nodes.size() + 1);
+        double chainLength = 0;
+        offsets.push_back(chainLength);
+        for (const auto *node : chain.nodes) {
+            chainLength += layout::getDrawnNodeLength(node);
+            offsets.push_back(chainLength);
+        }
+
+        if (chain.isTip)
+            continue;
+
+        int numberOfGraphEdges = getCappedNumberOfOgdfGraphEdges(chainLength);
+        double drawnLengthPerEdge = chainLength / numberOfGraphEdges;
+
+        auto &segments = m_segments[i];
+        segments.reserve(numberOfGraphEdges + 1);
+        for (int j = 0; j <= numberOfGraphEdges; ++j) {
+            ogdf::node newNode = ogdfGraph.newNode();
+            GA.width(newNode) = g_settings->edgeLength;
+            GA.height(newNode) = g_settings->edgeLength;
+
+            if (j > 0) {
+                ogdf::edge newEdge = ogdfGraph.newEdge(segments.back(), newNode);
+                edgeLengths[newEdge] = drawnLengthPerEdge;
+            }
+
+            segments.push_back(newNode);
+        }
+    }
+
+    for (const DeBruijnEdge *edge : layout::orderedEdges(m_coarse.graph())) {
+        if (!edge->isDrawn() ||
+            !layout::CoarseGraph::isLayoutEdge(edge) || m_coarse.isInternal(edge))
+            continue;
+
+        auto from = anchor(edge->getStartingNode(), true);
+        auto to = anchor(edge->getEndingNode(), false);
+        if (!from || !to)
+            continue;
+
+        ogdf::node firstEdgeOgdfNode = m_segments[from->chain][from->segment];
+        ogdf::node secondEdgeOgdfNode = m_segments[to->chain][to->segment];
+        // Same as for non-coarsened layout, skip self-loops on a single segment
+        if (firstEdgeOgdfNode == secondEdgeOgdfNode)
+            continue;
+
+        ogdf::edge newEdge = ogdfGraph.newEdge(firstEdgeOgdfNode, secondEdgeOgdfNode);
+        edgeLengths[newEdge] = g_settings->edgeLength;
+    }
 }
 
-static double getDrawnNodeLength(const DeBruijnNode *node) {
-    double drawnNodeLength = getNodeLengthPerMegabase() * double(node->getLength()) / 1000000.0;
-    if (drawnNodeLength < g_settings->minimumNodeLength)
-        drawnNodeLength = g_settings->minimumNodeLength;
-    return drawnNodeLength;
+std::optional<CoarseOGDFLayout::Anchor>
+CoarseOGDFLayout::anchor(const DeBruijnNode *node, bool atEnd) const {
+    const auto *member = m_coarse.member(node);
+    if (!member || m_coarse.chains()[member->chain].isTip)
+        return {};
+
+    const auto &offsets = m_offsets[member->chain];
+    const auto &segments = m_segments[member->chain];
+    // Reverse-complement nodes are traversed in opposite direction
+    bool chainEnd = member->forward == atEnd;
+    double offset = offsets[member->index + (chainEnd ? 1 : 0)];
+    double lengthPerEdge = offsets.back() / (segments.size() - 1);
+    size_t segment = std::min(size_t(std::lround(offset / lengthPerEdge)), segments.size() - 1);
+
+    return Anchor{ member->chain, segment };
 }
 
-static int getNumberOfOgdfGraphEdges(double drawnNodeLength) {
-    int numberOfGraphEdges = ceil(drawnNodeLength / g_settings->nodeSegmentLength);
-    if (numberOfGraphEdges <= 0)
-        numberOfGraphEdges = 1;
-    return numberOfGraphEdges;
+template<class PointAt>
+void CoarseOGDFLayout::addChainNodes(const layout::CoarseChain &chain,
+                                     const std::vector<double> &offsets,
+                                     GraphLayout &layout, PointAt pointAt) {
+    std::vector<QPointF> points;
+    for (size_t i = 0; i < chain.nodes.size(); ++i) {
+        DeBruijnNode *node = chain.nodes[i];
+        DeBruijnNode *rcNode = node->getReverseComplement();
+
+        double start = offsets[i], end = offsets[i + 1];
+        int numberOfGraphEdges = getCappedNumberOfOgdfGraphEdges(end - start);
+        points.clear();
+        for (int j = 0; j <= numberOfGraphEdges; ++j)
+            points.push_back(pointAt(start + (end - start) * j / numberOfGraphEdges));
+
+        if (node->isDrawn()) {
+            for (auto point : points)
+                layout.add(node, point);
+        }
+        if (rcNode != node && rcNode->isDrawn()) {
+            for (auto rIt = points.rbegin(); rIt != points.rend(); ++rIt)
+                layout.add(rcNode, *rIt);
+        }
+    }
 }
 
-using OGDFGraphLayout = GraphLayoutStorage<ogdf::node>;
+void CoarseOGDFLayout::interpolate(const ogdf::GraphAttributes &GA, GraphLayout &layout) const {
+    auto position = [&](ogdf::node node) { return QPointF(GA.x(node), GA.y(node)); };
+
+    // Number of tips already placed at a given OGDF node, used to fan them out
+    phmap::flat_hash_map<ogdf::node, unsigned> tipCount;
+
+    const auto &chains = m_coarse.chains();
+    for (size_t i = 0; i < chains.size(); ++i) {
+        const auto &chain = chains[i];
+        const auto &offsets = m_offsets[i];
+
+        if (!chain.isTip) {
+            const auto &segments = m_segments[i];
+            double lengthPerEdge = offsets.back() / (segments.size() - 1);
+            addChainNodes(chain, offsets, layout, [&](double offset) {
+                double pos = offset / lengthPerEdge;
+                size_t j = std::min(size_t(pos), segments.size() - 2);
+                QPointF a = position(segments[j]), b = position(segments[j + 1]);
+                return a + (b - a) * (pos - j);
+            });
+            continue;
+        }
+
+        // Tips are drawn as straight lines going away from the attachment point
+        const DeBruijnEdge *edge = chain.attachEdge;
+        auto attach = chain.attachedAtFront ?
+                      anchor(edge->getStartingNode(), true) : anchor(edge->getEndingNode(), false);
+        assert(attach && "tips are always attached to a laid out chain");
+        const auto &segments = m_segments[attach->chain];
+        size_t j = attach->segment, last = segments.size() - 1;
+
+        QPointF origin = position(segments[j]), direction;
+        if (j == 0)
+            direction = origin - position(segments[1]);
+        else if (j == last)
+            direction = origin - position(segments[last - 1]);
+        else {
+            QPointF tangent = position(segments[j + 1]) - position(segments[j - 1]);
+            direction = QPointF(-tangent.y(), tangent.x());
+        }
+
+        double norm = std::hypot(direction.x(), direction.y());
+        direction = norm > 0 ? direction / norm : QPointF(1.0, 0.0);
+
+        unsigned n = tipCount[segments[j]]++;
+        double angle = 0.4 * ((n + 1) / 2) * (n % 2 ? 1.0 : -1.0);
+        direction = QPointF(direction.x() * cos(angle) - direction.y() * sin(angle),
+                            direction.x() * sin(angle) + direction.y() * cos(angle));
+
+        double tipLength = offsets.back();
+        bool attachedAtFront = chain.attachedAtFront;
+        addChainNodes(chain, offsets, layout, [&](double offset) {
+            double distance = g_settings->edgeLength + (attachedAtFront ? offset : tipLength - offset);
+            return origin + direction * distance;
+        });
+    }
+}
 
 static void addToOgdfGraph(DeBruijnNode *node,
                            ogdf::Graph &ogdfGraph, ogdf::GraphAttributes &GA,
                            ogdf::EdgeArray<double> &edgeLengths,
-                           OGDFGraphLayout &layout,
-                           double xPos, double yPos, bool linearLayout) {
+                           OGDFGraphLayout &layout) {
     // If this node or its reverse complement is already in OGDF, then
     // it's not necessary to make the node.
     if (layout.contains(node) || layout.contains(node->getReverseComplement()))
@@ -151,8 +331,8 @@ static void addToOgdfGraph(DeBruijnNode *node,
     // Each node in the graph sense is made up of multiple nodes in the
     // OGDF sense.  This way, graph nodes appear as lines whose length
     // corresponds to the sequence length.
-    double drawnNodeLength = getDrawnNodeLength(node);
-    int numberOfGraphEdges = getNumberOfOgdfGraphEdges(drawnNodeLength);
+    double drawnNodeLength = layout::getDrawnNodeLength(node);
+    int numberOfGraphEdges = layout::getNumberOfSegments(drawnNodeLength);
     int numberOfGraphNodes = numberOfGraphEdges + 1;
     double drawnLengthPerEdge = drawnNodeLength / numberOfGraphEdges;
 
@@ -162,12 +342,6 @@ static void addToOgdfGraph(DeBruijnNode *node,
         newNode = ogdfGraph.newNode();
         layout.add(node, newNode);
 
-        if (linearLayout) {
-            GA.x(newNode) = xPos;
-            GA.y(newNode) = yPos;
-            xPos += g_settings->nodeSegmentLength;
-        }
-
         GA.width(newNode) = g_settings->edgeLength;
         GA.height(newNode) = g_settings->edgeLength;
 
@@ -206,109 +380,30 @@ static void addToOgdfGraph(const DeBruijnEdge *edge,
     // don't want to put it in the OGDF graph, because it would be redundant
     // with the node segment (and created conflict with the node/edge length).
     if (startingNode == endingNode &&
-        getNumberOfOgdfGraphEdges(getDrawnNodeLength(startingNode)) == 1)
+        layout::getNumberOfSegments(layout::getDrawnNodeLength(startingNode)) == 1)
         return;
 
     ogdf::edge newEdge = ogdfGraph.newEdge(firstEdgeOgdfNode, secondEdgeOgdfNode);
     edgeArray[newEdge] = g_settings->edgeLength;
 }
 
-void determineLinearNodePositions(ogdf::Graph &ogdfGraph,
-                                  ogdf::GraphAttributes &ogdfGraphAttributes,
-                                  ogdf::EdgeArray<double> &ogdfEdgeLengths,
-                                  OGDFGraphLayout &layout) {
-    const AssemblyGraph &graph = layout.graph();
-    QList<DeBruijnNode *> sortedDrawnNodes;
-
-    // We first try to sort the nodes numerically.
-    QList<QPair<int, DeBruijnNode *>> numericallySortedDrawnNodes;
-    bool successfulIntConversion = true;
-    for (auto *node : graph.m_deBruijnGraphNodes) {
-        if (!node->isDrawn())
-            continue;
-
-        int nodeInt = node->getNameWithoutSign().toInt(&successfulIntConversion);
-        if (!successfulIntConversion)
-            break;
-        numericallySortedDrawnNodes.emplace_back(nodeInt, node);
-    }
-
-    if (successfulIntConversion) {
-        std::sort(numericallySortedDrawnNodes.begin(), numericallySortedDrawnNodes.end(),
-                  [](const auto &a, const auto &b) {return a.first < b.first;});
-        sortedDrawnNodes.reserve(numericallySortedDrawnNodes.size());
-        for (const auto &entry : numericallySortedDrawnNodes)
-            sortedDrawnNodes.push_back(entry.second);
-    } // If any of the conversions from node name to integer failed, then we instead sort the nodes alphabetically.
-    else {
-        for (auto *node : graph.m_deBruijnGraphNodes) {
-            if (!node->isDrawn())
-                continue;
-            sortedDrawnNodes.push_back(node);
-        }
-        std::sort(sortedDrawnNodes.begin(), sortedDrawnNodes.end(),
-                  [](const DeBruijnNode *a, const DeBruijnNode *b) {
-            return QString::localeAwareCompare(a->getNameWithoutSign().toUpper(), b->getNameWithoutSign().toUpper()) < 0;});
-    }
-
-    // Now we add the drawn nodes to the OGDF graph, given them initial positions based on their sort order.
-    QSet<QPair<long long, long long> > usedStartPositions;
-    double lastXPos = 0.0;
-    for (auto *node : sortedDrawnNodes) {
-        if (layout.contains(node) || layout.contains(node->getReverseComplement()))
-            continue;
-        std::vector<DeBruijnNode *> upstreamNodes = node->getUpstreamNodes();
-        for (size_t j = 0; j < upstreamNodes.size(); ++j) {
-            DeBruijnNode * upstreamNode = upstreamNodes[j];
-            if (!layout.contains(upstreamNode))
-                continue;
-
-            ogdf::node upstreamEnd = layout.segments(upstreamNode).back();
-            double upstreamEndPos = ogdfGraphAttributes.x(upstreamEnd);
-            if (j == 0)
-                lastXPos = upstreamEndPos;
-            else
-                lastXPos = std::max(lastXPos, upstreamEndPos);
-        }
-        double xPos = lastXPos + g_settings->edgeLength;
-        double yPos = 0.0;
-        long long intXPos = (long long)(xPos * 100.0);
-        long long intYPos = (long long)(yPos * 100.0);
-        while (usedStartPositions.contains({intXPos, intYPos})) {
-            yPos += g_settings->edgeLength;
-            intYPos = (long long)(yPos * 100.0);
-        }
-        addToOgdfGraph(node, ogdfGraph, ogdfGraphAttributes, ogdfEdgeLengths, layout, xPos, yPos, true);
-        usedStartPositions.insert(QPair<long long, long long>(intXPos, intYPos));
-        lastXPos = ogdfGraphAttributes.x(layout.segments(node).back());
-    }
-}
-
 static void buildGraph(ogdf::Graph &ogdfGraph,
                        ogdf::GraphAttributes &ogdfGraphAttributes,
                        ogdf::EdgeArray<double> &ogdfEdgeLengths,
-                       OGDFGraphLayout &layout,
-                       bool useLinearLayout) {
+                       OGDFGraphLayout &layout) {
     const AssemblyGraph &graph = layout.graph();
-    // If performing a linear layout, we first sort the drawn nodes and add them left-to-right.
-    if (useLinearLayout) {
-        determineLinearNodePositions(ogdfGraph, ogdfGraphAttributes, ogdfEdgeLengths,
-                                     layout);
-        // If the layout isn't linear, then we don't worry about the initial positions because they'll be randomised anyway.
-    } else {
-        for (auto *node : graph.m_deBruijnGraphNodes) {
-            if (!node->isDrawn() ||
-                layout.contains(node) || layout.contains(node->getReverseComplement()))
-                continue;
-
-            addToOgdfGraph(node,
-                           ogdfGraph, ogdfGraphAttributes, ogdfEdgeLengths, layout,
-                           0.0, 0.0, false);
-        }
+    // We don't worry about the initial positions because they'll be randomised anyway.
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        if (!node->isDrawn() ||
+            layout.contains(node) || layout.contains(node->getReverseComplement()))
+            continue;
+
+        addToOgdfGraph(node,
+                       ogdfGraph, ogdfGraphAttributes, ogdfEdgeLengths, layout);
     }
 
     // Then loop through each edge determining its drawn status and adding it to OGDF if it is drawn.
-    for (const DeBruijnEdge *edge : graph.m_deBruijnGraphEdges) {
+    for (const DeBruijnEdge *edge : layout::orderedEdges(graph)) {
         if (!edge->isDrawn())
             continue;
 
@@ -532,12 +627,21 @@ static void reassembleDrawings(ogdf::GraphAttributes &GA,
 }
 
 GraphLayout GraphLayoutWorker::layoutGraph(const AssemblyGraph &graph) {
+    // Linear layout is computed directly, without force-directed refinement
+    if (m_useLinearLayout)
+        return layout::linear(graph);
+
     ogdf::Graph G;
     ogdf::EdgeArray<double> edgeLengths(G);
     ogdf::GraphAttributes GA(G,
                              ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
+    bool coarsen = g_settings->coarsenLayout;
     OGDFGraphLayout layout(graph);
-    buildGraph(G, GA, edgeLengths, layout, m_useLinearLayout);
+    CoarseOGDFLayout coarseLayout(graph);
+    if (coarsen)
+        coarseLayout.build(G, GA, edgeLengths);
+    else
+        buildGraph(G, GA, edgeLengths, layout);
 
     //first we split the graph into its components
     ogdf::NodeArray<int> componentNumber(G);
@@ -549,12 +653,14 @@ GraphLayout GraphLayoutWorker::layoutGraph(const AssemblyGraph &graph) {
     for (auto v : G.nodes)
         nodesInCC[componentNumber[v]].pushBack(v);
 
+    // Every component gets its own seed, so the result does not depend on the
+    // order in which components are processed
+    uint64_t seed = rng::seed(true);
     for (size_t i= 0; i < numberOfComponents; ++i) {
         m_state.emplace_back(new FMMGraphLayout(m_graphLayoutQuality,
-                                               m_useLinearLayout,
                                                m_graphLayoutComponentSeparation,
                                                m_aspectRatio));
-        m_state.back()->init();
+        m_state.back()->init(int(rng::mix(seed, i) & 0x7fffffff));
     }
 
     for (int i = 0; i < numberOfComponents; i++) {
@@ -600,6 +706,11 @@ GraphLayout GraphLayoutWorker::layoutGraph(const AssemblyGraph &graph) {
                        nodesInCC);
 
     GraphLayout res(graph);
+    if (coarsen) {
+        coarseLayout.interpolate(GA, res);
+        return res;
+    }
+
     for (const auto & entry : layout) {
         for (ogdf::node node : entry.second) {
             res.add(entry.first, { GA.x(node), GA.y(node) });
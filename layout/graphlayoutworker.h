@@ -33,17 +33,15 @@ class AssemblyGraph;
 class GraphLayouter {
 public:
     GraphLayouter(int graphLayoutQuality,
-                  bool useLinearLayout,
                   double graphLayoutComponentSeparation,
                   double aspectRatio = 1.333333);
     virtual ~GraphLayouter() {}
-    virtual void init() = 0;
+    virtual void init(int seed) = 0;
     virtual void cancel() = 0;
     virtual void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) = 0;
 
 protected:
     int m_graphLayoutQuality;
-    bool m_useLinearLayout;
     double m_graphLayoutComponentSeparation;
     double m_aspectRatio;
 };
@@ -0,0 +1,285 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "linearlayout.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
+#include "graph/debruijnedge.h"
+
+#include "program/settings.h"
+
+#include <QString>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace layout {
+
+namespace {
+
+// Every drawn node or reverse-complement pair becomes a single unit that is
+// laid out left-to-right in its own orientation.
+struct Unit {
+    DeBruijnNode *node;
+    double length;
+    double x = 0;
+    unsigned track = 0;
+};
+
+// Compressed adjacency lists
+struct Adjacency {
+    std::vector<unsigned> offsets;
+    std::vector<unsigned> targets;
+
+    auto begin(unsigned u) const { return targets.begin() + offsets[u]; }
+    auto end(unsigned u) const { return targets.begin() + offsets[u + 1]; }
+};
+
+Adjacency buildAdjacency(size_t numUnits,
+                         const std::vector<std::pair<unsigned, unsigned>> &links,
+                         bool reversed) {
+    Adjacency res;
+    res.offsets.assign(numUnits + 1, 0);
+    for (const auto &link : links)
+        res.offsets[(reversed ? link.second : link.first) + 1] += 1;
+    for (size_t i = 0; i < numUnits; ++i)
+        res.offsets[i + 1] += res.offsets[i];
+
+    res.targets.resize(links.size());
+    std::vector<unsigned> pos(res.offsets.begin(), res.offsets.end() - 1);
+    for (const auto &link : links) {
+        unsigned from = reversed ? link.second : link.first, to = reversed ? link.first : link.second;
+        res.targets[pos[from]++] = to;
+    }
+
+    return res;
+}
+
+// Nodes are ranked numerically if all names are integers, otherwise
+// alphabetically (case-insensitive, in the user's locale).
+std::vector<unsigned> rankUnits(const std::vector<Unit> &units) {
+    std::vector<unsigned> order(units.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    std::vector<long long> numbers;
+    numbers.reserve(units.size());
+    for (const auto &unit : units) {
+        bool ok = false;
+        long long number = unit.node->getNameWithoutSign().toLongLong(&ok);
+        if (!ok)
+            break;
+        numbers.push_back(number);
+    }
+
+    if (numbers.size() == units.size()) {
+        std::stable_sort(order.begin(), order.end(),
+                         [&](unsigned a, unsigned b) { return numbers[a] < numbers[b]; });
+    } else {
+        std::vector<QString> names;
+        names.reserve(units.size());
+        for (const auto &unit : units)
+            names.emplace_back(unit.node->getNameWithoutSign().toUpper());
+        std::stable_sort(order.begin(), order.end(),
+                         [&](unsigned a, unsigned b) { return QString::localeAwareCompare(names[a], names[b]) < 0; });
+    }
+
+    std::vector<unsigned> rank(units.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        rank[order[i]] = i;
+
+    return rank;
+}
+
+}
+
+GraphLayout linear(const AssemblyGraph &graph) {
+    // Collect units, preferring positive nodes. Unit index is stored shifted
+    // with the lowest bit set for the reverse-complement orientation.
+    std::vector<Unit> units;
+    phmap::flat_hash_map<const DeBruijnNode *, unsigned> unitIndex;
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        if (!node->isDrawn())
+            continue;
+
+        DeBruijnNode *rcNode = node->getReverseComplement();
+        if (unitIndex.contains(node) || unitIndex.contains(rcNode))
+            continue;
+
+        if (!node->isPositiveNode() && rcNode->isDrawn())
+            std::swap(node, rcNode);
+
+        unsigned idx = units.size();
+        units.push_back({ node, getDrawnNodeLength(node) });
+        unitIndex[node] = idx << 1;
+        if (rcNode != node)
+            unitIndex[rcNode] = (idx << 1) | 1;
+    }
+
+    GraphLayout res(graph);
+    if (units.empty())
+        return res;
+
+    std::vector<unsigned> rank = rankUnits(units);
+
+    // Turn edges into links between units going left-to-right
+    std::vector<std::pair<unsigned, unsigned>> links;
+    for (const DeBruijnEdge *edge : graph.m_deBruijnGraphEdges) {
+        if (!edge->isDrawn() ||
+            edge->getOverlapType() == JUMP || edge->getOverlapType() == EXTRA_LINK)
+            continue;
+
+        auto from = unitIndex.find(edge->getStartingNode()), to = unitIndex.find(edge->getEndingNode());
+        if (from == unitIndex.end() || to == unitIndex.end())
+            continue;
+
+        unsigned u = from->second >> 1, v = to->second >> 1;
+        if (u == v)
+            continue;
+
+        bool uReversed = from->second & 1, vReversed = to->second & 1;
+        if (uReversed && vReversed)
+            std::swap(u, v);
+        else if (uReversed != vReversed && rank[u] > rank[v])
+            std::swap(u, v);
+
+        links.emplace_back(u, v);
+    }
+
+    // Edges are stored in a hash set, so the links are put in rank order to
+    // make the layout independent of it
+    std::sort(links.begin(), links.end(),
+              [&](const auto &a, const auto &b) {
+                  return std::make_pair(rank[a.first], rank[a.second]) < std::make_pair(rank[b.first], rank[b.second]);
+              });
+
+    Adjacency successors = buildAdjacency(units.size(), links, false);
+    Adjacency predecessors = buildAdjacency(units.size(), links, true);
+
+    std::vector<unsigned> byRank(units.size());
+    for (unsigned i = 0; i < units.size(); ++i)
+        byRank[rank[i]] = i;
+
+    // Kahn's algorithm seeded in rank order. If we get stuck on a cycle, the
+    // lowest-ranked unplaced unit is taken next.
+    std::vector<unsigned> inDegree(units.size());
+    for (unsigned i = 0; i < units.size(); ++i)
+        inDegree[i] = predecessors.offsets[i + 1] - predecessors.offsets[i];
+
+    std::vector<bool> queued(units.size(), false), placed(units.size(), false);
+    std::deque<unsigned> queue;
+    for (unsigned u : byRank) {
+        if (inDegree[u] == 0) {
+            queue.push_back(u);
+            queued[u] = true;
+        }
+    }
+
+    double gap = g_settings->edgeLength;
+    double trackHeight = g_settings->edgeLength + g_settings->averageNodeWidth;
+    const int maxTrackSearch = 16;
+    std::vector<double> trackEnds;
+
+    size_t rankCursor = 0, numPlaced = 0;
+    while (numPlaced < units.size()) {
+        if (queue.empty()) {
+            while (queued[byRank[rankCursor]])
+                ++rankCursor;
+            queue.push_back(byRank[rankCursor]);
+            queued[byRank[rankCursor]] = true;
+        }
+
+        unsigned u = queue.front();
+        queue.pop_front();
+        Unit &unit = units[u];
+
+        // Layer: right after the furthest placed predecessor. Track: the
+        // nearest free one to the barycenter of predecessor tracks.
+        double x = 0, trackSum = 0;
+        unsigned numPredecessors = 0;
+        for (auto it = predecessors.begin(u), e = predecessors.end(u); it != e; ++it) {
+            if (!placed[*it])
+                continue;
+            const Unit &pred = units[*it];
+            x = std::max(x, pred.x + pred.length + gap);
+            trackSum += pred.track;
+            numPredecessors += 1;
+        }
+
+        long desired = numPredecessors ? std::lround(trackSum / numPredecessors) : 0;
+        long track = long(trackEnds.size());
+        for (int d = 0; d <= maxTrackSearch; ++d) {
+            long candidates[2] = { desired - d, desired + d };
+            bool found = false;
+            for (long t : candidates) {
+                if (t < 0 || t > long(trackEnds.size()))
+                    continue;
+                if (t == long(trackEnds.size()) || trackEnds[t] + gap <= x) {
+                    track = t;
+                    found = true;
+                    break;
+                }
+            }
+            if (found)
+                break;
+        }
+
+        if (track == long(trackEnds.size()))
+            trackEnds.push_back(0);
+        trackEnds[track] = x + unit.length;
+
+        unit.x = x;
+        unit.track = track;
+        placed[u] = true;
+        numPlaced += 1;
+
+        for (auto it = successors.begin(u), e = successors.end(u); it != e; ++it) {
+            unsigned v = *it;
+            if (--inDegree[v] == 0 && !queued[v]) {
+                queue.push_back(v);
+                queued[v] = true;
+            }
+        }
+    }
+
+    // Emit straight horizontal lines, the reverse complement (if drawn) goes
+    // in the opposite direction
+    for (const auto &unit : units) {
+        int numberOfSegments = getNumberOfSegments(unit.length);
+        double y = unit.track * trackHeight;
+
+        auto &segments = res.segments(unit.node);
+        for (int i = 0; i <= numberOfSegments; ++i)
+            segments.emplace_back(unit.x + unit.length * i / numberOfSegments, y);
+
+        DeBruijnNode *rcNode = unit.node->getReverseComplement();
+        if (rcNode == unit.node || !rcNode->isDrawn())
+            continue;
+
+        auto &rcSegments = res.segments(rcNode);
+        for (int i = numberOfSegments; i >= 0; --i)
+            rcSegments.emplace_back(unit.x + unit.length * i / numberOfSegments, y);
+    }
+
+    return res;
+}
+
+}
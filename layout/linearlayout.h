@@ -0,0 +1,31 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graphlayout.h"
+
+namespace layout {
+
+// Deterministic left-to-right layered layout of the drawn part of the graph.
+// Nodes are placed in topological order (cycles are broken by node name order)
+// with x given by the longest upstream path and y by a track assigned close to
+// the barycenter of the upstream nodes. Runs in O(V + E) after the initial
+// sort, no force-directed refinement is performed.
+GraphLayout linear(const AssemblyGraph &graph);
+
+}
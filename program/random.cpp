@@ -0,0 +1,56 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "random.h"
+#include "settings.h"
+#include "globals.h"
+
+#include <QString>
+
+#include <random>
+
+namespace rng {
+
+uint64_t seed(bool fresh) {
+    if (g_settings->randomSeed.on)
+        return uint64_t(g_settings->randomSeed.val);
+
+    if (fresh)
+        return std::random_device{}();
+
+    static const uint64_t sessionSeed = std::random_device{}();
+    return sessionSeed;
+}
+
+uint64_t mix(uint64_t seed, uint64_t value) {
+    uint64_t z = seed + 0x9e3779b97f4a7c15ULL * (value + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t mix(uint64_t seed, const QString &str) {
+    // FNV-1a over UTF-16 code units, so the value does not depend on qHash seeding
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (QChar c : str) {
+        h ^= c.unicode();
+        h *= 0x100000001b3ULL;
+    }
+    return mix(seed, h);
+}
+
+}
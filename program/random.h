@@ -0,0 +1,37 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+class QString;
+
+// All pseudo-random choices (layout, random colours, overlap search) derive
+// from a single seed, so that results are reproducible when it is fixed.
+namespace rng {
+
+// The seed set by the user, or one chosen randomly once per program run. If
+// fresh is true and no seed was set, a new random value is returned each time.
+uint64_t seed(bool fresh = false);
+
+// Stateless mixing of a value into a seed (splitmix64). Unlike a shared
+// generator, the result does not depend on the order of calls.
+uint64_t mix(uint64_t seed, uint64_t value);
+uint64_t mix(uint64_t seed, const QString &str);
+
+}
@@ -20,6 +20,8 @@
 #include "graph/nodecolorer.h"
 #include <QDir>
 
+#include <limits>
+
 Settings::Settings()
 {
     doubleMode = false;
@@ -31,6 +33,10 @@ Settings::Settings()
     minTotalGraphLength = 500.0;
     graphLayoutQuality = IntSetting(2, 0, 4);
     linearLayout = false;
+    coarsenLayout = false;
+    coarseTipLength = IntSetting(150, 0, 1000000);
+    maxNodeSegments = IntSetting(50, 1, 100000);
+    randomSeed = IntSetting(0, 0, std::numeric_limits<int>::max(), false);
     minimumNodeLength = FloatSetting(5.0, 1.0, 100.0);
     edgeLength = FloatSetting(5.0, 0.1, 100.0);
     doubleModeNodeSeparation = FloatSetting(2.0, 0.0, 100.0);
@@ -49,6 +55,9 @@ Settings::Settings()
     arrowheadsInSingleMode = false;
     textOutlineThickness = FloatSetting(1.5, 0.0, 10.0);
 
+    lodNodeWidth = FloatSetting(1.0, 0.0, 100.0);
+    lodEdgeLength = FloatSetting(4.0, 0.0, 100.0);
+
     blastRainbowPartsPerQuery = 100;
 
     graphScope = WHOLE_GRAPH;
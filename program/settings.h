@@ -100,6 +100,10 @@ public:
     double minTotalGraphLength;
     IntSetting graphLayoutQuality;
     bool linearLayout;
+    bool coarsenLayout;
+    IntSetting coarseTipLength;
+    IntSetting maxNodeSegments;
+    IntSetting randomSeed;
     FloatSetting minimumNodeLength;
     FloatSetting edgeLength;
     FloatSetting doubleModeNodeSeparation;
@@ -118,6 +122,11 @@ public:
     bool arrowheadsInSingleMode;
     FloatSetting textOutlineThickness;
 
+    // Level of detail: nodes thinner than this (in pixels) are drawn as plain
+    // polylines, edges shorter than this are drawn as straight lines
+    FloatSetting lodNodeWidth;
+    FloatSetting lodEdgeLength;
+
     int blastRainbowPartsPerQuery;
 
     GraphScope graphScope;
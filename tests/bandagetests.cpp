@@ -22,15 +22,26 @@
 #include "graph/graphicsitemedge.h"
 #include "graph/graphicsitemnode.h"
 #include "graph/annotationsmanager.h"
+#include "graph/fastawriter.h"
 #include "graph/gfawriter.h"
+#include "graph/contiguity.h"
+#include "graph/nodecolorers.h"
+#include "graph/sequenceutils.h"
+#include "io/fileutils.h"
 #include "graph/io.h"
 
 #include "layout/graphlayoutworker.h"
 #include "layout/io.h"
 
+#include "ui/bandagegraphicsscene.h"
+#include "ui/graphrenderer.h"
+#include "ui/imageexport.h"
+
+#include "program/colormap.h"
 #include "program/settings.h"
 #include "program/memory.h"
 #include "program/globals.h"
+#include "program/random.h"
 #include "command_line/commoncommandlinefunctions.h"
 #include "command_line/settings.h"
 
@@ -41,9 +52,18 @@
 #include <QtTest/QtTest>
 #include <QDebug>
 #include <QTemporaryDir>
-
+#include <QCryptographicHash>
+#include <QThreadPool>
+#include <QSvgRenderer>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
 #include <iostream>
 
+#include <zlib.h>
+
 class BandageTests : public QObject
 {
     Q_OBJECT
@@ -113,18 +133,43 @@ private slots:
     void pathFunctionsOnGfaSequencesInGraph();
     void pathFunctionsOnGfaSequencesInFasta();
     void graphLocationFunctions();
+    void nodeEdgeRanges();
+    void contiguitySearch();
+    void contiguityMatchesExhaustiveSearch();
     void loadCsvData();
     void loadCsvDataTrinity();
+    void loadCsvColumnTypes();
     void blastSearch();
     void blastSearchFilters();
     void graphScope();
+    void graphScopeManyStartingNodes();
     void graphLayout();
+    void graphLayoutCoarsened();
+    void graphLayoutLinear();
+    void graphLayoutReproducible();
+    void tiledPngExport();
+    void tiledRenderMatchesUntiled();
+    void parallelTilesMatchSequential();
+    void svgExport();
+    void graphRendererMatchesScene();
+    void sceneSelectionTracking();
+    void bulkNodeColouring();
+    void randomColourSeed();
     void commandLineSettings();
     void sciNotComparisons();
     void graphEdits();
     void fastgToGfa();
     void mergeNodesOnGfa();
     void changeNodeNames();
+    void partialNodeNameSearch();
+    void gfaWriterParallel();
+    void fastaExport();
+    void pathFastaExport();
+    void fastxReader();
+    void bulkDeletion();
+    void mergeSelectedNodes();
+    void editJournalUndoRedo();
+    void editJournalSceneUndo();
     void changeNodeDepths();
     void blastQueryPaths();
     void bandageInfo();
@@ -133,6 +178,7 @@ private slots:
     void sequenceAccess();
     void sequenceSubstring();
     void sequenceDoubleReverseComplement();
+    void sequenceBuilder();
 
 
 private:
@@ -476,6 +522,139 @@ void BandageTests::graphLocationFunctions()
     QCOMPARE(location3.isNull(), true);
 }
 
+void BandageTests::nodeEdgeRanges()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    //Every edge leaves exactly one node and enters exactly one node.
+    size_t leavingCount = 0, enteringCount = 0;
+    for (auto it = g_assemblyGraph->m_deBruijnGraphNodes.begin(); it != g_assemblyGraph->m_deBruijnGraphNodes.end(); ++it) {
+        const DeBruijnNode *node = it.value();
+
+        std::vector<DeBruijnEdge *> leaving, entering;
+        for (auto *edge : node->edges()) {
+            if (edge->getStartingNode() == node)
+                leaving.push_back(edge);
+            if (edge->getEndingNode() == node)
+                entering.push_back(edge);
+        }
+
+        QCOMPARE(node->getLeavingEdges(), leaving);
+        QCOMPARE(node->getEnteringEdges(), entering);
+        QCOMPARE(node->leavingEdges().empty(), leaving.empty());
+        QCOMPARE(node->enteringEdges().empty(), entering.empty());
+
+        std::vector<DeBruijnNode *> downstream, upstream;
+        for (auto *edge : leaving)
+            downstream.push_back(edge->getEndingNode());
+        for (auto *edge : entering)
+            upstream.push_back(edge->getStartingNode());
+        QCOMPARE(node->getDownstreamNodes(), downstream);
+        QCOMPARE(node->getUpstreamNodes(), upstream);
+
+        auto leavingRange = node->leavingEdges(), enteringRange = node->enteringEdges();
+        leavingCount += std::distance(leavingRange.begin(), leavingRange.end());
+        enteringCount += std::distance(enteringRange.begin(), enteringRange.end());
+    }
+
+    QCOMPARE(leavingCount, g_assemblyGraph->m_deBruijnGraphEdges.size());
+    QCOMPARE(enteringCount, g_assemblyGraph->m_deBruijnGraphEdges.size());
+}
+
+void BandageTests::contiguitySearch()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+
+    const DeBruijnNode *startingNode = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    unsigned steps = g_settings->contiguitySearchSteps;
+    ContiguityStatuses statuses;
+    QVERIFY(contiguity::determine(startingNode, steps, statuses));
+
+    auto status = [&](const char *name) {
+        auto it = statuses.find(g_assemblyGraph->m_deBruijnGraphNodes[name]);
+        return it == statuses.end() ? NOT_CONTIGUOUS : it->second;
+    };
+    QVERIFY(status("1+") == STARTING);
+    QVERIFY(status("2-") == CONTIGUOUS_STRAND_SPECIFIC);
+    QVERIFY(status("4-") == CONTIGUOUS_STRAND_SPECIFIC);
+    QVERIFY(status("2+") == CONTIGUOUS_EITHER_STRAND);
+    QVERIFY(status("4+") == CONTIGUOUS_EITHER_STRAND);
+
+    size_t maybeContiguous = 0;
+    for (const auto &[node, nodeStatus] : statuses)
+        maybeContiguous += nodeStatus == MAYBE_CONTIGUOUS;
+    QCOMPARE(maybeContiguous, 10);
+
+    //Searching again only confirms the statuses found.
+    ContiguityStatuses again = statuses;
+    QVERIFY(contiguity::determine(startingNode, steps, again));
+    QVERIFY(again == statuses);
+
+    //A cancelled search stops before looking at any other node.
+    std::atomic<bool> cancelled = true;
+    ContiguityStatuses partial;
+    QVERIFY(!contiguity::determine(startingNode, steps, partial, &cancelled));
+    QCOMPARE(partial.size(), 1);
+
+    //Every node found is checked for a path leading back to the starting
+    //node, not just the starting node itself.
+    statuses.clear();
+    QVERIFY(contiguity::determine(g_assemblyGraph->m_deBruijnGraphNodes["9+"], steps, statuses));
+    QVERIFY(status("12+") == CONTIGUOUS_STRAND_SPECIFIC);
+    QVERIFY(status("12-") == CONTIGUOUS_EITHER_STRAND);
+}
+
+void BandageTests::contiguityMatchesExhaustiveSearch()
+{
+    //The expected statuses were found by following every path one by one.
+    QFile file(testFile("test_contiguity.txt"));
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+
+    auto findNode = [](const QString &name) -> const DeBruijnNode * {
+        auto it = g_assemblyGraph->m_deBruijnGraphNodes.find(name.toStdString());
+        return it == g_assemblyGraph->m_deBruijnGraphNodes.end() ? nullptr : it.value();
+    };
+
+    unsigned steps = 0;
+    std::vector<const DeBruijnNode *> nodes;
+    size_t startingNodes = 0;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QStringList fields = in.readLine().split(' ', Qt::SkipEmptyParts);
+        if (fields.isEmpty() || fields.front().startsWith('#'))
+            continue;
+
+        if (fields.front() == "steps") {
+            steps = fields.back().toUInt();
+        } else if (fields.front() == "graph") {
+            QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile(fields.back())));
+        } else if (fields.front() == "nodes") {
+            QCOMPARE(size_t(fields.size() - 1), g_assemblyGraph->m_deBruijnGraphNodes.size());
+            nodes.clear();
+            for (auto it = fields.begin() + 1; it != fields.end(); ++it) {
+                nodes.push_back(findNode(*it));
+                QVERIFY(nodes.back());
+            }
+        } else {
+            const DeBruijnNode *startingNode = findNode(fields.front());
+            QVERIFY(startingNode);
+            ContiguityStatuses statuses;
+            QVERIFY(contiguity::determine(startingNode, steps, statuses));
+
+            QString found;
+            for (const auto *node : nodes) {
+                auto it = statuses.find(node);
+                found += QString::number(it == statuses.end() ? NOT_CONTIGUOUS : it->second);
+            }
+            QVERIFY2(found == fields.back(), qPrintable(fields.front() + " " + found));
+            ++startingNodes;
+        }
+    }
+
+    //Every node of test.gfa and test.fastg
+    QCOMPARE(startingNodes, 34 + 88);
+}
+
 
 
 void BandageTests::loadCsvData()
@@ -580,6 +759,61 @@ void BandageTests::loadCsvDataTrinity()
     QCOMPARE(g_assemblyGraph->getCsvLine(node3940Plus, 0), QString("3940PLUS"));
 }
 
+void BandageTests::loadCsvColumnTypes()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+
+    QString csvFilename = tempFile("types.csv");
+    {
+        QFile file(csvFilename);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("Node,Depth,Colour,Shade,\"Quoted, header\"\r\n"
+                   "1,10,red,red,\"x, \"\"y\"\"\"\r\n"
+                   "2,20,#00ff00,blue,\r\n"
+                   "\r\n"
+                   "3,15,blue,red,z\r\n"
+                   "4,,notacolour,green,z\r\n"
+                   "5,1e1,other\r\n");
+    }
+
+    QString errormsg;
+    QStringList columns;
+    bool coloursLoaded = false;
+    QVERIFY(g_assemblyGraph->loadCSV(csvFilename, &columns, &errormsg, &coloursLoaded));
+    QCOMPARE(errormsg, "");
+    QCOMPARE(columns, QStringList({ "Depth", "Colour", "Shade", "Quoted, header" }));
+    QVERIFY(coloursLoaded);
+
+    const CsvData &csvData = g_assemblyGraph->m_csvData;
+    QCOMPARE(csvData.columnCount(), 4);
+    QCOMPARE(csvData.column(0).type, CsvData::ColumnType::NUMBER);
+    QCOMPARE(csvData.column(1).type, CsvData::ColumnType::TEXT);
+    QCOMPARE(csvData.column(2).type, CsvData::ColumnType::COLOUR);
+    QCOMPARE(csvData.column(3).type, CsvData::ColumnType::TEXT);
+
+    // Values are stored once per column
+    QCOMPARE(csvData.column(2).values.size(), 4);
+    QCOMPARE(csvData.column(0).numbers.size(), csvData.column(0).values.size());
+    QVERIFY(std::isnan(csvData.column(0).numbers[3]));
+    QCOMPARE(csvData.column(0).numbers[4], 10.0);
+
+    DeBruijnNode *node1 = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    DeBruijnNode *node2 = g_assemblyGraph->m_deBruijnGraphNodes["2+"];
+    DeBruijnNode *node4 = g_assemblyGraph->m_deBruijnGraphNodes["4+"];
+    DeBruijnNode *node5 = g_assemblyGraph->m_deBruijnGraphNodes["5+"];
+    QCOMPARE(g_assemblyGraph->getCsvLine(node1, 3), QString("x, \"y\""));
+    QCOMPARE(g_assemblyGraph->getCsvLine(node2, 3), QString(""));
+    QCOMPARE(g_assemblyGraph->getAllCsvData(node5).join("|"), "1e1|other||");
+    QVERIFY(!g_assemblyGraph->hasCsvData(g_assemblyGraph->m_deBruijnGraphNodes["6+"]));
+
+    // The colour column gives custom colours, values that are not colours
+    // are given preset colours
+    QCOMPARE(g_assemblyGraph->getCustomColour(node1), QColor("red"));
+    QCOMPARE(g_assemblyGraph->getCustomColour(node2), QColor("#00ff00"));
+    QCOMPARE(g_assemblyGraph->getCustomColour(node4), getPresetColours()[0]);
+    QCOMPARE(g_assemblyGraph->getCustomColour(node5), getPresetColours()[1]);
+}
+
 void BandageTests::blastSearch()
 {
     QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
@@ -875,6 +1109,68 @@ void BandageTests::graphScope()
 }
 
 
+//The nodes within the given distance of each starting node, searched one
+//starting node at a time as markNodesToDraw used to do.
+static std::set<const DeBruijnNode *> nodesAroundEach(const std::vector<DeBruijnNode *> &startingNodes,
+                                                      int distance, bool doubleMode) {
+    auto drawnNode = [&](DeBruijnNode *node) {
+        return doubleMode ? node : node->getCanonical();
+    };
+
+    std::set<const DeBruijnNode *> drawn;
+    for (auto *startingNode : startingNodes) {
+        std::set<const DeBruijnNode *> seen{ drawnNode(startingNode) };
+        std::vector<DeBruijnNode *> frontier{ drawnNode(startingNode) };
+        for (int depth = 0; depth < distance; ++depth) {
+            std::vector<DeBruijnNode *> next;
+            for (auto *node : frontier) {
+                for (auto *edge : node->edges()) {
+                    auto *otherNode = drawnNode(edge->getOtherNode(node));
+                    if (seen.insert(otherNode).second)
+                        next.push_back(otherNode);
+                }
+            }
+            frontier = std::move(next);
+        }
+        drawn.insert(seen.begin(), seen.end());
+    }
+
+    return drawn;
+}
+
+void BandageTests::graphScopeManyStartingNodes()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    std::vector<DeBruijnNode *> allNodes;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+        allNodes.push_back(node);
+
+    //Overlapping neighbourhoods, seeded by both strands of the same node
+    //and by starting nodes next to each other.
+    for (size_t stride : { 1, 3, 7, 20 }) {
+        std::vector<DeBruijnNode *> startingNodes;
+        for (size_t i = 0; i < allNodes.size(); i += stride)
+            startingNodes.push_back(allNodes[i]);
+
+        for (bool doubleMode : { false, true }) {
+            g_settings->doubleMode = doubleMode;
+            for (int distance = 0; distance <= 4; ++distance) {
+                auto scope = graph::Scope::aroundNodes("", distance);
+                g_assemblyGraph->resetNodes();
+                g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+
+                std::set<const DeBruijnNode *> drawn;
+                for (auto *node : allNodes) {
+                    if (node->isDrawn())
+                        drawn.insert(node);
+                }
+                QVERIFY(drawn == nodesAroundEach(startingNodes, distance, doubleMode));
+            }
+        }
+    }
+}
+
 void BandageTests::graphLayout() {
     QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
 
@@ -916,6 +1212,443 @@ void BandageTests::graphLayout() {
     }
 }
 
+void BandageTests::graphLayoutCoarsened() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->coarsenLayout = true;
+
+    for (bool doubleMode : { false, true }) {
+        g_settings->doubleMode = doubleMode;
+        g_assemblyGraph->resetNodes();
+        g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+        int drawnNodes = g_assemblyGraph->getDrawnNodeCount();
+
+        auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                        g_settings->linearLayout,
+                                        g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+        // Every drawn node should get its own positions even though chains
+        // and tips were laid out as a whole.
+        QCOMPARE(layout.size(), drawnNodes);
+        for (const auto &entry : layout) {
+            QVERIFY(entry.first->isDrawn());
+            QVERIFY(entry.second.size() >= 2);
+            QVERIFY(int(entry.second.size()) <= g_settings->maxNodeSegments + 1);
+        }
+    }
+}
+
+void BandageTests::graphLayoutLinear() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->linearLayout = true;
+
+    for (bool doubleMode : { false, true }) {
+        g_settings->doubleMode = doubleMode;
+        g_assemblyGraph->resetNodes();
+        g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+        int drawnNodes = g_assemblyGraph->getDrawnNodeCount();
+
+        auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                        g_settings->linearLayout,
+                                        g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+        QCOMPARE(layout.size(), drawnNodes);
+
+        // Nodes are straight horizontal lines
+        for (const auto &entry : layout) {
+            QVERIFY(entry.second.size() >= 2);
+            for (const auto &point : entry.second)
+                QCOMPARE(point.y(), entry.second.front().y());
+        }
+
+        // Linear layout is deterministic
+        auto layout2 = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                         g_settings->linearLayout,
+                                         g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+        QCOMPARE(layout2.size(), layout.size());
+        for (const auto &entry : layout) {
+            const auto &segments = layout2.segments(entry.first);
+            QCOMPARE(segments.size(), entry.second.size());
+            for (size_t i = 0; i < segments.size(); ++i)
+                QCOMPARE(segments[i], entry.second[i]);
+        }
+    }
+}
+
+static QByteArray layoutHash(const GraphLayout &layout) {
+    std::vector<std::pair<QString, const DeBruijnNode *>> nodes;
+    for (const auto &entry : layout)
+        nodes.emplace_back(entry.first->getName(), entry.first);
+    std::sort(nodes.begin(), nodes.end());
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const auto &[name, node] : nodes) {
+        hash.addData(name.toUtf8());
+        for (const QPointF &point : layout.segments(node)) {
+            double coords[2] = { point.x(), point.y() };
+            hash.addData(QByteArrayView(reinterpret_cast<const char *>(coords), sizeof(coords)));
+        }
+    }
+
+    return hash.result();
+}
+
+void BandageTests::graphLayoutReproducible() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->randomSeed = 42;
+    g_settings->randomSeed.on = true;
+    g_settings->doubleMode = true;
+    g_assemblyGraph->resetNodes();
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+
+    auto hashOf = [](bool coarsen) {
+        g_settings->coarsenLayout = coarsen;
+        return layoutHash(GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                            g_settings->linearLayout,
+                                            g_settings->componentSeparation).layoutGraph(*g_assemblyGraph));
+    };
+
+    // Same seed should give the same layout across runs and thread counts
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int maxThreadCount = pool->maxThreadCount();
+    for (bool coarsen : { false, true }) {
+        QByteArray reference = hashOf(coarsen);
+        QCOMPARE(hashOf(coarsen), reference);
+
+        pool->setMaxThreadCount(1);
+        QCOMPARE(hashOf(coarsen), reference);
+        pool->setMaxThreadCount(maxThreadCount);
+    }
+}
+
+void BandageTests::tiledPngExport() {
+    // The image covers several tiles in both directions
+    QRectF sceneRect(0, 0, 500, 30);
+    QSize imageSize(5000, 300);
+    auto render = [](QPainter &painter, const QRectF &target, const QRectF &source) {
+        painter.save();
+        painter.translate(target.topLeft());
+        painter.scale(target.width() / source.width(), target.height() / source.height());
+        painter.translate(-source.topLeft());
+        for (int i = 0; i < 50; ++i)
+            painter.fillRect(QRectF(i * 10, i % 3 * 10, 5, 10), QColor::fromHsv(i * 7, 255, 255));
+        painter.restore();
+    };
+
+    QString fileName = tempFile("tiled.png");
+    QVERIFY(image::saveTiledPng(fileName, imageSize, sceneRect, render));
+
+    QImage expected(imageSize, QImage::Format_RGB32);
+    expected.fill(Qt::white);
+    QPainter painter(&expected);
+    render(painter, QRectF(QPointF(0, 0), imageSize), sceneRect);
+    painter.end();
+
+    QImage tiled(fileName);
+    QCOMPARE(tiled.size(), imageSize);
+    QCOMPARE(tiled.convertToFormat(QImage::Format_RGB32), expected);
+
+    // Wider images do not fit into a strip of tiles
+    QVERIFY(!image::saveTiledPng(tempFile("wide.png"), QSize(image::maxTiledPngWidth + 1, 10),
+                                 sceneRect, render));
+}
+
+void BandageTests::svgExport() {
+    QRectF sceneRect(0, 0, 500, 30);
+    QSize imageSize(1000, 60);
+    auto render = [](QPainter &painter, const QRectF &target, const QRectF &source) {
+        painter.save();
+        painter.translate(target.topLeft());
+        painter.scale(target.width() / source.width(), target.height() / source.height());
+        painter.translate(-source.topLeft());
+        for (int i = 0; i < 50; ++i)
+            painter.fillRect(QRectF(i * 10, i % 3 * 10, 5, 10), QColor::fromHsv(i % 5 * 70, 255, 255));
+        painter.restore();
+    };
+
+    QString fileName = tempFile("graph.svg"), compressedFileName = tempFile("graph.svgz");
+    QVERIFY(image::saveSvg(fileName, imageSize, sceneRect, render));
+    QVERIFY(image::saveSvg(compressedFileName, imageSize, sceneRect, render, true));
+    QVERIFY(QFileInfo(compressedFileName).size() < QFileInfo(fileName).size());
+
+    // Only 5 distinct colours (plus the background) are used
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray svg = file.readAll();
+    QCOMPARE(svg.count("<path "), 51);
+    QCOMPARE(svg.count("{fill:"), 6);
+
+    for (const auto &name : { fileName, compressedFileName }) {
+        QSvgRenderer renderer(name);
+        QVERIFY(renderer.isValid());
+        QImage image(imageSize, QImage::Format_RGB32);
+        image.fill(Qt::black);
+        QPainter painter(&image);
+        renderer.render(&painter);
+        painter.end();
+
+        QCOMPARE(image.pixelColor(1, 50), QColor(Qt::white));
+        for (int i = 0; i < 50; ++i)
+            QCOMPARE(image.pixelColor(i * 20 + 5, i % 3 * 20 + 10), QColor::fromHsv(i % 5 * 70, 255, 255).toRgb());
+    }
+}
+
+// Antialiased edges could differ slightly, as every tile is painted with its
+// own transform
+static bool imagesMatch(const QImage &a, const QImage &b, int tolerance) {
+    if (a.size() != b.size())
+        return false;
+
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            QRgb p = a.pixel(x, y), q = b.pixel(x, y);
+            if (std::abs(qRed(p) - qRed(q)) > tolerance ||
+                std::abs(qGreen(p) - qGreen(q)) > tolerance ||
+                std::abs(qBlue(p) - qBlue(q)) > tolerance)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void BandageTests::tiledRenderMatchesUntiled() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->displayNodeNames = true;
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+    BandageGraphicsScene scene;
+    scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
+    scene.setSceneRectangle();
+
+    // The scene is always rendered one tile at a time
+    QImage tiled(3000, 2000, QImage::Format_ARGB32);
+    image::renderTiled(tiled, scene.sceneRect(),
+                       [&scene](QPainter &painter, const QRectF &target, const QRectF &source) {
+                           scene.render(&painter, target, source, Qt::IgnoreAspectRatio);
+                       });
+
+    QImage untiled(3000, 2000, QImage::Format_ARGB32);
+    untiled.fill(Qt::white);
+    QPainter painter(&untiled);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    scene.render(&painter);
+    painter.end();
+
+    QVERIFY(imagesMatch(tiled, untiled, 8));
+    QVERIFY(tiled.pixelColor(0, 0) == QColor(Qt::white));
+}
+
+void BandageTests::parallelTilesMatchSequential() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->displayNodeNames = true;
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+    GraphRenderer renderer(*g_assemblyGraph, layout);
+    auto render = [&renderer](QPainter &painter, const QRectF &target, const QRectF &source) {
+        renderer.render(painter, target, source);
+    };
+
+    // Tiles rendered concurrently give exactly the same bytes as tiles
+    // rendered one after another
+    QImage sequential(3000, 2000, QImage::Format_ARGB32), parallel(3000, 2000, QImage::Format_ARGB32);
+    image::renderTiled(sequential, renderer.sceneRect(), render);
+    image::renderTiled(parallel, renderer.sceneRect(), render, true);
+    QCOMPARE(parallel, sequential);
+
+    auto readAll = [](const QString &fileName) {
+        QFile file(fileName);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+    QString sequentialFile = tempFile("sequential.png"), parallelFile = tempFile("parallel.png");
+    QVERIFY(image::saveTiledPng(sequentialFile, sequential.size(), renderer.sceneRect(), render));
+    QVERIFY(image::saveTiledPng(parallelFile, sequential.size(), renderer.sceneRect(), render, true));
+    QByteArray sequentialBytes = readAll(sequentialFile);
+    QVERIFY(!sequentialBytes.isEmpty());
+    QCOMPARE(readAll(parallelFile), sequentialBytes);
+}
+
+void BandageTests::graphRendererMatchesScene() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->displayNodeNames = true;
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+    QImage direct(2000, 1500, QImage::Format_ARGB32), fromScene(2000, 1500, QImage::Format_ARGB32);
+    QRectF directSceneRect;
+    {
+        GraphRenderer renderer(*g_assemblyGraph, layout);
+        directSceneRect = renderer.sceneRect();
+        image::renderTiled(direct, directSceneRect,
+                           [&renderer](QPainter &painter, const QRectF &target, const QRectF &source) {
+                               renderer.render(painter, target, source);
+                           }, true);
+    }
+
+    BandageGraphicsScene scene;
+    scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
+    scene.setSceneRectangle();
+    QCOMPARE(directSceneRect, scene.sceneRect());
+    image::renderTiled(fromScene, scene.sceneRect(),
+                       [&scene](QPainter &painter, const QRectF &target, const QRectF &source) {
+                           scene.render(&painter, target, source, Qt::IgnoreAspectRatio);
+                       });
+
+    QCOMPARE(direct, fromScene);
+}
+
+void BandageTests::sceneSelectionTracking() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+    BandageGraphicsScene scene;
+    scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
+    QCOMPARE(scene.getSelectedNodeCount(), 0);
+
+    // Only one node of each pair is drawn in single mode
+    auto drawnNode = [](const std::string &name) {
+        DeBruijnNode *node = g_assemblyGraph->m_deBruijnGraphNodes[name];
+        return node->getGraphicsItemNode() ? node : node->getReverseComplement();
+    };
+    DeBruijnNode *node1 = drawnNode("1+"), *node2 = drawnNode("2+"), *node10 = drawnNode("10+");
+    for (auto *node : { node10, node2, node1 })
+        node->getGraphicsItemNode()->setSelected(true);
+    DeBruijnEdge *edge = getEdgeFromNodeNames("1+", "12-");
+    if (!edge->getGraphicsItemEdge())
+        edge = edge->getReverseComplement();
+    edge->getGraphicsItemEdge()->setSelected(true);
+
+    // Nodes are sorted numerically
+    QCOMPARE(scene.getSelectedNodes(), std::vector<DeBruijnNode *>({ node1, node2, node10 }));
+    QCOMPARE(scene.getSelectedEdges(), std::vector<DeBruijnEdge *>({ edge }));
+    QCOMPARE(scene.getSelectedNodesTotalLength(),
+             node1->getLength() + node2->getLength() + node10->getLength());
+    QCOMPARE(scene.getSelectedNodesMeanDepth(), AssemblyGraph::getMeanDepth({ node1, node2, node10 }));
+    QCOMPARE(scene.getSelectedNodeCount(), size_t(scene.selectedItems().size() - 1));
+
+    node2->getGraphicsItemNode()->setSelected(false);
+    QCOMPARE(scene.getSelectedNodes(), std::vector<DeBruijnNode *>({ node1, node10 }));
+
+    // Removing items from the scene drops them from the selection
+    BandageGraphicsScene::removeGraphicsItemNodes({ node10 }, true);
+    QCOMPARE(scene.getSelectedNodes(), std::vector<DeBruijnNode *>({ node1 }));
+    QCOMPARE(scene.getOneSelectedNode(), node1);
+
+    scene.clearSelection();
+    QCOMPARE(scene.getSelectedNodeCount(), 0);
+    QCOMPARE(scene.getSelectedEdgeCount(), 0);
+}
+
+void BandageTests::bulkNodeColouring() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+    QString errormsg;
+    QStringList columns;
+    bool coloursLoaded = false;
+    QVERIFY(g_assemblyGraph->loadCSV(testFile("test.csv"), &columns, &errormsg, &coloursLoaded));
+
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+    BandageGraphicsScene scene;
+    scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
+
+    std::vector<const DrawnNode *> items;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        if (auto *item = node->getGraphicsItemNode())
+            items.push_back(item);
+    }
+    QVERIFY(!items.empty());
+
+    // Colouring all nodes at once gives the same colours as one by one
+    auto checkBulkColours = [&items]() {
+        std::vector<QColor> colours(items.size());
+        g_settings->nodeColorer->colourAll(items, colours);
+        for (size_t i = 0; i < items.size(); ++i)
+            QCOMPARE(colours[i], g_settings->nodeColorer->get(items[i]));
+    };
+
+    for (int scheme = 0; scheme <= LAST_SCHEME; ++scheme) {
+        g_settings->initializeColorer(NodeColorScheme(scheme));
+        checkBulkColours();
+    }
+
+    // Every tag and column has its own colours
+    g_settings->initializeColorer(TAG_VALUE);
+    auto *tagColorer = dynamic_cast<TagValueNodeColorer *>(&*g_settings->nodeColorer);
+    QVERIFY(!tagColorer->tagNames().empty());
+    for (const auto &tagName : tagColorer->tagNames()) {
+        tagColorer->setTagName(tagName);
+        checkBulkColours();
+    }
+
+    g_settings->initializeColorer(CSV_COLUMN);
+    auto *csvColorer = dynamic_cast<CSVNodeColorer *>(&*g_settings->nodeColorer);
+    for (unsigned column = 0; column < unsigned(columns.size()); ++column) {
+        csvColorer->setColumnIdx(column);
+        checkBulkColours();
+
+        // Nodes with the same value share the colour
+        std::map<QString, QColor> valueColours;
+        for (auto *item : items) {
+            if (!g_assemblyGraph->hasCsvData(item->m_deBruijnNode))
+                continue;
+
+            QString value = *g_assemblyGraph->getCsvLine(item->m_deBruijnNode, column);
+            auto it = valueColours.emplace(value, csvColorer->get(item)).first;
+            QCOMPARE(it->second, csvColorer->get(item));
+        }
+        QVERIFY(!valueColours.empty());
+    }
+}
+
+void BandageTests::randomColourSeed() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+    BandageGraphicsScene scene;
+    scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
+
+    std::vector<GraphicsItemNode *> items;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        if (auto *item = node->getGraphicsItemNode())
+            items.push_back(item);
+    }
+    QVERIFY(!items.empty());
+
+    auto coloursOf = [&items](RandomNodeColorer &colorer) {
+        std::vector<QColor> colours;
+        for (auto *item : items)
+            colours.push_back(colorer.get(item));
+        return colours;
+    };
+
+    // Colorers share the session seed, a fresh seed gives other colours
+    RandomNodeColorer colorer1(RANDOM_COLOURS), colorer2(RANDOM_COLOURS);
+    QCOMPARE(colorer1.seed(), colorer2.seed());
+    QCOMPARE(coloursOf(colorer1), coloursOf(colorer2));
+    colorer2.setSeed(colorer1.seed() + 1);
+    QVERIFY(coloursOf(colorer1) != coloursOf(colorer2));
+
+    // A fixed seed is used even when a fresh one is requested
+    g_settings->randomSeed = 42;
+    g_settings->randomSeed.on = true;
+    QCOMPARE(rng::seed(true), uint64_t(42));
+    QCOMPARE(RandomNodeColorer(RANDOM_COLOURS).seed(), uint64_t(42));
+}
+
 static void parseSettings(const QStringList &commandLineSettings) {
     std::vector<std::string> strings;
     std::vector<const char*> argv;
@@ -1472,6 +2205,456 @@ void BandageTests::changeNodeNames()
     QCOMPARE(nodeCountBefore, nodeCountAfter);
 }
 
+static std::vector<DeBruijnNode *> partialNodeNameScan(const QString &queryName) {
+    std::vector<DeBruijnNode *> result;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        if (node->getName().contains(queryName))
+            result.push_back(node);
+    }
+    return result;
+}
+
+void BandageTests::partialNodeNameSearch()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    for (QString query : { "1", "2+", "-", "33", "1-", "+", "123456", "88+" }) {
+        std::vector<QString> notFound;
+        auto nodes = g_assemblyGraph->getNodesFromStringList(query, false, &notFound);
+        auto expected = partialNodeNameScan(query);
+        QCOMPARE(nodes, expected);
+        QCOMPARE(notFound.empty(), !expected.empty());
+    }
+
+    // Results of all terms are concatenated
+    auto nodes = g_assemblyGraph->getNodesFromStringList("5, 7-", false, nullptr);
+    auto expected = partialNodeNameScan("5");
+    auto expected7 = partialNodeNameScan("7-");
+    expected.insert(expected.end(), expected7.begin(), expected7.end());
+    QCOMPARE(nodes, expected);
+
+    // The index is rebuilt after renaming and deletion
+    g_assemblyGraph->changeNodeName("6", "12345");
+    QCOMPARE(g_assemblyGraph->getNodesFromStringList("2345", false, nullptr), partialNodeNameScan("2345"));
+    QCOMPARE(g_assemblyGraph->getNodesFromStringList("2345", false, nullptr).size(), 2);
+
+    g_assemblyGraph->deleteNodes({ g_assemblyGraph->m_deBruijnGraphNodes["12345+"] });
+    QVERIFY(g_assemblyGraph->getNodesFromStringList("2345", false, nullptr).empty());
+    QCOMPARE(g_assemblyGraph->getNodesFromStringList("1", false, nullptr), partialNodeNameScan("1"));
+}
+
+void BandageTests::gfaWriterParallel()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    DeBruijnNode *node5Plus = g_assemblyGraph->m_deBruijnGraphNodes["5+"];
+    g_assemblyGraph->setCustomLabel(node5Plus, "label");
+    g_assemblyGraph->setCustomColour(node5Plus->getReverseComplement(), QColor(255, 0, 0));
+
+    auto readFile = [](const QString &fileName) {
+        QFile file(fileName);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+
+    QString sequentialFileName = tempFile("test_sequential.gfa"), parallelFileName = tempFile("test_parallel.gfa");
+    QVERIFY(gfa::saveEntireGraph(sequentialFileName, *g_assemblyGraph));
+    QVERIFY(gfa::saveEntireGraph(parallelFileName, *g_assemblyGraph, true));
+    QByteArray sequential = readFile(sequentialFileName);
+    QCOMPARE(readFile(parallelFileName), sequential);
+
+    QList<QByteArray> lines = sequential.split('\n');
+    QCOMPARE(lines.count(), g_assemblyGraph->m_nodeCount + g_assemblyGraph->m_edgeCount + 1);
+    QByteArray node5Line;
+    for (const auto &line : lines) {
+        if (line.startsWith("S\t5\t"))
+            node5Line = line;
+    }
+    QByteArray sequence = utils::sequenceToQByteArray(node5Plus->getSequence());
+    QVERIFY(node5Line.startsWith("S\t5\t" + sequence + "\tLN:i:" + QByteArray::number(sequence.length()) + "\t"));
+    QVERIFY(node5Line.endsWith("\tLB:Z:label\tC2:Z:red"));
+
+    QVERIFY(gfa::saveVisibleGraph(sequentialFileName, *g_assemblyGraph));
+    QVERIFY(gfa::saveVisibleGraph(parallelFileName, *g_assemblyGraph, true));
+    QCOMPARE(readFile(parallelFileName), readFile(sequentialFileName));
+}
+
+void BandageTests::fastaExport()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    QByteArray expected;
+    for (const auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        expected += ">NODE_" + node->getName().toLatin1() + "_length_" + QByteArray::number(node->getLength()) +
+                    "_cov_" + QByteArray::number(node->getDepth()) + "\n";
+        expected += utils::addNewlinesToSequence(utils::sequenceToQByteArray(node->getSequence()));
+    }
+
+    QString fileName = tempFile("all_nodes.fasta"), compressedFileName = tempFile("all_nodes.fasta.gz");
+    QVERIFY(utils::saveEntireGraphToFasta(fileName, *g_assemblyGraph));
+    QVERIFY(utils::saveEntireGraphToFasta(compressedFileName, *g_assemblyGraph, true));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), expected);
+
+    // BGZF output is a series of gzip members carrying the 'BC' extra field,
+    // terminated by an empty block
+    QFile compressedFile(compressedFileName);
+    QVERIFY(compressedFile.open(QIODevice::ReadOnly));
+    QByteArray compressed = compressedFile.readAll();
+    QVERIFY(compressed.startsWith(QByteArray::fromHex("1f8b08040000000000ff06004243")));
+    QVERIFY(compressed.endsWith(QByteArray::fromHex("1f8b08040000000000ff0600424302001b0003000000000000000000")));
+
+    gzFile gz = gzopen(qPrintable(compressedFileName), "rb");
+    QVERIFY(gz != nullptr);
+    QByteArray decompressed;
+    char buf[16384];
+    int read;
+    while ((read = gzread(gz, buf, sizeof(buf))) > 0)
+        decompressed.append(buf, read);
+    gzclose(gz);
+    QCOMPARE(decompressed, expected);
+}
+
+void BandageTests::pathFastaExport()
+{
+    auto readFile = [](const QString &fileName) {
+        QFile file(fileName);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+    QVERIFY(io::loadSPAdesPaths(*g_assemblyGraph, testFile("test.paths")));
+
+    QByteArray expectedPaths;
+    for (auto it = g_assemblyGraph->m_deBruijnGraphPaths.begin(); it != g_assemblyGraph->m_deBruijnGraphPaths.end(); ++it)
+        expectedPaths += it.value().getFasta(QString::fromStdString(it.key()));
+
+    QString pathsFileName = tempFile("all_paths.fasta");
+    QVERIFY(utils::saveAllPathsToFasta(pathsFileName, *g_assemblyGraph));
+    QCOMPARE(readFile(pathsFileName), expectedPaths);
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_rgfa.gfa")));
+    QCOMPARE(g_assemblyGraph->walkCount(), 2u);
+
+    QByteArray expectedWalks;
+    for (auto it = g_assemblyGraph->m_deBruijnGraphWalks.begin(); it != g_assemblyGraph->m_deBruijnGraphWalks.end(); ++it) {
+        const Walk &walk = it.value();
+        expectedWalks += walk.walk.getFasta(QString("%1#%2#%3:%4-%5")
+                                            .arg(QString::fromStdString(walk.sampleId)).arg(walk.hapIndex)
+                                            .arg(QString::fromStdString(it.key())).arg(walk.seqStart).arg(walk.seqEnd));
+    }
+
+    QString walksFileName = tempFile("all_walks.fasta");
+    QVERIFY(utils::saveAllWalksToFasta(walksFileName, *g_assemblyGraph));
+    QCOMPARE(readFile(walksFileName), expectedWalks);
+}
+
+void BandageTests::fastxReader()
+{
+    auto writeFile = [](const QString &fileName, const QByteArray &contents, bool compress) {
+        if (compress) {
+            gzFile gz = gzopen(qPrintable(fileName), "wb");
+            gzwrite(gz, contents.constData(), unsigned(contents.size()));
+            gzclose(gz);
+        } else {
+            QFile file(fileName);
+            if (file.open(QIODevice::WriteOnly))
+                file.write(contents);
+        }
+    };
+
+    const QByteArray fasta = ">seq1 some description\r\nACGT\r\nAC GT\n\n>seq2\nTTTT\n>\nGG\n>seq3";
+    const QByteArray fastq = "@read1\nACGT\n+\n@@@@\n@read2 x\nAC\nGT\n+read2\n@@\n@@\n@read3\n\n+\n\n";
+    const std::vector<QString> fastaNames{ "seq1 some description", "seq2", "seq3" };
+    const std::vector<QByteArray> fastaSequences{ "ACGTACGT", "TTTT", "" };
+    const std::vector<QString> fastqNames{ "read1", "read2 x" };
+    const std::vector<QByteArray> fastqSequences{ "ACGT", "ACGT" };
+
+    for (bool compress : { false, true }) {
+        QString fastaFileName = tempFile(compress ? "reads.fasta.gz" : "reads.fasta");
+        QString fastqFileName = tempFile(compress ? "reads.fastq.gz" : "reads.fastq");
+        writeFile(fastaFileName, fasta, compress);
+        writeFile(fastqFileName, fastq, compress);
+
+        std::vector<QString> names;
+        std::vector<QByteArray> sequences;
+        size_t lastProcessed = 0;
+        QVERIFY(utils::readFastxFile(fastaFileName, names, sequences,
+                                     [&](size_t processed, size_t total) {
+                                         lastProcessed = processed;
+                                         QCOMPARE(total, size_t(QFileInfo(fastaFileName).size()));
+                                     }));
+        QCOMPARE(names, fastaNames);
+        QCOMPARE(sequences, fastaSequences);
+        QCOMPARE(lastProcessed, size_t(QFileInfo(fastaFileName).size()));
+
+        names.clear();
+        sequences.clear();
+        QVERIFY(utils::readFastxFile(fastqFileName, names, sequences));
+        QCOMPARE(names, fastqNames);
+        QCOMPARE(sequences, fastqSequences);
+    }
+
+    // Neither FASTA nor FASTQ
+    QString textFileName = tempFile("not_fasta.txt");
+    writeFile(textFileName, "some text\n", false);
+    std::vector<QString> names;
+    std::vector<QByteArray> sequences;
+    QVERIFY(!utils::readFastxFile(textFileName, names, sequences));
+}
+
+void BandageTests::bulkDeletion()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    auto checkConsistency = [&]() {
+        for (auto *edge : g_assemblyGraph->m_deBruijnGraphEdges) {
+            QVERIFY(g_assemblyGraph->m_deBruijnGraphEdges.contains(edge->getReverseComplement()));
+            for (auto *node : { edge->getStartingNode(), edge->getEndingNode() }) {
+                auto it = g_assemblyGraph->m_deBruijnGraphNodes.find(node->getName().toStdString());
+                QVERIFY(it != g_assemblyGraph->m_deBruijnGraphNodes.end() && *it == node);
+                QVERIFY(std::find(node->edgeBegin(), node->edgeEnd(), edge) != node->edgeEnd());
+            }
+        }
+        for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+            for (auto *edge : node->edges())
+                QVERIFY(g_assemblyGraph->m_deBruijnGraphEdges.contains(edge));
+        }
+    };
+
+    // Delete every other positive node, this goes through the sweep over the
+    // node map
+    std::vector<DeBruijnNode *> nodesToDelete;
+    QSet<QString> deletedNames;
+    bool doDelete = false;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        if (!node->isPositiveNode())
+            continue;
+        if ((doDelete = !doDelete)) {
+            nodesToDelete.push_back(node);
+            deletedNames.insert(node->getName());
+            deletedNames.insert(node->getReverseComplement()->getName());
+        }
+    }
+
+    size_t expectedNodes = g_assemblyGraph->m_deBruijnGraphNodes.size() - 2 * nodesToDelete.size();
+    size_t expectedEdges = 0;
+    for (auto *edge : g_assemblyGraph->m_deBruijnGraphEdges) {
+        expectedEdges += !deletedNames.contains(edge->getStartingNode()->getName()) &&
+                         !deletedNames.contains(edge->getEndingNode()->getName());
+    }
+
+    g_assemblyGraph->deleteNodes(nodesToDelete);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), expectedNodes);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), expectedEdges);
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+        QVERIFY(!deletedNames.contains(node->getName()));
+    checkConsistency();
+
+    // A single node goes through the key lookups
+    DeBruijnNode *node = *g_assemblyGraph->m_deBruijnGraphNodes.begin();
+    g_assemblyGraph->deleteNodes({ node });
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), expectedNodes - 2);
+    checkConsistency();
+
+    // Deleting edges also removes their reverse complements
+    std::vector<DeBruijnEdge *> edgesToDelete;
+    for (auto *edge : g_assemblyGraph->m_deBruijnGraphEdges) {
+        if (edge->isPositiveEdge() && edgesToDelete.size() < 3)
+            edgesToDelete.push_back(edge);
+    }
+    size_t edgesBefore = g_assemblyGraph->m_deBruijnGraphEdges.size();
+    size_t expectedDeleted = 0;
+    for (auto *edge : edgesToDelete)
+        expectedDeleted += edge->isOwnReverseComplement() ? 1 : 2;
+    g_assemblyGraph->deleteEdges(edgesToDelete);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), edgesBefore - expectedDeleted);
+    checkConsistency();
+}
+
+void BandageTests::mergeSelectedNodes()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_plasmids.gfa")));
+
+    auto node = [](const char *name) { return g_assemblyGraph->m_deBruijnGraphNodes[name]; };
+    g_assemblyGraph->deleteNodes({ node("277+"), node("297+"), node("282+") });
+
+    QString pathStringFailure;
+    Path path = Path::makeFromString("6+, 280+, 232-, 333+, 289+, 283+", *g_assemblyGraph, true, &pathStringFailure);
+    QVERIFY2(pathStringFailure.isEmpty(), qPrintable(pathStringFailure));
+    QByteArray pathSequence = path.getPathSequence();
+
+    // Nodes that do not form a simple path cannot be merged
+    QVERIFY(!g_assemblyGraph->mergeNodes({ node("6+"), node("232+"), node("289+") }, nullptr));
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 12);
+
+    // The order and the orientation of the nodes given does not matter
+    QVERIFY(g_assemblyGraph->mergeNodes({ node("333+"), node("283-"), node("6+"), node("289-"), node("232+"), node("280+") },
+                                        nullptr));
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 2);
+
+    DeBruijnNode *mergedNode = *g_assemblyGraph->m_deBruijnGraphNodes.begin();
+    Path mergedPath = Path::makeFromString(mergedNode->getName(), *g_assemblyGraph, true, &pathStringFailure);
+    QVERIFY2(pathStringFailure.isEmpty(), qPrintable(pathStringFailure));
+    QCOMPARE(doCircularSequencesMatch(pathSequence, mergedPath.getPathSequence()), true);
+}
+
+void BandageTests::editJournalUndoRedo()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_plasmids.gfa")));
+    g_assemblyGraph->setUndoLimit(10);
+
+    auto node = [](const char *name) { return g_assemblyGraph->m_deBruijnGraphNodes[name]; };
+    // Node names with their edges, so undo has to restore the edge lists of
+    // the surviving nodes as well
+    auto snapshot = []() {
+        std::vector<std::string> nodes;
+        for (const auto *graphNode : g_assemblyGraph->m_deBruijnGraphNodes) {
+            std::vector<std::string> edges;
+            for (const auto *edge : graphNode->edges())
+                edges.push_back((edge->getStartingNode()->getName() + ">" + edge->getEndingNode()->getName()).toStdString());
+            std::sort(edges.begin(), edges.end());
+
+            std::string entry = graphNode->getName().toStdString() + ":";
+            for (const auto &edge : edges)
+                entry += edge + ",";
+            nodes.push_back(entry);
+        }
+        std::sort(nodes.begin(), nodes.end());
+        nodes.push_back(std::to_string(g_assemblyGraph->m_deBruijnGraphEdges.size()));
+        return nodes;
+    };
+
+    auto original = snapshot();
+
+    g_assemblyGraph->beginEdit("Remove selection");
+    g_assemblyGraph->deleteNodes({ node("277+"), node("297+"), node("282+") });
+    g_assemblyGraph->endEdit();
+    auto afterDeletion = snapshot();
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 12);
+
+    g_assemblyGraph->beginEdit("Merge nodes");
+    QVERIFY(g_assemblyGraph->mergeNodes({ node("6+"), node("280+"), node("232-"), node("333+"), node("289+"), node("283+") },
+                                        nullptr));
+    g_assemblyGraph->endEdit();
+    auto afterMerge = snapshot();
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 2);
+
+    DeBruijnNode *mergedNode = *g_assemblyGraph->m_deBruijnGraphNodes.begin();
+    g_assemblyGraph->beginEdit("Change node name");
+    g_assemblyGraph->changeNodeName(mergedNode->getNameWithoutSign(), "merged");
+    g_assemblyGraph->endEdit();
+    auto afterRename = snapshot();
+    QCOMPARE(mergedNode->getNameWithoutSign(), QString("merged"));
+
+    g_assemblyGraph->beginEdit("Set custom colour");
+    g_assemblyGraph->setCustomColour(mergedNode, Qt::red);
+    g_assemblyGraph->endEdit();
+    QCOMPARE(g_assemblyGraph->editJournal().undoDescription(), QString("Set custom colour"));
+
+    QVERIFY(g_assemblyGraph->undo());
+    QVERIFY(!g_assemblyGraph->hasCustomColour(mergedNode));
+    QVERIFY(g_assemblyGraph->undo());
+    QVERIFY(snapshot() == afterMerge);
+    QVERIFY(g_assemblyGraph->undo());
+    QVERIFY(snapshot() == afterDeletion);
+    QVERIFY(g_assemblyGraph->undo());
+    QVERIFY(snapshot() == original);
+    QVERIFY(!g_assemblyGraph->editJournal().canUndo());
+    QVERIFY(!g_assemblyGraph->undo());
+
+    QVERIFY(g_assemblyGraph->redo());
+    QVERIFY(snapshot() == afterDeletion);
+    QVERIFY(g_assemblyGraph->redo());
+    QVERIFY(g_assemblyGraph->redo());
+    QVERIFY(snapshot() == afterRename);
+    QVERIFY(g_assemblyGraph->redo());
+    QCOMPARE(g_assemblyGraph->getCustomColour(mergedNode), QColor(Qt::red));
+    QVERIFY(!g_assemblyGraph->editJournal().canRedo());
+
+    // A new edit drops everything that could be redone
+    QVERIFY(g_assemblyGraph->undo());
+    double depth = mergedNode->getDepth();
+    g_assemblyGraph->beginEdit("Change node depth");
+    g_assemblyGraph->changeNodeDepth({ mergedNode }, depth + 1.0);
+    g_assemblyGraph->endEdit();
+    QVERIFY(!g_assemblyGraph->editJournal().canRedo());
+    QVERIFY(g_assemblyGraph->undo());
+    QCOMPARE(mergedNode->getDepth(), depth);
+    QCOMPARE(mergedNode->getReverseComplement()->getDepth(), depth);
+}
+
+void BandageTests::editJournalSceneUndo()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_assemblyGraph->setUndoLimit(10);
+    g_assemblyGraph->markNodesToDraw(graph::Scope::wholeGraph());
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+    BandageGraphicsScene scene;
+    scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
+
+    // Drawn node and edge names
+    auto drawn = []() {
+        std::vector<QString> items;
+        for (const auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+            if (node->hasGraphicsItem())
+                items.push_back(node->getName());
+        }
+        for (const auto *edge : g_assemblyGraph->m_deBruijnGraphEdges) {
+            if (edge->getGraphicsItemEdge())
+                items.push_back(edge->getStartingNode()->getName() + ">" + edge->getEndingNode()->getName());
+        }
+        std::sort(items.begin(), items.end());
+        return items;
+    };
+    auto original = drawn();
+    qsizetype sceneItems = scene.items().size();
+
+    DeBruijnNode *node = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    if (!node->hasGraphicsItem())
+        node = node->getReverseComplement();
+    QVERIFY(node->hasGraphicsItem());
+
+    g_assemblyGraph->beginEdit("Remove selection");
+    g_assemblyGraph->deleteNodes({ node });
+    g_assemblyGraph->endEdit();
+    QVERIFY(scene.items().size() < sceneItems);
+
+    QVERIFY(g_assemblyGraph->undo(&scene));
+    QVERIFY(drawn() == original);
+    QCOMPARE(scene.items().size(), sceneItems);
+    QCOMPARE(node->getGraphicsItemNode()->m_colour,
+             g_settings->nodeColorer->get(node->getGraphicsItemNode()));
+
+    // Edges are drawn again even if none of their nodes left the scene
+    DeBruijnEdge *edge = nullptr;
+    for (auto *graphEdge : g_assemblyGraph->m_deBruijnGraphEdges) {
+        if (graphEdge->getGraphicsItemEdge() && graphEdge->getStartingNode() != graphEdge->getEndingNode()) {
+            edge = graphEdge;
+            break;
+        }
+    }
+    QVERIFY(edge != nullptr);
+
+    g_assemblyGraph->beginEdit("Remove selection");
+    g_assemblyGraph->deleteEdges({ edge });
+    g_assemblyGraph->endEdit();
+    QVERIFY(scene.items().size() < sceneItems);
+
+    QVERIFY(g_assemblyGraph->undo(&scene));
+    QVERIFY(drawn() == original);
+    QCOMPARE(scene.items().size(), sceneItems);
+    QVERIFY(edge->getGraphicsItemEdge() != nullptr);
+
+    QVERIFY(g_assemblyGraph->redo(&scene));
+    QVERIFY(edge->getGraphicsItemEdge() == nullptr);
+    QVERIFY(g_assemblyGraph->undo(&scene));
+    QVERIFY(drawn() == original);
+}
+
 void BandageTests::changeNodeDepths()
 {
     QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
@@ -1772,6 +2955,30 @@ void BandageTests::sequenceDoubleReverseComplement() {
     QCOMPARE(sequence, sequence.GetReverseComplement().GetReverseComplement());
 }
 
+void BandageTests::sequenceBuilder() {
+    // Long enough for the ranges to cross word boundaries of the packed buffer
+    std::string forward;
+    for (int i = 0; i < 150; ++i)
+        forward += i % 17 == 5 ? 'N' : "ACGTTGCA"[i % 8];
+    Sequence sequence{forward};
+    Sequence revComp = sequence.GetReverseComplement();
+    std::string revCompString = revComp.str();
+
+    Sequence built = SequenceBuilder(3 + 100 + 4 + 120 + 130 + 20)
+            .append(sequence, 3, 6)
+            .append(sequence, 37, 137)
+            .appendNs(4)
+            .append(revComp, 29, 149)
+            .append(revComp.Subseq(10, 140).GetReverseComplement(), 0, 130)
+            .appendNs(20)
+            .build();
+
+    std::string expected = forward.substr(3, 3) + forward.substr(37, 100) + "NNNN" +
+                           revCompString.substr(29, 120) + forward.substr(10, 130) + std::string(20, 'N');
+    QCOMPARE(built.str(), expected);
+    QCOMPARE((sequence + revComp).str(), forward + revCompString);
+}
+
 
 
 
@@ -111,7 +111,9 @@ bool prefixIgnoreCase(const string& prefix, const string& str) {
 			&& std::equal(prefix.begin(), prefix.end(), str.begin(), charCompareIgnoreCase);
 }
 
-static std::mt19937 s_random;
+// Bandage: the generator is per-thread, so that layouts of different graph
+// components running concurrently are reproducible for a given seed
+static thread_local std::mt19937 s_random;
 
 #ifndef OGDF_MEMORY_POOL_NTS
 static std::mutex s_randomMutex;
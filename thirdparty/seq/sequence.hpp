@@ -12,6 +12,7 @@
 #include "utils/sfinae_checks.hpp"
 
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/bit.h>
 #include <llvm/ADT/SparseBitVector.h>
 #include <llvm/Support/TrailingObjects.h>
 
@@ -27,7 +28,11 @@
 #pragma GCC diagnostic ignored "-Wconversion"
 #endif
 
+class SequenceBuilder;
+
 class Sequence {
+    friend class SequenceBuilder;
+
     // Type to store Seq in Sequences
     typedef uint64_t ST;
     // Number of bits in ST
@@ -394,23 +399,6 @@ size_t Sequence::find(const Sequence &t, size_t from) const {
     return -1ULL;
 }
 
-/**
- * @todo optimize
- */
-Sequence Sequence::operator+(const Sequence &s) const {
-    return Sequence(str() + s.str());
-    // TODO might be opposite to correct
-    //    int total = size_ + s.size_;
-    //    std::vector<Seq<4> > bytes((total + 3) >> 2);
-    //    for (size_t i = 0; i < size_; ++i) {
-    //        bytes[i / 4] = (bytes[i / 4] << operator [](i)); // TODO :-) use <<=
-    //    }
-    //    for (size_t i = 0, j = size_; i < s.size_; ++i, ++j) {
-    //        bytes[j / 4] = (bytes[j / 4]) << s[i];
-    //    }
-    //    return Sequence(new Data(bytes), 0, total, false);
-}
-
 std::string Sequence::str() const {
     std::string res(size_, '-');
     for (size_t i = 0; i < size_; ++i) {
@@ -434,6 +422,123 @@ std::ostream &operator<<(std::ostream &os, const Sequence &s) {
     return os;
 }
 
+/**
+ * Concatenates sub-ranges of sequences (and runs of Ns) without going through
+ * the nucleotide string representation: packed words are shifted into place
+ * (and reverse complemented if necessary), only Ns are handled one by one.
+ * The total length has to be known in advance, so the result is allocated once.
+ */
+class SequenceBuilder {
+    typedef Sequence::ST ST;
+    constexpr static size_t STBits = Sequence::STBits;
+    constexpr static size_t STN = Sequence::STN;
+    constexpr static size_t STNBits = Sequence::STNBits;
+
+    Sequence result_;
+    size_t pos_ = 0;
+
+    // count nucleotides starting at buffer position idx, count <= STN
+    static ST loadWord(const Sequence &s, size_t idx, size_t count) {
+        const ST *bytes = s.data_->data();
+        size_t word = idx >> STNBits, shift = (idx & (STN - 1)) << 1;
+        ST res = bytes[word] >> shift;
+        if (shift && shift + (count << 1) > STBits)
+            res |= bytes[word + 1] << (STBits - shift);
+        return count == STN ? res : res & ((ST(1) << (count << 1)) - 1);
+    }
+
+    // Reverses the order of the nucleotides of the word and complements them
+    static ST reverseComplementWord(ST word, size_t count) {
+        word = ((word >> 2) & 0x3333333333333333ULL) | ((word & 0x3333333333333333ULL) << 2);
+        word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        word = llvm::byteswap<ST>(~word);
+        return word >> ((STN - count) << 1);
+    }
+
+    void storeWord(ST word, size_t count) {
+        ST *bytes = result_.data_->data();
+        size_t idx = pos_, w = idx >> STNBits, shift = (idx & (STN - 1)) << 1;
+        bytes[w] |= word << shift;
+        if (shift && shift + (count << 1) > STBits)
+            bytes[w + 1] |= word >> (STBits - shift);
+        pos_ += count;
+    }
+
+    void setEmpty(size_t idx) {
+        auto &empty = result_.data_->empty_nucls_;
+        if (LLVM_UNLIKELY(empty == nullptr))
+            empty = std::make_unique<llvm::SparseBitVector<>>();
+        empty->set(idx);
+    }
+
+  public:
+    explicit SequenceBuilder(size_t size)
+            : result_(size) {
+        memset(result_.data_->data(), 0, Sequence::DataSize(size) * sizeof(ST));
+    }
+
+    size_t size() const { return pos_; }
+
+    /**
+     * Appends s[from, to)
+     */
+    SequenceBuilder &append(const Sequence &s, size_t from, size_t to) {
+        VERIFY(from <= to && to <= s.size());
+        VERIFY(pos_ + (to - from) <= result_.size());
+        size_t start = pos_, length = to - from;
+
+        if (!s.rtl_) {
+            size_t idx = s.from_ + from;
+            for (size_t i = 0; i < length; i += STN) {
+                size_t count = std::min(STN, length - i);
+                storeWord(loadWord(s, idx + i, count), count);
+            }
+        } else {
+            // s[i] is the complement of buffer position s.from_ + s.size_ - 1 - i
+            size_t last = s.from_ + s.size_ - 1 - from;
+            for (size_t i = 0; i < length; i += STN) {
+                size_t count = std::min(STN, length - i);
+                storeWord(reverseComplementWord(loadWord(s, last - i - count + 1, count), count), count);
+            }
+        }
+
+        if (LLVM_UNLIKELY(s.data_->empty_nucls_ != nullptr)) {
+            size_t lo = s.rtl_ ? s.from_ + s.size_ - to : s.from_ + from;
+            size_t hi = lo + length;
+            for (unsigned idx : *s.data_->empty_nucls_) {
+                if (idx < lo)
+                    continue;
+                if (idx >= hi)
+                    break;
+                setEmpty(start + (s.rtl_ ? hi - 1 - idx : idx - lo));
+            }
+        }
+
+        return *this;
+    }
+
+    SequenceBuilder &append(const Sequence &s) {
+        return append(s, 0, s.size());
+    }
+
+    SequenceBuilder &appendNs(size_t count) {
+        VERIFY(pos_ + count <= result_.size());
+        for (size_t i = 0; i < count; ++i)
+            setEmpty(pos_ + i);
+        pos_ += count;
+        return *this;
+    }
+
+    Sequence build() {
+        VERIFY(pos_ == result_.size());
+        return std::move(result_);
+    }
+};
+
+Sequence Sequence::operator+(const Sequence &s) const {
+    return SequenceBuilder(size_ + s.size_).append(*this).append(s).build();
+}
+
 #if defined(__GCC__)
 #pragma GCC diagnostic pop
 #endif
@@ -24,8 +24,11 @@
 #include "graph/graphicsitemedge.h"
 #include "graph/graphicsitemlink.h"
 #include "layout/graphlayout.h"
+#include "program/globals.h"
 #include "program/settings.h"
 
+#include <QtConcurrent>
+
 #include <unordered_set>
 
 BandageGraphicsScene::BandageGraphicsScene(QObject *parent) :
@@ -53,17 +56,79 @@ static bool compareNodePointers(const DeBruijnNode * a, const DeBruijnNode * b)
     return aName < bName;
 }
 
-// This function returns all of the selected nodes, sorted by their node number.
-std::vector<DeBruijnNode *> BandageGraphicsScene::getSelectedNodes() {
-    std::vector<DeBruijnNode *> returnVector;
+void BandageGraphicsScene::trackItemChange(QGraphicsItem *item, QGraphicsItem::GraphicsItemChange change) {
+    bool selected;
+    switch (change) {
+        case QGraphicsItem::ItemSelectedHasChanged:
+            selected = item->isSelected();
+            break;
+        // Selected items leaving the scene stay selected, but are no longer
+        // reported by the scene
+        case QGraphicsItem::ItemSceneChange:
+            if (!item->isSelected())
+                return;
+            selected = false;
+            break;
+        case QGraphicsItem::ItemSceneHasChanged:
+            if (!item->isSelected())
+                return;
+            selected = true;
+            break;
+        default:
+            return;
+    }
 
-    for (auto *selectedItem : selectedItems())
-        if (auto *selectedNodeItem = dynamic_cast<GraphicsItemNode *>(selectedItem))
-            returnVector.push_back(selectedNodeItem->m_deBruijnNode);
+    // Note that this is also called during QGraphicsScene destruction, there
+    // is nothing to track then
+    auto *graphicsScene = dynamic_cast<BandageGraphicsScene *>(item->scene());
+    if (!graphicsScene)
+        return;
 
-    std::sort(returnVector.begin(), returnVector.end(), compareNodePointers);
+    if (auto *graphicsItemNode = dynamic_cast<GraphicsItemNode *>(item)) {
+        if (selected)
+            graphicsScene->m_selectedNodes.insert(graphicsItemNode);
+        else
+            graphicsScene->m_selectedNodes.erase(graphicsItemNode);
+        graphicsScene->m_selectionCacheValid = false;
+    } else if (auto *graphicsItemEdge = dynamic_cast<GraphicsItemEdge *>(item)) {
+        if (selected)
+            graphicsScene->m_selectedEdges.insert(graphicsItemEdge);
+        else
+            graphicsScene->m_selectedEdges.erase(graphicsItemEdge);
+    }
+}
 
-    return returnVector;
+void BandageGraphicsScene::updateSelectionCache() {
+    if (m_selectionCacheValid)
+        return;
+
+    m_sortedSelectedNodes.clear();
+    m_sortedSelectedNodes.reserve(m_selectedNodes.size());
+    m_selectedNodesTotalLength = 0;
+    for (auto *selectedNodeItem : m_selectedNodes) {
+        m_sortedSelectedNodes.push_back(selectedNodeItem->m_deBruijnNode);
+        m_selectedNodesTotalLength += selectedNodeItem->m_deBruijnNode->getLength();
+    }
+
+    std::sort(m_sortedSelectedNodes.begin(), m_sortedSelectedNodes.end(), compareNodePointers);
+    m_selectedNodesMeanDepth = AssemblyGraph::getMeanDepth(m_sortedSelectedNodes);
+    m_selectionCacheValid = true;
+}
+
+long long BandageGraphicsScene::getSelectedNodesTotalLength() {
+    updateSelectionCache();
+    return m_selectedNodesTotalLength;
+}
+
+double BandageGraphicsScene::getSelectedNodesMeanDepth() {
+    updateSelectionCache();
+    return m_selectedNodesMeanDepth;
+}
+
+// This function returns all of the selected nodes, sorted by their node number.
+std::vector<DeBruijnNode *> BandageGraphicsScene::getSelectedNodes() {
+    updateSelectionCache();
+    return m_sortedSelectedNodes;
 }
 
 // This function works like getSelectedNodes, but only positive nodes are
@@ -71,44 +136,38 @@ std::vector<DeBruijnNode *> BandageGraphicsScene::getSelectedNodes() {
 // results.  If both nodes in a pair are selected, then only the positive node
 // of the pair is in the results.
 std::vector<DeBruijnNode *> BandageGraphicsScene::getSelectedPositiveNodes() {
-    std::vector<DeBruijnNode *> selectedNodes = getSelectedNodes();
-
     //First turn all of the nodes to positive nodes.
     std::unordered_set<DeBruijnNode *> allPositive;
-    for (auto *node : selectedNodes)
+    for (auto *selectedNodeItem : m_selectedNodes) {
+        DeBruijnNode *node = selectedNodeItem->m_deBruijnNode;
         allPositive.insert(node->isNegativeNode() ? node->getReverseComplement() : node);
+    }
 
     return { allPositive.begin(), allPositive.end() };
 }
 
 //This function returns all of the selected graphics item nodes, unsorted.
 std::vector<GraphicsItemNode *> BandageGraphicsScene::getSelectedGraphicsItemNodes() {
-    std::vector<GraphicsItemNode *> returnVector;
-
-    for (auto *selectedItem : selectedItems())
-        if (auto * selectedNodeItem = dynamic_cast<GraphicsItemNode *>(selectedItem))
-            returnVector.push_back(selectedNodeItem);
-
-    return returnVector;
+    return { m_selectedNodes.begin(), m_selectedNodes.end() };
 }
 
 
 std::vector<DeBruijnEdge *> BandageGraphicsScene::getSelectedEdges() {
     std::vector<DeBruijnEdge *> returnVector;
+    returnVector.reserve(m_selectedEdges.size());
 
-    for (auto *selectedItem : selectedItems())
-        if (auto * selectedEdgeItem = dynamic_cast<GraphicsItemEdge *>(selectedItem))
-            returnVector.push_back(selectedEdgeItem->edge());
+    for (auto *selectedEdgeItem : m_selectedEdges)
+        returnVector.push_back(selectedEdgeItem->edge());
 
     return returnVector;
 }
 
 DeBruijnNode * BandageGraphicsScene::getOneSelectedNode() {
-    std::vector<DeBruijnNode *> selectedNodes = getSelectedNodes();
-    if (selectedNodes.empty())
+    if (m_selectedNodes.empty())
         return nullptr;
 
-    return selectedNodes.front();
+    updateSelectionCache();
+    return m_sortedSelectedNodes.front();
 }
 
 DeBruijnEdge * BandageGraphicsScene::getOneSelectedEdge()
@@ -172,18 +231,21 @@ double BandageGraphicsScene::getTopZValue()
 //Expands the scene rectangle a bit beyond the items, so they aren't drawn right to the edge.
 void BandageGraphicsScene::setSceneRectangle()
 {
-    QRectF boundingRect = itemsBoundingRect();
+    setSceneRect(addMargin(itemsBoundingRect()));
+}
+
+QRectF BandageGraphicsScene::addMargin(const QRectF &boundingRect)
+{
     double width = boundingRect.width();
     double height = boundingRect.height();
     double margin = std::max(width, height);
     margin *= 0.05; //5% margin
 
-    setSceneRect(boundingRect.left() - margin, boundingRect.top() - margin,
-                 width + 2 * margin, height + 2 * margin);
+    return { boundingRect.left() - margin, boundingRect.top() - margin,
+             width + 2 * margin, height + 2 * margin };
 }
 
 
-
 //After the user drags nodes, it may be necessary to expand the scene rectangle
 //if the nodes were moved out of the existing rectangle.
 void BandageGraphicsScene::possiblyExpandSceneRectangle(std::vector<GraphicsItemNode *> * movedNodes)
@@ -207,54 +269,63 @@ void BandageGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
 
     double meanDrawnDepth = graph.getMeanDepth(true);
 
-    // First make the GraphicsItemNode objects
+    // First make the GraphicsItemNode objects. Items are not in any scene yet
+    // and each task only touches its own node, so paths, widths and outlines
+    // are built concurrently.
+    struct NodeTask {
+        DeBruijnNode *node;
+        const adt::SmallPODVector<QPointF> *points;
+        GraphicsItemNode *item;
+    };
+    std::vector<NodeTask> nodeTasks;
     for (auto &entry : layout) {
-        DeBruijnNode *node = entry.first;
-        if (!node->isDrawn())
-            continue;
-
-        auto *graphicsItemNode =
-                new GraphicsItemNode(node,
-                                     meanDrawnDepth == 0 ? 1.0 : node->getDepth() / meanDrawnDepth,
-                                     entry.second);
-        // If we are in double mode and this node's complement is also drawn,
-        // then we should shift the points so the two nodes are not drawn directly
-        // on top of each other.
-        if (g_settings->doubleMode && node->getReverseComplement()->isDrawn())
-            graphicsItemNode->shiftPointsLeft();
-
-        node->setGraphicsItemNode(graphicsItemNode);
-        graphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
-        graphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
-
-        bool colSet = false;
-        if (auto *rcNode = node->getReverseComplement()) {
-            if (auto *revCompGraphNode = rcNode->getGraphicsItemNode()) {
-                auto colPair = g_settings->nodeColorer->get(graphicsItemNode, revCompGraphNode);
-                graphicsItemNode->setNodeColour(colPair.first);
-                revCompGraphNode->setNodeColour(colPair.second);
-                colSet = true;
-            }
-        }
-        if (!colSet)
-            graphicsItemNode->setNodeColour(g_settings->nodeColorer->get(graphicsItemNode));
+        if (entry.first->isDrawn())
+            nodeTasks.push_back({ entry.first, &entry.second, nullptr });
     }
 
-    // Then make the GraphicsItemEdge objects and add them to the scene first,
-    // so they are drawn underneath
+    QtConcurrent::blockingMap(nodeTasks, [meanDrawnDepth](NodeTask &task) {
+        task.item = new GraphicsItemNode(task.node,
+                                         meanDrawnDepth == 0 ? 1.0 : task.node->getDepth() / meanDrawnDepth,
+                                         *task.points);
+        placeGraphicsItemNode(task.item);
+        task.item->setFlag(QGraphicsItem::ItemIsSelectable);
+        task.item->setFlag(QGraphicsItem::ItemIsMovable);
+        task.item->boundingRect();
+    });
+
+    std::vector<GraphicsItemNode *> items;
+    items.reserve(nodeTasks.size());
+    for (const auto &task : nodeTasks)
+        items.push_back(task.item);
+    colourGraphicsItemNodes(items);
+
+    // Then make the GraphicsItemEdge objects, their paths depend on the node
+    // items only
+    std::vector<std::pair<DeBruijnEdge *, GraphicsItemEdge *>> edgeTasks;
     for (DeBruijnEdge *edge : graph.m_deBruijnGraphEdges) {
-        if (!edge->isDrawn())
-            continue;
-
-        auto *graphicsItemEdge =
-                edge->getOverlapType() == EdgeOverlapType::EXTRA_LINK ?
-                new GraphicsItemLink(edge, graph) :
-                new GraphicsItemEdge(edge, graph);
-        edge->setGraphicsItemEdge(graphicsItemEdge);
-        graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
-        addItem(graphicsItemEdge);
+        if (edge->isDrawn())
+            edgeTasks.emplace_back(edge, nullptr);
     }
 
+    QtConcurrent::blockingMap(edgeTasks, [&graph](std::pair<DeBruijnEdge *, GraphicsItemEdge *> &task) {
+        DeBruijnEdge *edge = task.first;
+        task.second = edge->getOverlapType() == EdgeOverlapType::EXTRA_LINK ?
+                      new GraphicsItemLink(edge, graph) :
+                      new GraphicsItemEdge(edge, graph);
+        edge->setGraphicsItemEdge(task.second);
+        task.second->setFlag(QGraphicsItem::ItemIsSelectable);
+        task.second->boundingRect();
+    });
+
+    // Insert everything with the index disabled and build the index once at
+    // the end, instead of updating the BSP tree item by item
+    ItemIndexMethod indexMethod = itemIndexMethod();
+    setItemIndexMethod(NoIndex);
+
+    // Edges are added to the scene first, so they are drawn underneath
+    for (const auto &task : edgeTasks)
+        addItem(task.second);
+
     // Now add the GraphicsItemNode objects to the scene, so they are drawn
     // on top
     for (auto *node : graph.m_deBruijnGraphNodes) {
@@ -263,6 +334,43 @@ void BandageGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
 
         addItem(node->getGraphicsItemNode());
     }
+
+    setItemIndexMethod(indexMethod);
+}
+
+void BandageGraphicsScene::placeGraphicsItemNode(GraphicsItemNode *graphicsItemNode) {
+    DeBruijnNode *node = graphicsItemNode->m_deBruijnNode;
+
+    // If we are in double mode and this node's complement is also drawn,
+    // then we should shift the points so the two nodes are not drawn directly
+    // on top of each other.
+    if (g_settings->doubleMode && node->getReverseComplement()->isDrawn())
+        graphicsItemNode->shiftPointsLeft();
+
+    node->setGraphicsItemNode(graphicsItemNode);
+}
+
+void BandageGraphicsScene::colourGraphicsItemNode(GraphicsItemNode *graphicsItemNode,
+                                                  bool withReverseComplement) {
+    // If the reverse complement is already drawn, the colorer could
+    // pick colours for both nodes of the pair
+    if (withReverseComplement) {
+        auto *revCompGraphNode = graphicsItemNode->m_deBruijnNode->getReverseComplement()->getGraphicsItemNode();
+        auto colPair = g_settings->nodeColorer->get(graphicsItemNode, revCompGraphNode);
+        graphicsItemNode->setNodeColour(colPair.first);
+        revCompGraphNode->setNodeColour(colPair.second);
+    } else
+        graphicsItemNode->setNodeColour(g_settings->nodeColorer->get(graphicsItemNode));
+}
+
+void BandageGraphicsScene::colourGraphicsItemNodes(const std::vector<GraphicsItemNode *> &graphicsItemNodes) {
+    // Node pairs need no special care here: all colorers give the nodes of a
+    // pair the same colours as they would give each of them separately
+    std::vector<const DrawnNode *> nodes(graphicsItemNodes.begin(), graphicsItemNodes.end());
+    std::vector<QColor> colours(nodes.size());
+    g_settings->nodeColorer->colourAll(nodes, colours);
+    for (size_t i = 0; i < graphicsItemNodes.size(); ++i)
+        graphicsItemNodes[i]->setNodeColour(colours[i]);
 }
 
 void BandageGraphicsScene::removeAllGraphicsEdgesFromNode(DeBruijnNode *node, bool reverseComplement) {
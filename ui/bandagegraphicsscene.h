@@ -19,6 +19,8 @@
 
 #include "layout/graphlayout.h"
 
+#include "parallel_hashmap/phmap.h"
+
 #include <QGraphicsScene>
 #include <vector>
 #include <unordered_set>
@@ -44,10 +46,30 @@ public:
     DeBruijnNode * getOneSelectedNode();
     DeBruijnEdge * getOneSelectedEdge();
     DeBruijnNode * getOnePositiveSelectedNode();
+    size_t getSelectedNodeCount() const { return m_selectedNodes.size(); }
+    size_t getSelectedEdgeCount() const { return m_selectedEdges.size(); }
+    long long getSelectedNodesTotalLength();
+    double getSelectedNodesMeanDepth();
+    // Drops cached data about the selected nodes (e.g. after their depth was changed)
+    void invalidateSelectionCache() { m_selectionCacheValid = false; }
+
+    // Keeps the selected nodes and edges up to date, called by the node and
+    // edge items on selection and scene changes (and on destruction)
+    static void trackItemChange(QGraphicsItem *item, QGraphicsItem::GraphicsItemChange change);
     double getTopZValue();
     void setSceneRectangle();
     void possiblyExpandSceneRectangle(std::vector<GraphicsItemNode *> * movedNodes);
 
+    // Scene rectangle (with margin) around the given items bounding rect
+    static QRectF addMargin(const QRectF &boundingRect);
+    // Shifts the node in double mode and links it to its DeBruijnNode. Only
+    // touches the given node, so could be done concurrently.
+    static void placeGraphicsItemNode(GraphicsItemNode *graphicsItemNode);
+    // Sets the node colour (and the colour of its reverse complement, if drawn)
+    static void colourGraphicsItemNode(GraphicsItemNode *graphicsItemNode, bool withReverseComplement);
+    // Colours many nodes at once with the current colorer, concurrently
+    static void colourGraphicsItemNodes(const std::vector<GraphicsItemNode *> &graphicsItemNodes);
+
     static void removeGraphicsItemEdges(const std::vector<DeBruijnEdge *> &edges,
                                         bool reverseComplement);
     static void removeGraphicsItemNodes(const std::vector<DeBruijnNode *> &nodes,
@@ -61,4 +83,17 @@ public:
 private:
     void removeGraphicsItemNodes(const std::unordered_set<GraphicsItemNode*> &nodes);
     void removeGraphicsItemEdges(const std::unordered_set<GraphicsItemEdge*> &edges);
+    void updateSelectionCache();
+
+    // Maintained incrementally, so queries do not need to go through
+    // selectedItems() and cast every item
+    phmap::flat_hash_set<GraphicsItemNode *> m_selectedNodes;
+    phmap::flat_hash_set<GraphicsItemEdge *> m_selectedEdges;
+
+    // Selected nodes sorted by name together with their total length and mean
+    // depth, computed on demand
+    bool m_selectionCacheValid = false;
+    std::vector<DeBruijnNode *> m_sortedSelectedNodes;
+    long long m_selectedNodesTotalLength = 0;
+    double m_selectedNodesMeanDepth = 0.0;
 };
@@ -18,25 +18,151 @@
 
 #include "bandagegraphicsview.h"
 #include "graph/graphicsitemnode.h"
+#include "graph/graphicsitemedge.h"
 #include "program/globals.h"
 #include "program/settings.h"
 #include "graphicsviewzoom.h"
 #include <QMouseEvent>
 #include <QFont>
 #include <QMessageBox>
+#include <QGraphicsScene>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QPen>
+#include <QStyleOptionGraphicsItem>
 #include <qmath.h>
 #include <cmath>
 
 BandageGraphicsView::BandageGraphicsView(QObject * /*parent*/) :
-    QGraphicsView(), m_rotation(0.0)
+    QGraphicsView(), m_rotation(0.0), m_lastFrameTime(0.0),
+    m_frameTimeTotal(0.0), m_frameCount(0),
+    m_simplifiedLevelOfDetail(0.0), m_simplifiedValid(false)
 {
     setDragMode(QGraphicsView::RubberBandDrag);
     setAntialiasing(g_settings->antialiasing);
     setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
     setBackgroundBrush(QBrush(Qt::white));
+
+    m_frameReportTimer.setSingleShot(true);
+    m_frameReportTimer.setInterval(1000);
+    connect(&m_frameReportTimer, &QTimer::timeout, this, [this]() {
+        if (m_frameCount == 0)
+            return;
+        emit frameTimeMeasured(m_frameTimeTotal / m_frameCount);
+        m_frameTimeTotal = 0.0;
+        m_frameCount = 0;
+    });
+}
+
+
+
+void BandageGraphicsView::paintEvent(QPaintEvent * event)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QGraphicsView::paintEvent(event);
+
+    m_lastFrameTime = timer.nsecsElapsed() / 1000000.0;
+    m_frameTimeTotal += m_lastFrameTime;
+    ++m_frameCount;
+    if (!m_frameReportTimer.isActive())
+        m_frameReportTimer.start();
 }
 
+//Nodes and edges too small to show any detail are not painted by their items.
+//They are all drawn here instead, in a few batched draw calls underneath the
+//other items.
+void BandageGraphicsView::drawBackground(QPainter * painter, const QRectF & rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+
+    if (scene() == nullptr || !isPaintingViewport(painter, viewport()) ||
+        (!g_settings->lodNodeWidth.on && !g_settings->lodEdgeLength.on))
+        return;
 
+    double levelOfDetail = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (!m_simplifiedValid || m_simplifiedScene != scene() ||
+        levelOfDetail != m_simplifiedLevelOfDetail || !m_simplifiedRect.contains(rect))
+        updateSimplifiedItems(rect, levelOfDetail);
+
+    m_simplified.draw(painter);
+}
+
+//Gathers the simplified items of the painted rectangle, padded by its own size
+//on each side so that scrolling reuses them for a while. Any change to the
+//scene makes them stale.
+void BandageGraphicsView::updateSimplifiedItems(const QRectF & rect, double levelOfDetail)
+{
+    if (m_simplifiedScene != scene())
+    {
+        disconnect(m_sceneChangedConnection);
+        m_simplifiedScene = scene();
+        //The scene can report a change after the frame that shows it has been
+        //painted, so the viewport is repainted once the cache is dropped.
+        m_sceneChangedConnection = connect(scene(), &QGraphicsScene::changed, this, [this]() {
+            if (!m_simplifiedValid)
+                return;
+            m_simplifiedValid = false;
+            viewport()->update();
+        });
+    }
+
+    m_simplified = SimplifiedItems();
+    m_simplifiedRect = rect.adjusted(-rect.width(), -rect.height(), rect.width(), rect.height());
+    m_simplifiedLevelOfDetail = levelOfDetail;
+    m_simplifiedValid = true;
+
+    for (auto *item : scene()->items(m_simplifiedRect, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder))
+    {
+        if (!item->isVisible())
+            continue;
+
+        if (auto *node = dynamic_cast<GraphicsItemNode *>(item))
+        {
+            if (node->isSimplified(levelOfDetail))
+                node->addSimplified(m_simplified, levelOfDetail);
+        }
+        else if (auto *edge = dynamic_cast<GraphicsItemEdge *>(item))
+        {
+            if (edge->isSimplified(levelOfDetail))
+                edge->addSimplified(m_simplified, levelOfDetail);
+        }
+    }
+}
+
+bool BandageGraphicsView::isPaintingViewport(const QPainter * painter, const QWidget * widget)
+{
+    return widget != nullptr && painter->device() == widget;
+}
+
+void SimplifiedItems::draw(QPainter * painter) const
+{
+    painter->save();
+    painter->setBrush(Qt::NoBrush);
+
+    for (const auto &[key, lines] : edgeLines)
+    {
+        painter->setPen(QPen(QBrush(QColor::fromRgba(std::get<0>(key))), std::get<1>(key),
+                             std::get<2>(key), Qt::RoundCap));
+        painter->drawLines(lines.data(), int(lines.size()));
+    }
+
+    for (const auto &[key, path] : nodeLines)
+    {
+        painter->setPen(QPen(QBrush(QColor::fromRgba(key.first)), key.second,
+                             Qt::SolidLine, Qt::FlatCap, Qt::RoundJoin));
+        painter->drawPath(path);
+    }
+
+    for (const auto &[colour, points] : nodePoints)
+    {
+        painter->setPen(QPen(QColor::fromRgba(colour), 0.0));
+        painter->drawPoints(points.data(), int(points.size()));
+    }
+
+    painter->restore();
+}
 
 void BandageGraphicsView::mousePressEvent(QMouseEvent * event)
 {
@@ -22,10 +22,31 @@
 #include <QGraphicsView>
 #include <QPoint>
 #include <QLineF>
+#include <QPainterPath>
+#include <QPointer>
+#include <QRectF>
+#include <QRgb>
+#include <QTimer>
+
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 class GraphicsViewZoom;
 class DeBruijnNode;
 
+//Nodes and edges too small to show any detail, grouped by colour and width so
+//each group is drawn with a single call.
+struct SimplifiedItems
+{
+    std::map<std::tuple<QRgb, float, Qt::PenStyle>, std::vector<QLineF>> edgeLines;
+    std::map<std::pair<QRgb, float>, QPainterPath> nodeLines;
+    std::map<QRgb, std::vector<QPointF>> nodePoints;
+
+    void draw(QPainter * painter) const;
+};
+
 class BandageGraphicsView : public QGraphicsView
 {
     Q_OBJECT
@@ -35,6 +56,7 @@ public:
 
     //ACCESSORS
     double getRotation() const {return m_rotation;}
+    double getLastFrameTime() const {return m_lastFrameTime;}
 
     //MODIFERS
     void setRotation(double newRotation);
@@ -50,15 +72,40 @@ public:
     QPointF findIntersectionWithViewportBoundary(QLineF line);
     QLineF findVisiblePartOfLine(QLineF line, bool * success);
 
+    //Level of detail is only used when painting the viewport. Rendering to
+    //anything else (e.g. exporting an image) always draws the graph in full.
+    static bool isPaintingViewport(const QPainter * painter, const QWidget * widget);
+
 protected:
     void mousePressEvent(QMouseEvent * event);
     void mouseReleaseEvent(QMouseEvent * event);
     void mouseMoveEvent(QMouseEvent * event);
     void keyPressEvent(QKeyEvent * event);
     void mouseDoubleClickEvent(QMouseEvent * event);
+    void paintEvent(QPaintEvent * event);
+    void drawBackground(QPainter * painter, const QRectF & rect);
 
 private:
     double m_rotation;
+    double m_lastFrameTime;
+
+    //Frame times are summed until the report timer fires, then their mean is
+    //emitted by frameTimeMeasured.
+    double m_frameTimeTotal;
+    int m_frameCount;
+    QTimer m_frameReportTimer;
+
+    //The simplified items of the area around the last painted rectangle. They
+    //are reused until the level of detail or the scene changes, or the view
+    //moves out of that area.
+    SimplifiedItems m_simplified;
+    QRectF m_simplifiedRect;
+    double m_simplifiedLevelOfDetail;
+    bool m_simplifiedValid;
+    QPointer<QGraphicsScene> m_simplifiedScene;
+    QMetaObject::Connection m_sceneChangedConnection;
+
+    void updateSimplifiedItems(const QRectF & rect, double levelOfDetail);
 
     static double distance(double x1, double y1, double x2, double y2);
     static double angleBetweenTwoLines(QPointF line1Start, QPointF line1End, QPointF line2Start, QPointF line2End);
@@ -71,6 +118,9 @@ signals:
     void doubleClickedNode(DeBruijnNode * node);
     void copySelectedSequencesToClipboard();
     void saveSelectedSequencesToFile();
+    //Emitted at most once a second with the mean time of the frames painted
+    //since the previous report.
+    void frameTimeMeasured(double milliseconds);
 };
 
 #endif // MYGRAPHICSVIEW_H
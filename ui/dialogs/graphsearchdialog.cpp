@@ -280,6 +280,7 @@ void GraphSearchDialog::loadQueriesFromFile(const QString& fullFileName) {
     auto * progress = new MyProgressDialog(this, "Loading queries...", false);
     progress->setWindowModality(Qt::WindowModal);
     progress->show();
+    QApplication::processEvents();
 
     int queriesLoaded = m_graphSearch->loadQueriesFromFile(fullFileName);
     if (queriesLoaded > 0) {
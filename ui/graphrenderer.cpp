@@ -0,0 +1,134 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphrenderer.h"
+#include "bandagegraphicsscene.h"
+
+#include "graph/annotationsmanager.h"
+#include "graph/assemblygraph.h"
+#include "graph/debruijnedge.h"
+#include "graph/debruijnnode.h"
+#include "graph/graphicsitemlink.h"
+#include "graph/nodecolorer.h"
+#include "program/globals.h"
+#include "program/settings.h"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QPainter>
+#include <QPen>
+#include <QtConcurrent>
+
+GraphRenderer::GraphRenderer(AssemblyGraph &graph, const GraphLayout &layout) {
+    double meanDrawnDepth = graph.getMeanDepth(true);
+
+    // Nodes are made in the same way and order as the node items of
+    // BandageGraphicsScene::addGraphicsItemsToScene
+    phmap::flat_hash_map<const DeBruijnNode *, const DrawnNode *> drawnNodes;
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        if (!node->isDrawn() || !layout.contains(node))
+            continue;
+
+        auto &drawnNode =
+                m_drawnNodes.emplace_back(node,
+                                          meanDrawnDepth == 0 ? 1.0 : node->getDepth() / meanDrawnDepth,
+                                          layout.segments(node));
+        if (g_settings->doubleMode && node->getReverseComplement()->isDrawn())
+            drawnNode.shiftPointsLeft();
+        drawnNodes[node] = &drawnNode;
+    }
+
+    std::vector<const DrawnNode *> nodes;
+    nodes.reserve(m_drawnNodes.size());
+    for (const auto &drawnNode : m_drawnNodes)
+        nodes.push_back(&drawnNode);
+    std::vector<QColor> colours(nodes.size());
+    g_settings->nodeColorer->colourAll(nodes, colours);
+
+    // This also builds the lazily computed node geometry, so nothing is
+    // modified during rendering
+    m_nodes.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const DrawnNode *drawnNode = nodes[i];
+        drawnNode->getNodePathLength();
+        drawnNode->m_path.controlPointRect();
+        QPainterPath outline = drawnNode->outline();
+        outline.controlPointRect();
+        m_nodes.push_back({ colours[i], drawnNode->bounds() });
+    }
+
+    for (DeBruijnEdge *edge : graph.m_deBruijnGraphEdges) {
+        if (edge->isDrawn())
+            m_edges.push_back({ edge, {}, {}, {} });
+    }
+
+    auto drawnNode = [&drawnNodes](const DeBruijnNode *node) -> const DrawnNode * {
+        auto it = drawnNodes.find(node);
+        return it == drawnNodes.end() ? nullptr : it->second;
+    };
+    QtConcurrent::blockingMap(m_edges, [&graph, &drawnNode](Edge &edge) {
+        edge.path = edge.edge->getOverlapType() == EdgeOverlapType::EXTRA_LINK ?
+                    GraphicsItemLink::makePath(edge.edge, drawnNode) :
+                    GraphicsItemEdge::makePath(edge.edge, drawnNode);
+        edge.style = GraphicsItemEdge::getStyle(edge.edge, graph);
+        // Same as the bounding rect of the edge item
+        edge.bounds = GraphicsItemEdge::makeShape(edge.path, edge.style.width).controlPointRect();
+        edge.path.controlPointRect();
+    });
+
+    QRectF itemsBoundingRect;
+    for (const auto &edge : m_edges)
+        itemsBoundingRect |= edge.bounds;
+    for (const auto &node : m_nodes)
+        itemsBoundingRect |= node.bounds;
+    m_sceneRect = BandageGraphicsScene::addMargin(itemsBoundingRect);
+
+    // Nodes look annotation settings up via operator[], make sure no insertion
+    // happens during rendering
+    for (const auto &annotationGroup : g_annotationsManager->getGroups())
+        g_settings->annotationsSettings[annotationGroup->id];
+}
+
+void GraphRenderer::render(QPainter &painter, const QRectF &target, const QRectF &source) const {
+    painter.save();
+    painter.setClipRect(target, Qt::IntersectClip);
+    painter.translate(target.topLeft());
+    painter.scale(target.width() / source.width(), target.height() / source.height());
+    painter.translate(-source.topLeft());
+
+    for (const auto &edge : m_edges) {
+        if (!edge.bounds.intersects(source))
+            continue;
+
+        painter.setPen(QPen(QBrush(edge.style.colour), edge.style.width, edge.style.penStyle, Qt::RoundCap));
+        // A copy, as render() could run on several threads
+        painter.drawPath(DrawnNode::copyPath(edge.path));
+    }
+
+    size_t i = 0;
+    for (const auto &drawnNode : m_drawnNodes) {
+        const Node &node = m_nodes[i++];
+        if (!node.bounds.intersects(source))
+            continue;
+
+        painter.save();
+        drawnNode.draw(&painter, node.colour, false, g_settings->positionTextNodeCentre);
+        painter.restore();
+    }
+
+    painter.restore();
+}
@@ -0,0 +1,73 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graph/graphicsitemedge.h"
+#include "graph/graphicsitemnode.h"
+#include "layout/graphlayout.h"
+
+#include <QColor>
+#include <QPainterPath>
+#include <QRectF>
+
+#include <deque>
+#include <vector>
+
+class AssemblyGraph;
+class QPainter;
+
+// Draws the graph directly to a painter, without a QGraphicsScene and without
+// graphics items. The picture is the same as the one rendered from
+// BandageGraphicsScene after addGraphicsItemsToScene(): nodes and edges get
+// the same geometry and colours and are drawn in the same order.
+//
+// Everything drawn is computed up front from the layout and the colorer and
+// kept in the renderer, the graph nodes and edges are not modified. Paint
+// engines cache data in the paths they draw, so render() paints copies of the
+// stored paths. Only the copies are written to, which is what lets render()
+// be called from several threads at once.
+class GraphRenderer {
+public:
+    GraphRenderer(AssemblyGraph &graph, const GraphLayout &layout);
+
+    // Same as the scene rectangle of BandageGraphicsScene::setSceneRectangle()
+    [[nodiscard]] QRectF sceneRect() const { return m_sceneRect; }
+
+    // Renders the source part of the scene into the target rectangle of the
+    // painter, same as QGraphicsScene::render with Qt::IgnoreAspectRatio.
+    void render(QPainter &painter, const QRectF &target, const QRectF &source) const;
+
+private:
+    struct Node {
+        QColor colour;
+        QRectF bounds;
+    };
+
+    struct Edge {
+        DeBruijnEdge *edge;
+        QPainterPath path;
+        GraphicsItemEdge::Style style;
+        QRectF bounds;
+    };
+
+    // Both in the stacking order of the scene: edges first, nodes on top
+    std::vector<Edge> m_edges;
+    std::deque<DrawnNode> m_drawnNodes;
+    std::vector<Node> m_nodes;
+    QRectF m_sceneRect;
+};
@@ -0,0 +1,227 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "imageexport.h"
+
+#include <QFile>
+#include <QImage>
+#include <QPainter>
+#include <QString>
+#include <QtConcurrent>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace image {
+    // For PNG streaming, tiles are stitched into a strip spanning the image
+    // width before being compressed
+    static constexpr int tileWidth = 1024;
+    static constexpr int tileHeight = 256;
+
+    QRectF sourceRect(const QRectF &sceneRect, QSize imageSize, const QRectF &pixelRect) {
+        double scale = std::min(imageSize.width() / sceneRect.width(),
+                                imageSize.height() / sceneRect.height());
+        QPointF offset((imageSize.width() - sceneRect.width() * scale) / 2.0,
+                       (imageSize.height() - sceneRect.height() * scale) / 2.0);
+
+        return { sceneRect.topLeft() + (pixelRect.topLeft() - offset) / scale,
+                 pixelRect.size() / scale };
+    }
+
+    namespace {
+    // Minimal streaming PNG encoder for 8-bit RGB images: rows are deflated
+    // as they come and written out as IDAT chunks.
+    class PngWriter {
+    public:
+        explicit PngWriter(QFile &file)
+                : m_file(file), m_buffer(1 << 16) {}
+
+        ~PngWriter() {
+            if (m_started)
+                deflateEnd(&m_stream);
+        }
+
+        bool begin(QSize size) {
+            static const char signature[] = "\x89PNG\r\n\x1a\n";
+            if (m_file.write(signature, 8) != 8)
+                return false;
+
+            std::array<uint8_t, 13> header{};
+            putUInt32(header.data(), size.width());
+            putUInt32(header.data() + 4, size.height());
+            header[8] = 8; // bit depth
+            header[9] = 2; // colour type: RGB
+            if (!writeChunk("IHDR", header.data(), header.size()))
+                return false;
+
+            m_stream = z_stream{};
+            if (deflateInit(&m_stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+                return false;
+            m_started = true;
+            m_row.resize(1 + 3 * size_t(size.width()));
+            return true;
+        }
+
+        // Row of pixels in QImage::Format_RGB32
+        bool addRow(const QRgb *pixels) {
+            m_row[0] = 0; // filter type: none
+            uint8_t *out = m_row.data() + 1;
+            for (size_t i = 0; i < (m_row.size() - 1) / 3; ++i) {
+                *out++ = qRed(pixels[i]);
+                *out++ = qGreen(pixels[i]);
+                *out++ = qBlue(pixels[i]);
+            }
+
+            return deflateData(m_row.data(), m_row.size(), Z_NO_FLUSH);
+        }
+
+        bool finish() {
+            return deflateData(nullptr, 0, Z_FINISH) &&
+                   writeChunk("IEND", nullptr, 0);
+        }
+
+    private:
+        static void putUInt32(uint8_t *out, uint32_t value) {
+            out[0] = value >> 24;
+            out[1] = value >> 16;
+            out[2] = value >> 8;
+            out[3] = value;
+        }
+
+        bool writeChunk(const char *type, const uint8_t *data, size_t size) {
+            uint8_t header[8];
+            putUInt32(header, uint32_t(size));
+            std::copy(type, type + 4, header + 4);
+
+            uLong crc = crc32(0, header + 4, 4);
+            if (size)
+                crc = crc32(crc, data, uInt(size));
+            uint8_t footer[4];
+            putUInt32(footer, uint32_t(crc));
+
+            return m_file.write(reinterpret_cast<const char *>(header), 8) == 8 &&
+                   (size == 0 || m_file.write(reinterpret_cast<const char *>(data), qint64(size)) == qint64(size)) &&
+                   m_file.write(reinterpret_cast<const char *>(footer), 4) == 4;
+        }
+
+        bool deflateData(const uint8_t *data, size_t size, int flush) {
+            m_stream.next_in = const_cast<uint8_t *>(data);
+            m_stream.avail_in = uInt(size);
+            do {
+                m_stream.next_out = m_buffer.data();
+                m_stream.avail_out = uInt(m_buffer.size());
+                int res = deflate(&m_stream, flush);
+                if (res == Z_STREAM_ERROR)
+                    return false;
+
+                size_t produced = m_buffer.size() - m_stream.avail_out;
+                if (produced && !writeChunk("IDAT", m_buffer.data(), produced))
+                    return false;
+            } while (m_stream.avail_out == 0);
+
+            return true;
+        }
+
+        QFile &m_file;
+        z_stream m_stream{};
+        bool m_started = false;
+        std::vector<uint8_t> m_buffer;
+        std::vector<uint8_t> m_row;
+    };
+    }
+
+    // Renders the given pixel region of the image into the memory pointed to by
+    // bits (the top-left corner of the region).
+    static void renderRegion(uchar *bits, qsizetype bytesPerLine,
+                             const QRect &region, QSize imageSize, const QRectF &sceneRect,
+                             const RenderFunction &render, bool parallel) {
+        std::vector<QRect> tiles;
+        for (int y = region.top(); y <= region.bottom(); y += tileHeight) {
+            for (int x = region.left(); x <= region.right(); x += tileWidth)
+                tiles.emplace_back(x, y,
+                                   std::min(tileWidth, region.right() + 1 - x),
+                                   std::min(tileHeight, region.bottom() + 1 - y));
+        }
+
+        auto renderTile = [&](const QRect &tileRect) {
+            QImage tile(tileRect.size(), QImage::Format_RGB32);
+            tile.fill(Qt::white);
+
+            QPainter painter(&tile);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setRenderHint(QPainter::TextAntialiasing);
+            render(painter, QRectF(QPointF(0, 0), QSizeF(tileRect.size())),
+                   sourceRect(sceneRect, imageSize, tileRect));
+            painter.end();
+
+            // Tiles are disjoint, so they could be blitted concurrently
+            for (int row = 0; row < tileRect.height(); ++row) {
+                auto *dst = reinterpret_cast<QRgb *>(bits + (tileRect.y() - region.y() + row) * bytesPerLine);
+                std::copy_n(reinterpret_cast<const QRgb *>(tile.constScanLine(row)), tileRect.width(),
+                            dst + (tileRect.x() - region.x()));
+            }
+        };
+
+        if (parallel)
+            QtConcurrent::blockingMap(tiles, renderTile);
+        else
+            std::for_each(tiles.begin(), tiles.end(), renderTile);
+    }
+
+    void renderTiled(QImage &image, const QRectF &sceneRect, const RenderFunction &render,
+                     bool parallel) {
+        Q_ASSERT(image.depth() == 32);
+        renderRegion(image.bits(), image.bytesPerLine(), image.rect(), image.size(),
+                     sceneRect, render, parallel);
+    }
+
+    bool saveTiledPng(const QString &fileName, QSize imageSize, const QRectF &sceneRect,
+                      const RenderFunction &render, bool parallel) {
+        int width = imageSize.width(), height = imageSize.height();
+        if (width > maxTiledPngWidth)
+            return false;
+
+        QImage strip(width, std::min(tileHeight, height), QImage::Format_RGB32);
+        if (strip.isNull())
+            return false;
+
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        PngWriter writer(file);
+        if (!writer.begin(imageSize))
+            return false;
+
+        for (int y = 0; y < height; y += tileHeight) {
+            int rows = std::min(tileHeight, height - y);
+            renderRegion(strip.bits(), strip.bytesPerLine(), QRect(0, y, width, rows),
+                         imageSize, sceneRect, render, parallel);
+
+            for (int row = 0; row < rows; ++row) {
+                if (!writer.addRow(reinterpret_cast<const QRgb *>(strip.constScanLine(row))))
+                    return false;
+            }
+        }
+
+        return writer.finish();
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QRectF>
+#include <QSize>
+
+#include <functional>
+
+class QImage;
+class QPainter;
+class QString;
+
+namespace image {
+    // Largest image side QImage / QPainter raster engine can handle
+    constexpr int maxImageSide = 32767;
+    // Widest image saveTiledPng() writes. It keeps one strip of tiles spanning
+    // the image width, which takes 64 MiB at this width.
+    constexpr int maxTiledPngWidth = 1 << 16;
+
+    // Draws the given part of the scene into the target rectangle of the painter
+    using RenderFunction = std::function<void(QPainter &painter, const QRectF &target, const QRectF &source)>;
+
+    // Returns the part of the scene shown in the given pixel rectangle of an
+    // image, when the whole scene is fit into the image keeping the aspect
+    // ratio (the same mapping QGraphicsScene::render uses by default).
+    QRectF sourceRect(const QRectF &sceneRect, QSize imageSize, const QRectF &pixelRect);
+
+    // Renders the whole image tile by tile. If parallel is set, tiles are
+    // rendered concurrently, so the render function must be safe to call from
+    // several threads at once (e.g. GraphRenderer::render). A QGraphicsScene
+    // is never safe to render from several threads. Tiles do not overlap, the
+    // result is byte for byte the same whether they are rendered in parallel
+    // or not. Every tile is painted with its own transform, so antialiasing
+    // could differ slightly from a single render of the whole image.
+    void renderTiled(QImage &image, const QRectF &sceneRect, const RenderFunction &render,
+                     bool parallel = false);
+
+    // Renders the image tile by tile and streams the rows into a PNG file.
+    // Memory usage is bounded by a strip of tiles, so the height is not
+    // limited, but the width is limited to maxTiledPngWidth. Same
+    // requirements for parallel as for renderTiled().
+    bool saveTiledPng(const QString &fileName, QSize imageSize, const QRectF &sceneRect,
+                      const RenderFunction &render, bool parallel = false);
+
+    // Writes the image as SVG, gzip-compressed (.svgz) if compress is set.
+    // Unlike QSvgGenerator, the output is streamed to the file as it is
+    // painted, coordinates are written in image pixels with limited precision
+    // and repeated fill / stroke styles are shared via CSS classes.
+    bool saveSvg(const QString &fileName, QSize imageSize, const QRectF &sceneRect,
+                 const RenderFunction &render, bool compress = false);
+}
@@ -22,6 +22,7 @@
 #include "ui/dialogs/aboutdialog.h"
 #include "ui/dialogs/graphsearchdialog.h"
 #include "bandagegraphicsview.h"
+#include "imageexport.h"
 #include "graphicsviewzoom.h"
 #include "bandagegraphicsscene.h"
 #include "ui/dialogs/myprogressdialog.h"
@@ -53,6 +54,7 @@
 
 #include "program/globals.h"
 #include "program/memory.h"
+#include "program/random.h"
 #include "program/settings.h"
 
 #include <QFileDialog>
@@ -71,15 +73,18 @@
 #include <QDesktopServices>
 #include <QSvgGenerator>
 #include <QCompleter>
+#include <QLabel>
 #include <QStringListModel>
 #include <QtConcurrent>
 #include <QFutureWatcher>
 
+#include <atomic>
 #include <iterator>
 #include <algorithm>
 #include <stdexcept>
 #include <limits>
 #include <cstdlib>
+#include <memory>
 #include <ctime>
 #include <iostream>
 #include <filesystem>
@@ -95,7 +100,10 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     QApplication::setWindowIcon(QIcon(QPixmap(":/icons/icon.png")));
     ui->graphicsViewWidget->layout()->addWidget(g_graphicsView);
 
-    srand(time(nullptr));
+    //The frame time has its own corner of the status bar, so that it does not
+    //replace other status messages.
+    m_frameTimeLabel = new QLabel(this);
+    ui->statusBar->addPermanentWidget(m_frameTimeLabel);
 
     m_previousZoomSpinBoxValue = ui->zoomSpinBox->value();
     ui->zoomSpinBox->setMinimum(g_settings->minZoom * 100.0);
@@ -129,6 +137,9 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     ui->annotationsButton->setContent(ui->annotationsListWidget);
     ui->blastDetailsButton->setContent(ui->blastDetailsWidget);
 
+    //Graph edits made from the GUI could be undone.
+    g_assemblyGraph->setUndoLimit(100);
+
     //If this is a Mac, change the 'Delete' shortcuts to 'Backspace' instead.
 #ifdef Q_OS_MAC
     ui->actionHide_selected_nodes->setShortcut(Qt::Key_Backspace);
@@ -197,8 +208,13 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->nodeWidthSpinBox, SIGNAL(valueChanged(double)), this, SLOT(nodeWidthChanged()));
     connect(g_graphicsView, SIGNAL(copySelectedSequencesToClipboard()), this, SLOT(copySelectedSequencesToClipboard()));
     connect(g_graphicsView, SIGNAL(saveSelectedSequencesToFile()), this, SLOT(saveSelectedSequencesToFile()));
+    connect(g_graphicsView, &BandageGraphicsView::frameTimeMeasured, this, [this](double milliseconds) {
+        m_frameTimeLabel->setText("Mean frame time: " + formatDoubleForDisplay(milliseconds, 1) + " ms");
+    });
     connect(ui->actionSave_entire_graph_to_FASTA, SIGNAL(triggered(bool)), this, SLOT(saveEntireGraphToFasta()));
     connect(ui->actionSave_entire_graph_to_FASTA_only_positive_nodes, SIGNAL(triggered(bool)), this, SLOT(saveEntireGraphToFastaOnlyPositiveNodes()));
+    connect(ui->actionSave_all_paths_to_FASTA, SIGNAL(triggered(bool)), this, SLOT(saveAllPathsToFasta()));
+    connect(ui->actionSave_all_walks_to_FASTA, SIGNAL(triggered(bool)), this, SLOT(saveAllWalksToFasta()));
     connect(ui->actionSave_entire_graph_to_GFA, SIGNAL(triggered(bool)), this, SLOT(saveEntireGraphToGfa()));
     connect(ui->actionSave_visible_graph_to_GFA, SIGNAL(triggered(bool)), this, SLOT(saveVisibleGraphToGfa()));
     connect(ui->actionWeb_BLAST_selected_nodes, SIGNAL(triggered(bool)), this, SLOT(webBlastSelectedNodes()));
@@ -209,6 +225,8 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->actionMerge_all_possible_nodes, SIGNAL(triggered(bool)), this, SLOT(mergeAllPossible()));
     connect(ui->actionChange_node_name, SIGNAL(triggered(bool)), this, SLOT(changeNodeName()));
     connect(ui->actionChange_node_depth, SIGNAL(triggered(bool)), this, SLOT(changeNodeDepth()));
+    connect(ui->actionUndo, SIGNAL(triggered(bool)), this, SLOT(undo()));
+    connect(ui->actionRedo, SIGNAL(triggered(bool)), this, SLOT(redo()));
     connect(ui->moreInfoButton, SIGNAL(clicked(bool)), this, SLOT(openGraphInfoDialog()));
 
     connect(this, SIGNAL(windowLoaded()), this, SLOT(afterMainWindowShow()), Qt::ConnectionType(Qt::QueuedConnection | Qt::UniqueConnection));
@@ -268,6 +286,7 @@ void MainWindow::cleanUp() {
     }
 
     g_assemblyGraph->cleanUp();
+    updateUndoActions();
     setWindowTitle("Bandage-NG");
 
     g_memory->userSpecifiedPath = Path();
@@ -552,10 +571,7 @@ void MainWindow::clearGraphDetails()
 
 void MainWindow::selectionChanged()
 {
-    std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
-    std::vector<DeBruijnEdge *> selectedEdges = m_scene->getSelectedEdges();
-
-    if (selectedNodes.empty())
+    if (m_scene->getSelectedNodeCount() == 0)
     {
         ui->selectedNodesTextEdit->setPlainText("");
         setSelectedNodesWidgetsVisibility(false);
@@ -598,7 +614,8 @@ void MainWindow::selectionChanged()
     }
 
 
-    if (selectedEdges.empty())
+    size_t selectedEdgeCount = m_scene->getSelectedEdgeCount();
+    if (selectedEdgeCount == 0)
     {
         ui->selectedEdgesTextEdit->setPlainText("");
         setSelectedEdgesWidgetsVisibility(false);
@@ -607,10 +624,10 @@ void MainWindow::selectionChanged()
     else //One or more edges selected
     {
         setSelectedEdgesWidgetsVisibility(true);
-        if (selectedEdges.size() == 1)
+        if (selectedEdgeCount == 1)
             ui->selectedEdgesTitleLabel->setText("Selected edge");
         else
-            ui->selectedEdgesTitleLabel->setText("Selected edges (" + formatIntForDisplay(int(selectedEdges.size())) + ")");
+            ui->selectedEdgesTitleLabel->setText("Selected edges (" + formatIntForDisplay(int(selectedEdgeCount)) + ")");
 
         ui->selectedEdgesTextEdit->setPlainText(getSelectedEdgeListText());
     }
@@ -626,8 +643,6 @@ void MainWindow::getSelectedNodeInfo(int & selectedNodeCount, QString & selected
     selectedNodeCount = int(selectedNodes.size());
     selectedNodeCountText = formatIntForDisplay(selectedNodeCount);
 
-    long long totalLength = 0;
-
     for (int i = 0; i < selectedNodeCount; ++i)
     {
         QString nodeName = selectedNodes[i]->getName();
@@ -639,12 +654,10 @@ void MainWindow::getSelectedNodeInfo(int & selectedNodeCount, QString & selected
         selectedNodeListText += nodeName;
         if (i != int(selectedNodes.size()) - 1)
             selectedNodeListText += ", ";
-
-        totalLength += selectedNodes[i]->getLength();
     }
 
-    selectedNodeLengthText = formatIntForDisplay(totalLength) + " bp";
-    selectedNodeDepthText = formatDepthForDisplay(g_assemblyGraph->getMeanDepth(selectedNodes));
+    selectedNodeLengthText = formatIntForDisplay(m_scene->getSelectedNodesTotalLength()) + " bp";
+    selectedNodeDepthText = formatDepthForDisplay(m_scene->getSelectedNodesMeanDepth());
 
     if (selectedNodeCount == 1) {
         // FIXME: Hack!
@@ -1328,13 +1341,12 @@ void MainWindow::saveSelectedPathToFile()
 
 
 void MainWindow::resetAllNodeColours() {
+    std::vector<GraphicsItemNode *> graphicsItemNodes;
     for (auto &entry : g_assemblyGraph->m_deBruijnGraphNodes) {
-        auto *graphicsItemNode = entry->getGraphicsItemNode();
-        if (!graphicsItemNode)
-            continue;
-
-        graphicsItemNode->setNodeColour(g_settings->nodeColorer->get(graphicsItemNode));
+        if (auto *graphicsItemNode = entry->getGraphicsItemNode())
+            graphicsItemNodes.push_back(graphicsItemNode);
     }
+    BandageGraphicsScene::colourGraphicsItemNodes(graphicsItemNodes);
 
     g_graphicsView->viewport()->update();
 }
@@ -1377,14 +1389,21 @@ void MainWindow::switchColourScheme(int idx) {
     } else if (scheme == CSV_COLUMN) {
         ui->tagsComboBox->clear();
         auto *colorer = dynamic_cast<CSVNodeColorer*>(&*g_settings->nodeColorer);
-        ui->tagsComboBox->addItems(g_assemblyGraph->m_csvHeaders);
-        if (!g_assemblyGraph->m_csvHeaders.empty())
+        ui->tagsComboBox->addItems(g_assemblyGraph->m_csvData.headers());
+        if (!g_assemblyGraph->m_csvData.headers().empty())
             colorer->setColumnIdx(0);
         ui->tagsComboBox->setVisible(true);
     } else {
         ui->tagsComboBox->setVisible(false);
     }
 
+    // Choosing random colours again gives a new set of colours (unless the
+    // seed is fixed)
+    if (scheme == RANDOM_COLOURS) {
+        auto *colorer = dynamic_cast<RandomNodeColorer*>(&*g_settings->nodeColorer);
+        colorer->setSeed(rng::seed(true));
+    }
+
     resetAllNodeColours();
 }
 
@@ -1401,14 +1420,37 @@ void MainWindow::determineContiguityFromSelectedNode() {
         return;
     }
 
-    MyProgressDialog progress(this, "Determining contiguity...", false);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.show();
+    //The search is done in a different thread so the UI will stay responsive.
+    auto *progress = new MyProgressDialog(this, "Determining contiguity...", true, "Cancel", "Cancelling...",
+                                          "Clicking this button will stop the contiguity search and display "
+                                          "the nodes checked so far.");
+    progress->setWindowModality(Qt::WindowModal);
+    progress->show();
 
-    for (auto *selectedNode : selectedNodes)
-        colorer->determineContiguity(selectedNode);
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    connect(progress, &MyProgressDialog::halt, this, [cancelled]() { *cancelled = true; });
 
-    resetAllNodeColours();
+    auto *watcher = new QFutureWatcher<ContiguityStatuses>;
+    connect(watcher, &QFutureWatcher<ContiguityStatuses>::finished,
+            this, [=]() {
+                if (auto *colorer = dynamic_cast<ContiguityNodeColorer*>(&*g_settings->nodeColorer)) {
+                    colorer->m_nodeStatuses = watcher->future().result();
+                    resetAllNodeColours();
+                }
+            });
+    connect(watcher, SIGNAL(finished()), progress, SLOT(deleteLater()));
+    connect(watcher, SIGNAL(finished()), watcher, SLOT(deleteLater()));
+
+    unsigned steps = g_settings->contiguitySearchSteps;
+    auto res = QtConcurrent::run([selectedNodes, steps, cancelled]() {
+        ContiguityStatuses statuses;
+        for (const auto *selectedNode : selectedNodes) {
+            if (!contiguity::determine(selectedNode, steps, statuses, cancelled.get()))
+                break;
+        }
+        return statuses;
+    });
+    watcher->setFuture(res);
 }
 
 
@@ -1422,6 +1464,8 @@ QString MainWindow::getDefaultImageFileName()
         fileNameAndPath += ".jpg";
     else if (m_imageFilter == "SVG (*.svg)")
         fileNameAndPath += ".svg";
+    else if (m_imageFilter == "Compressed SVG (*.svgz)")
+        fileNameAndPath += ".svgz";
     else
         fileNameAndPath += ".png";
 
@@ -1493,13 +1537,13 @@ void MainWindow::saveImageEntireScene()
     QString fullFileName = QFileDialog::getSaveFileName(this,
                                                         "Save graph image (entire scene)",
                                                         defaultFileNameAndPath,
-                                                        "PNG (*.png);;JPEG (*.jpg);;SVG (*.svg)",
+                                                        "PNG (*.png);;JPEG (*.jpg);;SVG (*.svg);;Compressed SVG (*.svgz)",
                                                         &selectedFilter);
 
     bool pixelImage = true;
     if (selectedFilter == "PNG (*.png)" || selectedFilter == "JPEG (*.jpg)")
         pixelImage = true;
-    else if (selectedFilter == "SVG (*.svg)")
+    else if (selectedFilter == "SVG (*.svg)" || selectedFilter == "Compressed SVG (*.svgz)")
         pixelImage = false;
 
     if (fullFileName != "") //User did not hit cancel
@@ -1520,18 +1564,30 @@ void MainWindow::saveImageEntireScene()
         {
             QSize imageSize = g_absoluteZoom * m_scene->sceneRect().size().toSize();
 
-            if (imageSize.width() > 32767 || imageSize.height() > 32767)
+            //PNG images that are too large for QImage are rendered in tiles.
+            bool largeImage = imageSize.width() > image::maxImageSide || imageSize.height() > image::maxImageSide;
+            if (largeImage && selectedFilter != "PNG (*.png)")
             {
-                QString error = "Images can not be taller or wider than 32767 pixels, but at the "
+                QString error = "JPEG images can not be taller or wider than 32767 pixels, but at the "
                                 "current zoom level, the image to be saved would be ";
                 error += QString::number(imageSize.width()) + "x" + QString::number(imageSize.height()) + " pixels.\n\n";
+                error += "Please reduce the zoom level before saving the entire scene to image or use the PNG or SVG format.";
+
+                QMessageBox::information(this, "Image too large", error);
+                return;
+            }
+            if (imageSize.width() > image::maxTiledPngWidth)
+            {
+                QString error = "PNG images can not be wider than " + QString::number(image::maxTiledPngWidth) +
+                                " pixels, but at the current zoom level, the image to be saved would be ";
+                error += QString::number(imageSize.width()) + "x" + QString::number(imageSize.height()) + " pixels.\n\n";
                 error += "Please reduce the zoom level before saving the entire scene to image or use the SVG format.";
 
                 QMessageBox::information(this, "Image too large", error);
                 return;
             }
 
-            if (imageSize.width() * imageSize.height() > 50000000) //50 megapixels is used as an arbitrary large image cutoff
+            if (qint64(imageSize.width()) * imageSize.height() > 50000000) //50 megapixels is used as an arbitrary large image cutoff
             {
                 QString warning = "At the current zoom level, the image will be ";
                 warning += QString::number(imageSize.width()) + "x" + QString::number(imageSize.height()) + " pixels. ";
@@ -1543,31 +1599,40 @@ void MainWindow::saveImageEntireScene()
                     return;
             }
 
-            QImage image(imageSize, QImage::Format_ARGB32);
-            image.fill(Qt::white);
-            painter.begin(&image);
-            painter.setRenderHint(QPainter::Antialiasing);
-            painter.setRenderHint(QPainter::TextAntialiasing);
             m_scene->setSceneRectangle();
-            m_scene->render(&painter);
-            image.save(fullFileName);
+            bool saved;
+            if (largeImage)
+            {
+                saved = image::saveTiledPng(fullFileName, imageSize, m_scene->sceneRect(),
+                                            [this](QPainter &tilePainter, const QRectF &target, const QRectF &source) {
+                                                m_scene->render(&tilePainter, target, source, Qt::IgnoreAspectRatio);
+                                            });
+            }
+            else
+            {
+                QImage image(imageSize, QImage::Format_ARGB32);
+                image.fill(Qt::white);
+                painter.begin(&image);
+                painter.setRenderHint(QPainter::Antialiasing);
+                painter.setRenderHint(QPainter::TextAntialiasing);
+                m_scene->render(&painter);
+                painter.end();
+                saved = image.save(fullFileName);
+            }
+            if (!saved)
+                QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the image file.");
             g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-            painter.end();
         }
         else //SVG
         {
-            QSvgGenerator generator;
-            generator.setFileName(fullFileName);
             QSize size = g_absoluteZoom * m_scene->sceneRect().size().toSize();
-            generator.setSize(size);
-            generator.setViewBox(QRect(0, 0, size.width(), size.height()));
-            painter.begin(&generator);
-            painter.fillRect(0, 0, size.width(), size.height(), Qt::white);
-            painter.setRenderHint(QPainter::Antialiasing);
-            painter.setRenderHint(QPainter::TextAntialiasing);
             m_scene->setSceneRectangle();
-            m_scene->render(&painter);
-            painter.end();
+            if (!image::saveSvg(fullFileName, size, m_scene->sceneRect(),
+                                [this](QPainter &svgPainter, const QRectF &target, const QRectF &source) {
+                                    m_scene->render(&svgPainter, target, source, Qt::IgnoreAspectRatio);
+                                },
+                                selectedFilter == "Compressed SVG (*.svgz)"))
+                QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the image file.");
         }
 
         g_settings->positionTextNodeCentre = positionTextNodeCentreSettingBefore;
@@ -1642,11 +1707,14 @@ void MainWindow::setNodeCustomColour() {
     g_settings->initializeColorer(CUSTOM_COLOURS);
     ui->coloursComboBox->setCurrentIndex(g_settings->nodeColorer->scheme());
 
+    g_assemblyGraph->beginEdit("Set custom colour");
     for (auto & selectedNode : selectedNodes) {
         g_assemblyGraph->setCustomColour(selectedNode, newColour);
         if (selectedNode->getGraphicsItemNode() != nullptr)
             selectedNode->getGraphicsItemNode()->setNodeColour(newColour);
     }
+    g_assemblyGraph->endEdit();
+    updateUndoActions();
 
     g_graphicsView->viewport()->update();
 }
@@ -2250,12 +2318,10 @@ void MainWindow::selectNotContiguous()
     selectBasedOnContiguity(NOT_CONTIGUOUS);
 }
 
-void MainWindow::resetNodeContiguityStatus() {
-    auto *colorer = dynamic_cast<ContiguityNodeColorer*>(&*g_settings->nodeColorer);
-    if (!colorer)
-        return;
-
-    colorer->reset();
+// Drops what the colorer derived from the graph (contiguity results, cached
+// tag colours), as it may refer to nodes that are no longer there.
+void MainWindow::resetNodeColorer() {
+    g_settings->nodeColorer->reset();
 }
 
 void MainWindow::selectBasedOnContiguity(ContiguityStatus targetContiguityStatus) {
@@ -2405,26 +2471,64 @@ void MainWindow::nodeWidthChanged()
 void MainWindow::saveEntireGraphToFasta() {
     QString defaultFileNameAndPath = g_memory->rememberedPath + "/all_graph_nodes.fasta";
     QString fullFileName = QFileDialog::getSaveFileName(this, "Save entire graph", defaultFileNameAndPath,
-                                                        "FASTA (*.fasta)");
+                                                        "FASTA (*.fasta);;Compressed FASTA (*.fasta.gz)");
 
     if (fullFileName.isEmpty())
         return; //User did hit cancel
 
     g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-    if (!utils::saveEntireGraphToFasta(fullFileName, *g_assemblyGraph))
+    if (!utils::saveEntireGraphToFasta(fullFileName, *g_assemblyGraph, fullFileName.endsWith(".gz")))
         QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the FASTA file.");
 }
 
 void MainWindow::saveEntireGraphToFastaOnlyPositiveNodes() {
     QString defaultFileNameAndPath = g_memory->rememberedPath + "/all_positive_graph_nodes.fasta";
     QString fullFileName = QFileDialog::getSaveFileName(this, "Save entire graph (only positive nodes)",
-                                                        defaultFileNameAndPath, "FASTA (*.fasta)");
+                                                        defaultFileNameAndPath,
+                                                        "FASTA (*.fasta);;Compressed FASTA (*.fasta.gz)");
 
     if (fullFileName.isEmpty())
         return; //User did hit cancel
 
     g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-    if (!utils::saveEntireGraphToFastaOnlyPositiveNodes(fullFileName, *g_assemblyGraph))
+    if (!utils::saveEntireGraphToFastaOnlyPositiveNodes(fullFileName, *g_assemblyGraph,
+                                                        fullFileName.endsWith(".gz")))
+        QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the FASTA file.");
+}
+
+void MainWindow::saveAllPathsToFasta() {
+    if (g_assemblyGraph->m_deBruijnGraphPaths.empty()) {
+        QMessageBox::information(this, "No paths", "The graph does not contain any paths.");
+        return;
+    }
+
+    QString defaultFileNameAndPath = g_memory->rememberedPath + "/all_paths.fasta";
+    QString fullFileName = QFileDialog::getSaveFileName(this, "Save all paths", defaultFileNameAndPath,
+                                                        "FASTA (*.fasta);;Compressed FASTA (*.fasta.gz)");
+
+    if (fullFileName.isEmpty())
+        return; //User did hit cancel
+
+    g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
+    if (!utils::saveAllPathsToFasta(fullFileName, *g_assemblyGraph, fullFileName.endsWith(".gz")))
+        QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the FASTA file.");
+}
+
+void MainWindow::saveAllWalksToFasta() {
+    if (g_assemblyGraph->m_deBruijnGraphWalks.empty()) {
+        QMessageBox::information(this, "No walks", "The graph does not contain any walks.");
+        return;
+    }
+
+    QString defaultFileNameAndPath = g_memory->rememberedPath + "/all_walks.fasta";
+    QString fullFileName = QFileDialog::getSaveFileName(this, "Save all walks", defaultFileNameAndPath,
+                                                        "FASTA (*.fasta);;Compressed FASTA (*.fasta.gz)");
+
+    if (fullFileName.isEmpty())
+        return; //User did hit cancel
+
+    g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
+    if (!utils::saveAllWalksToFasta(fullFileName, *g_assemblyGraph, fullFileName.endsWith(".gz")))
         QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the FASTA file.");
 }
 
@@ -2438,7 +2542,7 @@ void MainWindow::saveEntireGraphToGfa() {
         return; //User hit cancel
 
     g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-    if (!gfa::saveEntireGraph(fullFileName, *g_assemblyGraph))
+    if (!gfa::saveEntireGraph(fullFileName, *g_assemblyGraph, true))
         QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the graph file.");
 }
 
@@ -2451,7 +2555,7 @@ void MainWindow::saveVisibleGraphToGfa() {
         return; //User hit cancel
 
     g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
-    if (!gfa::saveVisibleGraph(fullFileName, *g_assemblyGraph))
+    if (!gfa::saveVisibleGraph(fullFileName, *g_assemblyGraph, true))
         QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the graph file.");
 }
 
@@ -2524,11 +2628,12 @@ void MainWindow::removeSelection()
     std::vector<DeBruijnEdge *> selectedEdges = m_scene->getSelectedEdges();
     std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
 
-    m_scene->removeGraphicsItemEdges(selectedEdges, true);
-    m_scene->removeGraphicsItemNodes(selectedNodes, true);
-
+    //The graphics items go away together with the nodes and edges.
+    g_assemblyGraph->beginEdit("Remove selection");
     g_assemblyGraph->deleteEdges(selectedEdges);
     g_assemblyGraph->deleteNodes(selectedNodes);
+    g_assemblyGraph->endEdit();
+    updateUndoActions();
 
     g_assemblyGraph->determineGraphInfo();
     displayGraphDetails();
@@ -2537,7 +2642,7 @@ void MainWindow::removeSelection()
     // stuff, as they may no longer apply.
     cleanUpAllBlast();
 
-    resetNodeContiguityStatus();
+    resetNodeColorer();
     resetAllNodeColours();
 }
 
@@ -2563,8 +2668,11 @@ void MainWindow::duplicateSelectedNodes()
             nodesToDuplicate.push_back(node);
     }
 
+    g_assemblyGraph->beginEdit("Duplicate nodes");
     for (auto & i : nodesToDuplicate)
         g_assemblyGraph->duplicateNodePair(i, m_scene);
+    g_assemblyGraph->endEdit();
+    updateUndoActions();
 
     g_assemblyGraph->determineGraphInfo();
     displayGraphDetails();
@@ -2572,7 +2680,7 @@ void MainWindow::duplicateSelectedNodes()
     // Now that the graph has changed, we have to reset BLAST and contiguity
     // stuff, as they may no longer apply.
     cleanUpAllBlast();
-    resetNodeContiguityStatus();
+    resetNodeColorer();
     resetAllNodeColours();
 }
 
@@ -2599,7 +2707,12 @@ void MainWindow::mergeSelectedNodes() {
         return;
     }
 
-    if (!g_assemblyGraph->mergeNodes(nodesToMerge, m_scene)) {
+    g_assemblyGraph->beginEdit("Merge nodes");
+    bool merged = g_assemblyGraph->mergeNodes(nodesToMerge, m_scene);
+    g_assemblyGraph->endEdit();
+    updateUndoActions();
+
+    if (!merged) {
         QMessageBox::information(this, "Nodes cannot be merged", "You can only merge nodes that are in a single, unbranching path with no extra edges.");
         return;
     }
@@ -2610,7 +2723,7 @@ void MainWindow::mergeSelectedNodes() {
     // Now that the graph has changed, we have to reset BLAST and contiguity
     // stuff, as they may no longer apply.
     cleanUpAllBlast();
-    resetNodeContiguityStatus();
+    resetNodeColorer();
     resetAllNodeColours();
 }
 
@@ -2631,7 +2744,10 @@ void MainWindow::mergeAllPossible()
 
 
         g_graphicsView->viewport()->setUpdatesEnabled(false);
+        g_assemblyGraph->beginEdit("Merge all possible nodes");
         merges = g_assemblyGraph->mergeAllPossible(m_scene, &progress);
+        g_assemblyGraph->endEdit();
+        updateUndoActions();
         g_graphicsView->viewport()->setUpdatesEnabled(true);
     }
 
@@ -2643,7 +2759,7 @@ void MainWindow::mergeAllPossible()
         //Now that the graph has changed, we have to reset BLAST and contiguity
         //stuff, as they may no longer apply.
         cleanUpAllBlast();
-        resetNodeContiguityStatus();
+        resetNodeColorer();
         resetAllNodeColours();
     }
     else
@@ -2680,7 +2796,11 @@ void MainWindow::changeNodeName()
 
     if (changeNodeNameDialog.exec()) //The user clicked OK
     {
+        g_assemblyGraph->beginEdit("Change node name");
         g_assemblyGraph->changeNodeName(oldName, changeNodeNameDialog.getNewName());
+        g_assemblyGraph->endEdit();
+        updateUndoActions();
+        m_scene->invalidateSelectionCache();
         selectionChanged();
         cleanUpAllBlast();
     }
@@ -2701,14 +2821,62 @@ void MainWindow::changeNodeDepth()
     if (!changeNodeDepthDialog.exec())
         return;
 
+    g_assemblyGraph->beginEdit("Change node depth");
     g_assemblyGraph->changeNodeDepth(selectedNodes,
                                      changeNodeDepthDialog.getNewDepth());
+    g_assemblyGraph->endEdit();
+    updateUndoActions();
+
+    m_scene->invalidateSelectionCache();
     selectionChanged();
     g_assemblyGraph->recalculateAllNodeWidths(ui->nodeWidthSpinBox->value(),
                                               g_settings->depthPower, g_settings->depthEffectOnWidth);
     g_graphicsView->viewport()->update();
 }
 
+void MainWindow::undo()
+{
+    if (g_assemblyGraph->undo(m_scene))
+        graphEditReverted();
+}
+
+void MainWindow::redo()
+{
+    if (g_assemblyGraph->redo(m_scene))
+        graphEditReverted();
+}
+
+//Brings the UI up to date after an edit was undone or redone.  Only the
+//items of the changed nodes were touched, so the scene is not rebuilt.
+void MainWindow::graphEditReverted()
+{
+    updateUndoActions();
+
+    g_assemblyGraph->recalculateAllNodeWidths(ui->nodeWidthSpinBox->value(),
+                                              g_settings->depthPower, g_settings->depthEffectOnWidth);
+    g_assemblyGraph->determineGraphInfo();
+    displayGraphDetails();
+
+    // The graph has changed, so BLAST and contiguity stuff may no longer apply.
+    cleanUpAllBlast();
+    resetNodeColorer();
+    resetAllNodeColours();
+
+    m_scene->invalidateSelectionCache();
+    selectionChanged();
+    g_graphicsView->viewport()->update();
+}
+
+void MainWindow::updateUndoActions()
+{
+    const EditJournal &journal = g_assemblyGraph->editJournal();
+
+    ui->actionUndo->setEnabled(journal.canUndo());
+    ui->actionUndo->setText(journal.canUndo() ? "Undo " + journal.undoDescription().toLower() : "Undo");
+    ui->actionRedo->setEnabled(journal.canRedo());
+    ui->actionRedo->setText(journal.canRedo() ? "Redo " + journal.redoDescription().toLower() : "Redo");
+}
+
 
 void MainWindow::openGraphInfoDialog()
 {
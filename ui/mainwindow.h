@@ -43,6 +43,7 @@ class BandageGraphicsScene;
 class DeBruijnNode;
 class DeBruijnEdge;
 class GraphSearchDialog;
+class QLabel;
 namespace search {
     class GraphSearch;
 }
@@ -71,6 +72,7 @@ private:
     bool m_drawGraphAfterLoad;
     UiState m_uiState;
     GraphSearchDialog * m_blastSearchDialog;
+    QLabel * m_frameTimeLabel;
 
     bool m_alreadyShown;
 
@@ -107,7 +109,9 @@ private:
 
     static QByteArray makeStringUrlSafe(QByteArray s);
     std::vector<DeBruijnNode *> addComplementaryNodes(std::vector<DeBruijnNode *> nodes);
-    void resetNodeContiguityStatus();
+    void resetNodeColorer();
+    void updateUndoActions();
+    void graphEditReverted();
 
 private slots:
     void loadGraph(QString fullFileName = "");
@@ -172,6 +176,8 @@ private slots:
     void nodeWidthChanged();
     void saveEntireGraphToFasta();
     void saveEntireGraphToFastaOnlyPositiveNodes();
+    void saveAllPathsToFasta();
+    void saveAllWalksToFasta();
     void saveEntireGraphToGfa();
     void saveVisibleGraphToGfa();
     void webBlastSelectedNodes();
@@ -182,6 +188,8 @@ private slots:
     void cleanUpAllBlast();
     void changeNodeName();
     void changeNodeDepth();
+    void undo();
+    void redo();
     void openGraphInfoDialog();
     void exportGraphLayout();
 
@@ -0,0 +1,407 @@
+// Copyright 2024 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "imageexport.h"
+
+#include <QFile>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPainterPath>
+#include <QString>
+
+#include <zlib.h>
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+namespace image {
+    // Buffered writer on top of a gzip stream. Uncompressed files are written
+    // through the same stream in transparent mode.
+    class SvgOutput {
+    public:
+        static constexpr size_t bufferSize = 1 << 20;
+
+        SvgOutput(const QString &fileName, bool compress) {
+            m_file = gzopen(QFile::encodeName(fileName).constData(), compress ? "wb6" : "wbT");
+            if (m_file)
+                gzbuffer(m_file, bufferSize);
+            m_buffer.reserve(bufferSize + 4096);
+        }
+
+        ~SvgOutput() {
+            close();
+        }
+
+        std::string &buffer() { return m_buffer; }
+
+        void maybeFlush() {
+            if (m_buffer.size() >= bufferSize)
+                flush();
+        }
+
+        bool close() {
+            if (!m_file)
+                return false;
+
+            flush();
+            m_ok &= gzclose(m_file) == Z_OK;
+            m_file = nullptr;
+            return m_ok;
+        }
+
+        bool ok() const { return m_file && m_ok; }
+
+    private:
+        void flush() {
+            if (m_file && !m_buffer.empty())
+                m_ok &= gzwrite(m_file, m_buffer.data(), unsigned(m_buffer.size())) == int(m_buffer.size());
+            m_buffer.clear();
+        }
+
+        gzFile m_file = nullptr;
+        bool m_ok = true;
+        std::string m_buffer;
+    };
+
+    // Two decimal places are well below the pixel size, trailing zeros are
+    // dropped
+    static void appendNumber(std::string &out, double value) {
+        double rounded = std::round(value * 100.0) / 100.0;
+        if (rounded == 0.0)
+            rounded = 0.0; // no "-0"
+
+        // Large enough for any finite double in %f. The decimal separator
+        // comes from the C locale, so only the digits around it are used.
+        char buf[DBL_MAX_10_EXP + 16];
+        int len = std::snprintf(buf, sizeof(buf), "%.2f", rounded);
+        if (len < 4)
+            return;
+
+        const char *start = buf, *end = buf + len, *fraction = end - 2;
+        const char *integerEnd = start + (*start == '-');
+        while (integerEnd < fraction && *integerEnd >= '0' && *integerEnd <= '9')
+            ++integerEnd;
+        out.append(start, integerEnd);
+
+        while (end != fraction && end[-1] == '0')
+            --end;
+        if (end != fraction) {
+            out += '.';
+            out.append(fraction, end);
+        }
+    }
+
+    static void appendColour(std::string &out, const QColor &colour) {
+        static const char digits[] = "0123456789abcdef";
+        QRgb rgb = colour.rgb();
+        out += '#';
+        for (int shift : { 20, 16, 12, 8, 4, 0 })
+            out += digits[(rgb >> shift) & 0xf];
+    }
+
+    // Appends the path outline in device coordinates. Line and curve commands
+    // are only written when they change, SVG repeats the previous one
+    // implicitly. Subpaths ending at their start are closed, so the stroke
+    // joins there as it does in Qt.
+    static void appendPathData(std::string &out, const QPainterPath &path, const QTransform &transform) {
+        char lastCommand = 0;
+        auto command = [&](char c) {
+            if (c != lastCommand || c == 'M')
+                out += c;
+            else
+                out += ' ';
+            lastCommand = c;
+        };
+        auto coordinates = [&](const QPainterPath::Element &element) {
+            QPointF p = transform.map(QPointF(element.x, element.y));
+            appendNumber(out, p.x());
+            out += ' ';
+            appendNumber(out, p.y());
+        };
+
+        int count = path.elementCount(), subpathStart = 0;
+        for (int i = 0; i < count; ++i) {
+            const QPainterPath::Element &element = path.elementAt(i);
+            switch (element.type) {
+                case QPainterPath::MoveToElement:
+                    command('M');
+                    subpathStart = i;
+                    break;
+                case QPainterPath::LineToElement:
+                    command('L');
+                    break;
+                case QPainterPath::CurveToElement:
+                    command('C');
+                    break;
+                case QPainterPath::CurveToDataElement:
+                    out += ' ';
+                    break;
+            }
+            coordinates(element);
+
+            bool subpathEnds = i + 1 == count || path.elementAt(i + 1).isMoveTo();
+            if (subpathEnds && i > subpathStart + 1 &&
+                QPointF(element) == QPointF(path.elementAt(subpathStart))) {
+                out += 'Z';
+                lastCommand = 'Z';
+            }
+        }
+    }
+
+    class SvgPaintEngine : public QPaintEngine {
+    public:
+        SvgPaintEngine(SvgOutput &output, QSize size)
+                : QPaintEngine(QPaintEngine::AllFeatures), m_output(output), m_size(size) {}
+
+        bool begin(QPaintDevice *) override {
+            auto &out = m_output.buffer();
+            out += R"(<?xml version="1.0" encoding="UTF-8"?>)" "\n"
+                   R"(<svg xmlns="http://www.w3.org/2000/svg" width=")";
+            out += std::to_string(m_size.width());
+            out += R"(" height=")";
+            out += std::to_string(m_size.height());
+            out += R"(" viewBox="0 0 )";
+            out += std::to_string(m_size.width()) + ' ' + std::to_string(m_size.height());
+            out += "\">\n";
+            return true;
+        }
+
+        // The style sheet is only known at the end. CSS applies to the whole
+        // document regardless of where the <style> element is.
+        bool end() override {
+            auto &out = m_output.buffer();
+            out += "<style>\n";
+            for (const auto &[style, id] : m_styles) {
+                out += ".s" + std::to_string(id) + '{';
+                out += style;
+                out += "}\n";
+                m_output.maybeFlush();
+            }
+            out += "</style>\n</svg>\n";
+            return true;
+        }
+
+        void updateState(const QPaintEngineState &state) override {
+            QPaintEngine::DirtyFlags flags = state.state();
+            if (flags & DirtyPen)
+                m_pen = state.pen();
+            if (flags & DirtyBrush)
+                m_brush = state.brush();
+            if (flags & DirtyTransform)
+                m_transform = state.transform();
+            if (flags & DirtyOpacity)
+                m_opacity = state.opacity();
+            if (flags & (DirtyClipPath | DirtyClipRegion | DirtyClipEnabled))
+                updateClip();
+        }
+
+        void drawPath(const QPainterPath &path) override {
+            writePath(path, m_brush.style() != Qt::NoBrush);
+        }
+
+        void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode) override {
+            if (pointCount == 0)
+                return;
+
+            QPainterPath path(points[0]);
+            for (int i = 1; i < pointCount; ++i)
+                path.lineTo(points[i]);
+            if (mode != PolylineMode)
+                path.closeSubpath();
+            path.setFillRule(mode == OddEvenMode ? Qt::OddEvenFill : Qt::WindingFill);
+
+            writePath(path, mode != PolylineMode && m_brush.style() != Qt::NoBrush);
+        }
+
+        // Images are never drawn by the graph items
+        void drawPixmap(const QRectF &, const QPixmap &, const QRectF &) override {}
+
+        Type type() const override { return QPaintEngine::User; }
+
+    private:
+        void updateClip() {
+            m_clipId = -1;
+            if (!painter()->hasClipping())
+                return;
+
+            QPainterPath clip = painter()->combinedTransform().map(painter()->clipPath());
+            // A clip covering the whole image (e.g. the target rectangle) is a no-op
+            if (clip.contains(QRectF(QPointF(0, 0), QSizeF(m_size))))
+                return;
+
+            m_clipId = m_clipCount++;
+            auto &out = m_output.buffer();
+            out += R"(<clipPath id="c)" + std::to_string(m_clipId) + R"("><path d=")";
+            appendPathData(out, clip, QTransform());
+            out += "\"/></clipPath>\n";
+        }
+
+        unsigned styleId(bool fill, Qt::FillRule fillRule) {
+            std::string style;
+            if (fill) {
+                QColor colour = m_brush.color();
+                style += "fill:";
+                appendColour(style, colour);
+                if (double alpha = colour.alphaF() * m_opacity; alpha < 1.0) {
+                    style += ";fill-opacity:";
+                    appendNumber(style, alpha);
+                }
+                if (fillRule == Qt::OddEvenFill)
+                    style += ";fill-rule:evenodd";
+            } else
+                style += "fill:none";
+
+            if (m_pen.style() != Qt::NoPen) {
+                QColor colour = m_pen.color();
+                style += ";stroke:";
+                appendColour(style, colour);
+                if (double alpha = colour.alphaF() * m_opacity; alpha < 1.0) {
+                    style += ";stroke-opacity:";
+                    appendNumber(style, alpha);
+                }
+
+                // Coordinates are written in device space, so the pen width
+                // needs to be transformed as well
+                double width = m_pen.widthF();
+                if (m_pen.isCosmetic())
+                    width = std::max(width, 1.0);
+                else
+                    width *= std::sqrt(std::abs(m_transform.determinant()));
+                style += ";stroke-width:";
+                appendNumber(style, width);
+
+                switch (m_pen.capStyle()) {
+                    case Qt::SquareCap: style += ";stroke-linecap:square"; break;
+                    case Qt::RoundCap: style += ";stroke-linecap:round"; break;
+                    default: break;
+                }
+                switch (m_pen.joinStyle()) {
+                    case Qt::RoundJoin: style += ";stroke-linejoin:round"; break;
+                    case Qt::BevelJoin: style += ";stroke-linejoin:bevel"; break;
+                    default:
+                        style += ";stroke-miterlimit:";
+                        appendNumber(style, m_pen.miterLimit());
+                        break;
+                }
+
+                if (m_pen.style() != Qt::SolidLine) {
+                    style += ";stroke-dasharray:";
+                    bool first = true;
+                    for (double dash : m_pen.dashPattern()) {
+                        if (!first)
+                            style += ' ';
+                        appendNumber(style, dash * std::max(width, 1.0));
+                        first = false;
+                    }
+                }
+            }
+
+            return m_styles.try_emplace(std::move(style), unsigned(m_styles.size())).first->second;
+        }
+
+        void writePath(const QPainterPath &path, bool fill) {
+            if (path.isEmpty() || (!fill && m_pen.style() == Qt::NoPen))
+                return;
+
+            auto &out = m_output.buffer();
+            out += R"(<path class="s)";
+            out += std::to_string(styleId(fill, path.fillRule()));
+            if (m_clipId >= 0) {
+                out += R"(" clip-path="url(#c)";
+                out += std::to_string(m_clipId);
+                out += ')';
+            }
+            out += R"(" d=")";
+            appendPathData(out, path, m_transform);
+            out += "\"/>\n";
+
+            m_output.maybeFlush();
+        }
+
+        SvgOutput &m_output;
+        QSize m_size;
+        QPen m_pen;
+        QBrush m_brush;
+        QTransform m_transform;
+        double m_opacity = 1.0;
+        int m_clipId = -1;
+        int m_clipCount = 0;
+        std::unordered_map<std::string, unsigned> m_styles;
+    };
+
+    class SvgPaintDevice : public QPaintDevice {
+    public:
+        SvgPaintDevice(SvgOutput &output, QSize size)
+                : m_engine(output, size), m_size(size) {}
+
+        QPaintEngine *paintEngine() const override { return &m_engine; }
+
+    protected:
+        // Same resolution QSvgGenerator uses by default, so the label sizes
+        // do not change
+        int metric(PaintDeviceMetric metric) const override {
+            static constexpr int resolution = 72;
+            switch (metric) {
+                case PdmWidth: return m_size.width();
+                case PdmHeight: return m_size.height();
+                case PdmWidthMM: return qRound(m_size.width() * 25.4 / resolution);
+                case PdmHeightMM: return qRound(m_size.height() * 25.4 / resolution);
+                case PdmNumColors: return INT_MAX;
+                case PdmDepth: return 32;
+                case PdmDpiX:
+                case PdmDpiY:
+                case PdmPhysicalDpiX:
+                case PdmPhysicalDpiY: return resolution;
+                case PdmDevicePixelRatio: return 1;
+                case PdmDevicePixelRatioScaled: return int(devicePixelRatioFScale());
+                default: return 0;
+            }
+        }
+
+    private:
+        mutable SvgPaintEngine m_engine;
+        QSize m_size;
+    };
+
+    bool saveSvg(const QString &fileName, QSize imageSize, const QRectF &sceneRect,
+                 const RenderFunction &render, bool compress) {
+        SvgOutput output(fileName, compress);
+        if (!output.ok())
+            return false;
+
+        {
+            SvgPaintDevice device(output, imageSize);
+            QPainter painter;
+            if (!painter.begin(&device))
+                return false;
+
+            QRectF target(QPointF(0, 0), QSizeF(imageSize));
+            painter.fillRect(target, Qt::white);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setRenderHint(QPainter::TextAntialiasing);
+            render(painter, target, sourceRect(sceneRect, imageSize, target));
+            painter.end();
+        }
+
+        return output.close();
+    }
+}